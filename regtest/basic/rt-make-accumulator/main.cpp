@@ -0,0 +1,128 @@
+#include "mpi.h"
+#include "plumed/tools/Accumulator.h"
+#include "plumed/tools/Communicator.h"
+#include "plumed/tools/Tools.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace PLMD;
+
+// Checks the weighted means and variances of Accumulator against a two pass calculation,
+// that the result does not depend on how the samples are split among accumulators,
+// that the state can be saved and restored, and that very large log-weights do not overflow.
+
+// sample i: two quantities and a log-weight
+void sample(unsigned i,double*x,double& lw) {
+  x[0]=1000.0+std::sin(0.37*i);
+  x[1]=std::cos(1.1*i)*i*0.01;
+  lw=3.0*std::sin(0.13*i);
+}
+
+void dump(std::ostream&ofs,const char*name,const Accumulator& acc) {
+  char buf[400];
+  std::sprintf(buf,"%s %llu %14.8f %14.6f %16.10f %12.8f %12.8f %14.8f\n",name,acc.getNumberOfSamples(),
+               acc.getLogSumWeights(),acc.getEffectiveSampleSize(),
+               acc.getMean(0),acc.getVariance(0),acc.getMean(1),acc.getVariance(1));
+  ofs<<buf;
+}
+
+void run(Communicator& comm) {
+  std::string ff;
+  Tools::convert(comm.Get_rank(),ff);
+  ff="output"+ff;
+  std::ofstream ofs(ff.c_str());
+
+  const unsigned n=10000;
+  double x[2],lw;
+
+// two pass reference
+  double sw=0.0,sw2=0.0,m[2]= {0.0,0.0},v[2]= {0.0,0.0};
+  for(unsigned i=0; i<n; i++) {
+    sample(i,x,lw);
+    double w=std::exp(lw);
+    sw+=w; sw2+=w*w;
+    for(unsigned j=0; j<2; j++) m[j]+=w*x[j];
+  }
+  for(unsigned j=0; j<2; j++) m[j]/=sw;
+  for(unsigned i=0; i<n; i++) {
+    sample(i,x,lw);
+    double w=std::exp(lw);
+    for(unsigned j=0; j<2; j++) v[j]+=w*(x[j]-m[j])*(x[j]-m[j]);
+  }
+  for(unsigned j=0; j<2; j++) v[j]/=sw;
+  char buf[400];
+  std::sprintf(buf,"%s %u %14.8f %14.6f %16.10f %12.8f %12.8f %14.8f\n","twopass",n,
+               std::log(sw),sw*sw/sw2,m[0],v[0],m[1],v[1]);
+  ofs<<buf;
+
+// streaming
+  Accumulator all(2);
+  for(unsigned i=0; i<n; i++) {
+    sample(i,x,lw);
+    all.add(x,lw);
+  }
+  dump(ofs,"stream",all);
+
+// the same samples split in blocks and merged
+  Accumulator merged(2);
+  for(unsigned b=0; b<7; b++) {
+    Accumulator block(2);
+    for(unsigned i=b; i<n; i+=7) {
+      sample(i,x,lw);
+      block.add(x,lw);
+    }
+    merged.merge(block);
+  }
+  dump(ofs,"merged",merged);
+
+// the same samples split among the processes
+  Accumulator local(2);
+  for(unsigned i=comm.Get_rank(); i<n; i+=comm.Get_size()) {
+    sample(i,x,lw);
+    local.add(x,lw);
+  }
+  local.mergeOverComm(comm);
+  dump(ofs,"mpi",local);
+
+// save and restore half way
+  Accumulator first(2),second(2);
+  for(unsigned i=0; i<n/2; i++) {
+    sample(i,x,lw);
+    first.add(x,lw);
+  }
+  std::vector<double> state;
+  first.getState(state);
+  second.setState(state);
+  for(unsigned i=n/2; i<n; i++) {
+    sample(i,x,lw);
+    second.add(x,lw);
+  }
+  dump(ofs,"restart",second);
+
+// shifting all the log-weights by a large constant only changes the sum of the weights
+  Accumulator shifted(2);
+  for(unsigned i=0; i<n; i++) {
+    sample(i,x,lw);
+    shifted.add(x,lw+2000.0);
+  }
+  dump(ofs,"shifted",shifted);
+
+  shifted.clear();
+  dump(ofs,"clear",shifted);
+}
+
+int main(int argc,char**argv) {
+  MPI_Init(&argc,&argv);
+  {
+    MPI_Comm c;
+    MPI_Comm_dup(MPI_COMM_WORLD,&c);
+    Communicator comm;
+    comm.Set_comm(&c);
+    run(comm);
+  }
+  MPI_Finalize();
+  return 0;
+}
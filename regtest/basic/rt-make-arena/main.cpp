@@ -0,0 +1,86 @@
+#include "plumed/tools/Arena.h"
+#include "plumed/tools/Vector.h"
+#include "plumed/core/PlumedMain.h"
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <vector>
+
+using namespace PLMD;
+
+// Checks that Arena returns aligned memory, that its blocks are merged when it is reset,
+// and that after the first step the temporaries do not need any heap allocation.
+// Heap allocations are counted replacing the global operator new in this executable.
+// Finally, it checks that the arenas owned by PlumedMain do not allocate memory
+// after the first step of a calculation using COORDINATION.
+
+static unsigned long long heapCount=0;
+
+void* operator new(std::size_t size) {
+  heapCount++;
+  void* p=std::malloc(size?size:1);
+  if(!p) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+// a step that builds several temporaries of different types and sizes
+void step(Arena& arena,unsigned n,double& sum) {
+  ArenaVector<Vector> v(n,Vector(1,2,3),ArenaAllocator<Vector>(arena));
+  ArenaVector<double> d{ArenaAllocator<double>(arena)};
+  for(unsigned i=0; i<n; i++) d.push_back(v[i][1]*i);
+  ArenaVector<char> c(7,'a',ArenaAllocator<char>(arena));
+  ArenaVector<long double> l(3*n,1.0,ArenaAllocator<long double>(arena));
+  if(reinterpret_cast<std::uintptr_t>(l.data())%alignof(long double)!=0) sum=-1e10;
+  for(unsigned i=0; i<n; i++) sum+=d[i]+l[i]+c[i%7];
+}
+
+int main() {
+  std::ofstream out("output");
+
+  Arena arena(1024);
+  out<<"initial capacity "<<arena.getCapacity()<<" allocations "<<arena.getHeapAllocations()<<"\n";
+
+  double sum=0.0;
+  for(unsigned istep=0; istep<5; istep++) {
+    arena.reset();
+    unsigned long long before=heapCount;
+    step(arena,1000,sum);
+    out<<"step "<<istep<<" capacity "<<arena.getCapacity()
+       <<" arena allocations "<<arena.getHeapAllocations()
+       <<" heap allocations in step "<<heapCount-before<<"\n";
+  }
+  out<<"sum "<<sum<<"\n";
+
+  PlumedMain p;
+  int natoms=100;
+  double timestep=0.002;
+  p.cmd("setNatoms",&natoms);
+  p.cmd("setTimestep",&timestep);
+  p.cmd("setLogFile","test.log");
+  p.cmd("init");
+  p.readInputLine("c: COORDINATION GROUPA=1-50 GROUPB=51-100 R_0=0.3");
+  p.readInputLine("RESTRAINT ARG=c AT=0 KAPPA=1");
+
+  std::vector<double> positions(3*natoms),masses(natoms,1.0),forces(3*natoms),box(9,0.0),virial(9,0.0);
+  box[0]=box[4]=box[8]=2.0;
+  for(int i=0; i<3*natoms; i++) positions[i]=2.0*((i*7919)%1000)/1000.0;
+  std::vector<unsigned long long> count;
+  for(int istep=0; istep<5; istep++) {
+    for(int i=0; i<3*natoms; i++) positions[i]+=0.001*((i+istep)%5-2);
+    p.cmd("setStep",&istep);
+    p.cmd("setPositions",&positions[0]);
+    p.cmd("setMasses",&masses[0]);
+    p.cmd("setForces",&forces[0]);
+    p.cmd("setBox",&box[0]);
+    p.cmd("setVirial",&virial[0]);
+    p.cmd("calc");
+    count.push_back(p.getArena().getHeapAllocations());
+  }
+  for(unsigned i=1; i<count.size(); i++) out<<"plumed step "<<i<<" new arena allocations "<<count[i]-count[i-1]<<"\n";
+  return 0;
+}
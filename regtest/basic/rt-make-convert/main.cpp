@@ -0,0 +1,55 @@
+#include "plumed/tools/Tools.h"
+#include "plumed/tools/OFile.h"
+#include <vector>
+
+using namespace PLMD;
+
+// Checks Tools::convert on a list of strings covering the plain numeric
+// forms, the PI constants, lepton expressions and invalid input.
+// The time taken to parse large files is measured by the file-parsing
+// input in test/benchmarks.
+
+template<class T>
+void check(OFile & out,const std::string & type,const std::string & str) {
+  T t=0;
+  bool ok=Tools::convert(str,t);
+  out<<type<<" \""<<str<<"\" ";
+  if(ok) out<<t<<"\n";
+  else out<<"fail\n";
+}
+
+void checkReal(OFile & out,const std::string & str) {
+  double d=0; float f=0; long double l=0;
+  bool okd=Tools::convert(str,d);
+  bool okf=Tools::convert(str,f);
+  bool okl=Tools::convert(str,l);
+  out<<"real \""<<str<<"\" ";
+  if(okd) out.printf("%a ",d); else out<<"fail ";
+  if(okf) out.printf("%a ",f); else out<<"fail ";
+  if(okl) out.printf("%a\n",static_cast<double>(l)); else out<<"fail\n";
+}
+
+int main () {
+
+  std::vector<std::string> reals= {
+    "1", "  1.5 ", "-2.5e-3", "+.5", "5.", "1E+3", "007", "-0", "0.1", "3.141592653589793238462643383279",
+    "1.7976931348623157e308", "4.9406564584124654e-324", "1e400", "1e-400", "1e40", "1e-40",
+    ".", "e5", "1e", "1e+", "1.5abc", "1,5", "1d0", "0x10", "inf", "nan", "NAN", "12 3", "", "  ", "+", "-.e1",
+    "pi", "PI", "+pi", "-PI", "-pi", "2pi", "2PI", "0.5 pi", "-1.5PI", "pix", "2*pi", "pi/2", "exp(1)", "sqrt2", "1+1", "(3)"
+  };
+  std::vector<std::string> ints= {
+    "1", " 42 ", "+7", "-7", "007", "2147483647", "2147483648", "-2147483648", "-2147483649", "4294967295", "4294967296",
+    "9223372036854775807", "9223372036854775808", "-1", "1.0", "1e5", "12 3", "", "0x10", "-", "+-1"
+  };
+
+  OFile out; out.open("output");
+  for(const auto & s : reals) checkReal(out,s);
+  for(const auto & s : ints) {
+    check<int>(out,"int",s);
+    check<long int>(out,"long",s);
+    check<unsigned>(out,"unsigned",s);
+  }
+  out.close();
+
+  return 0;
+}
@@ -0,0 +1,79 @@
+#include "mpi.h"
+#include "plumed/tools/Communicator.h"
+#include "plumed/tools/Tools.h"
+#include <fstream>
+#include <string>
+#include "plumed/tools/Vector.h"
+
+using namespace PLMD;
+
+template<typename T>
+void reset(Communicator& comm,std::vector<T> & v){
+  for(unsigned i=0;i<v.size();i++) v[i]=(i+1)*(comm.Get_rank()+1);
+}
+
+template<typename T>
+void dump(Communicator& comm,std::ostream&ofs,const std::vector<T> & v){
+  for(unsigned i=0;i<v.size();i++) ofs<<" "<<v[i]; ofs<<"\n";
+}
+
+void run(Communicator& comm){
+  std::string ff;
+  Tools::convert(comm.Get_rank(),ff);
+  ff="output"+ff;
+  std::ofstream ofs(ff.c_str());
+
+  std::vector<int> a(4*comm.Get_size());
+  std::vector<double> b(3);
+  std::vector<int> c(2);
+  std::vector<int> empty;
+  double d;
+  Vector v;
+
+// reference with the usual blocking sums
+  reset(comm,a); reset(comm,b); reset(comm,c);
+  d=0.5*(comm.Get_rank()+1);
+  v=Vector(comm.Get_rank(),2*comm.Get_rank(),3*comm.Get_rank());
+  comm.Sum(a); comm.Sum(b); comm.Sum(c); comm.Sum(d); comm.Sum(v);
+  dump(comm,ofs,a); dump(comm,ofs,b); dump(comm,ofs,c);
+  ofs<<d<<" "<<v<<"\n";
+
+// same sums coalesced, with types interleaved
+  reset(comm,a); reset(comm,b); reset(comm,c);
+  d=0.5*(comm.Get_rank()+1);
+  v=Vector(comm.Get_rank(),2*comm.Get_rank(),3*comm.Get_rank());
+  comm.DeferSum(a); comm.DeferSum(b); comm.DeferSum(empty); comm.DeferSum(c); comm.DeferSum(d); comm.DeferSum(v);
+  ofs<<"deferred "<<comm.getNumberOfDeferred()<<"\n";
+  comm.SumDeferred();
+  ofs<<"deferred "<<comm.getNumberOfDeferred()<<"\n";
+  dump(comm,ofs,a); dump(comm,ofs,b); dump(comm,ofs,c);
+  ofs<<d<<" "<<v<<"\n";
+
+// same sums, non blocking
+  reset(comm,a); reset(comm,b); reset(comm,c);
+  d=0.5*(comm.Get_rank()+1);
+  v=Vector(comm.Get_rank(),2*comm.Get_rank(),3*comm.Get_rank());
+  comm.DeferSum(&a[0],a.size()); comm.DeferSum(&b[0],b.size()); comm.DeferSum(&c[0],c.size()); comm.DeferSum(d); comm.DeferSum(v);
+  comm.IsumDeferred();
+  comm.WaitDeferred();
+  ofs<<"deferred "<<comm.getNumberOfDeferred()<<"\n";
+  dump(comm,ofs,a); dump(comm,ofs,b); dump(comm,ofs,c);
+  ofs<<d<<" "<<v<<"\n";
+
+// waiting with nothing in progress does nothing
+  comm.WaitDeferred();
+  comm.SumDeferred();
+  ofs<<"deferred "<<comm.getNumberOfDeferred()<<"\n";
+}
+
+int main(int argc,char**argv){
+  MPI_Init(&argc,&argv);
+  {
+    MPI_Comm c;
+    MPI_Comm_dup(MPI_COMM_WORLD,&c);
+    PLMD::Communicator comm;
+    comm.Set_comm(&c);
+    run(comm);
+  }
+  MPI_Finalize();
+}
@@ -0,0 +1,89 @@
+#include "mpi.h"
+#include "plumed/wrapper/Plumed.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace PLMD;
+
+// Hamiltonian replica exchange between two replicas that only differ in the biases.
+// The energy differences computed by exchanging the positions and by exchanging the
+// values of the colvars should be identical.
+
+void init(Plumed& p,MPI_Comm& world,MPI_Comm& self,int natoms,const std::string& log,int exchangeColvars) {
+  p.cmd("setMPIComm",&self);
+  p.cmd("GREX setMPIIntracomm",&self);
+  p.cmd("GREX setMPIIntercomm",&world);
+  p.cmd("GREX init");
+  p.cmd("GREX setExchangeColvars",&exchangeColvars);
+  p.cmd("setNatoms",&natoms);
+  p.cmd("setLogFile",log.c_str());
+  p.cmd("setPlumedDat","plumed.dat");
+  p.cmd("init");
+}
+
+void step(Plumed& p,int istep,std::vector<double>& positions,std::vector<double>& masses,std::vector<double>& box) {
+  std::vector<double> forces(positions.size(),0.0);
+  std::vector<double> virial(9,0.0);
+  p.cmd("setStep",&istep);
+  p.cmd("setPositions",&positions[0]);
+  p.cmd("setMasses",&masses[0]);
+  p.cmd("setBox",&box[0]);
+  p.cmd("setForces",&forces[0]);
+  p.cmd("setVirial",&virial[0]);
+  p.cmd("calc");
+}
+
+void exchange(Plumed& p,int partner,double& d0,double& d1) {
+  p.cmd("GREX savePositions");
+  p.cmd("GREX setPartner",&partner);
+  p.cmd("GREX calculate");
+  p.cmd("GREX shareAllDeltaBias");
+  p.cmd("GREX getDeltaBias 0",&d0);
+  p.cmd("GREX getDeltaBias 1",&d1);
+}
+
+int main(int argc,char**argv) {
+  MPI_Init(&argc,&argv);
+  MPI_Comm world=MPI_COMM_WORLD;
+  MPI_Comm self=MPI_COMM_SELF;
+  int rank;
+  MPI_Comm_rank(world,&rank);
+
+  int natoms=4;
+  std::vector<double> positions(3*natoms);
+  std::vector<double> masses(natoms,1.0);
+  for(int i=0; i<natoms; i++) masses[i]=1.0+i;
+  std::vector<double> box(9,0.0);
+  box[0]=box[4]=box[8]=3.0;
+
+  std::ostringstream suffix;
+  suffix<<rank;
+
+  {
+    Plumed pos,cvs;
+    init(pos,world,self,natoms,"test-positions."+suffix.str()+".log",0);
+    init(cvs,world,self,natoms,"test-colvars."+suffix.str()+".log",1);
+
+    std::ofstream ofs(("output"+suffix.str()).c_str());
+
+    for(int istep=0; istep<10; istep++) {
+      for(int i=0; i<3*natoms; i++) positions[i]=0.4*i+0.3*std::sin(0.7*istep+1.3*i+2.1*rank);
+      step(pos,istep,positions,masses,box);
+      step(cvs,istep,positions,masses,box);
+      if(istep%3!=0) continue;
+      double p0,p1,c0,c1;
+      exchange(pos,1-rank,p0,p1);
+      exchange(cvs,1-rank,c0,c1);
+      char buf[200];
+      std::sprintf(buf,"%d %12.8f %12.8f %12.8f %12.8f\n",istep,p0,p1,c0,c1);
+      ofs<<buf;
+    }
+    ofs.close();
+  }
+  MPI_Finalize();
+  return 0;
+}
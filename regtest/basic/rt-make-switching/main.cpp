@@ -0,0 +1,45 @@
+#include "plumed/tools/SwitchingFunction.h"
+#include "plumed/tools/OFile.h"
+#include <cmath>
+#include <vector>
+
+using namespace PLMD;
+
+int main () {
+
+  std::vector<std::string> defs;
+  defs.push_back("RATIONAL R_0=0.5");
+  defs.push_back("RATIONAL R_0=0.5 NN=8 MM=12");
+  defs.push_back("RATIONAL R_0=0.5 NN=5 MM=10 D_MAX=1.5");
+  defs.push_back("RATIONAL R_0=0.5 D_0=0.2 D_MAX=1.2");
+  defs.push_back("EXP R_0=0.5 D_0=0.1 D_MAX=1.5");
+  defs.push_back("GAUSSIAN R_0=0.3 D_0=0.2 D_MAX=1.5");
+  defs.push_back("SMAP R_0=0.5 A=8 B=4 D_MAX=1.5");
+  defs.push_back("CUBIC D_0=0.3 D_MAX=1.2");
+  defs.push_back("TANH R_0=0.4 D_MAX=1.5");
+
+  // Squared distances spanning the region below d_0 and beyond d_max
+  std::vector<double> d2;
+  for(unsigned i=0; i<200; ++i) { double d=0.01+0.01*i; d2.push_back(d*d); }
+  // Include the point where the rational function is computed with the limit
+  d2.push_back(0.25);
+
+  OFile out; out.open("output");
+  for(unsigned i=0; i<defs.size(); ++i) {
+    SwitchingFunction sf; std::string errors; sf.set(defs[i],errors);
+    if( errors.length()>0 ) { out<<"error "<<errors<<"\n"; continue; }
+    std::vector<double> result( d2.size() ), dfunc( d2.size() );
+    sf.calculateSqr( d2.data(), d2.size(), result.data(), dfunc.data() );
+    double maxdiff=0, sum=0;
+    for(unsigned j=0; j<d2.size(); ++j) {
+      double df, res=sf.calculateSqr( d2[j], df );
+      maxdiff=std::max( maxdiff, std::fabs(res-result[j]) );
+      maxdiff=std::max( maxdiff, std::fabs(df-dfunc[j]) );
+      sum+=result[j];
+    }
+    out.printf("%-40s sum %10.6f maxdiff %g\n", defs[i].c_str(), sum, maxdiff );
+  }
+  out.close();
+
+  return 0;
+}
@@ -0,0 +1,102 @@
+#include "plumed/core/PlumedMain.h"
+#include "plumed/core/Atoms.h"
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace PLMD;
+
+// Checks that reading positions and adding forces directly in the arrays
+// of the MD code gives the same forces, virial and bias as the usual path where
+// they are copied, that it is only used when the MD code asks for it,
+// and that it is switched off when it cannot be used.
+
+struct Result {
+  std::vector<double> forces;
+  std::vector<double> virial;
+  double bias;
+  bool zeroCopy;
+};
+
+// zeroCopy<0 means that the MD code does not say anything, so the default is used
+Result run(const std::vector<std::string> & input,int zeroCopy) {
+  PlumedMain p;
+  int natoms=20;
+  double timestep=0.002;
+  p.cmd("setNatoms",&natoms);
+  p.cmd("setTimestep",&timestep);
+  p.cmd("setLogFile","test.log");
+  if(zeroCopy>=0) p.cmd("setZeroCopy",&zeroCopy);
+  p.cmd("init");
+  for(const auto & l : input) p.readInputLine(l);
+
+  std::vector<double> positions(3*natoms),masses(natoms),forces(3*natoms),box(9,0.0),virial(9,0.0);
+  for(int i=0; i<natoms; i++) masses[i]=1.0+i%3;
+  box[0]=box[4]=box[8]=2.0;
+  for(int i=0; i<3*natoms; i++) positions[i]=2.0*((i*7919)%1000)/1000.0;
+  Result r;
+  r.bias=0.0;
+  r.zeroCopy=true;
+  for(int istep=0; istep<4; istep++) {
+    for(int i=0; i<3*natoms; i++) positions[i]+=0.01*((i+istep)%5-2);
+    for(int i=0; i<3*natoms; i++) forces[i]=0.1*(i%7);
+    for(int i=0; i<9; i++) virial[i]=0.0;
+    p.cmd("setStep",&istep);
+    p.cmd("setPositions",&positions[0]);
+    p.cmd("setMasses",&masses[0]);
+    p.cmd("setForces",&forces[0]);
+    p.cmd("setBox",&box[0]);
+    p.cmd("setVirial",&virial[0]);
+    p.cmd("calc");
+    double bias;
+    p.cmd("getBias",&bias);
+    r.bias+=bias;
+    r.zeroCopy=r.zeroCopy && p.getAtoms().isZeroCopy();
+    r.forces.insert(r.forces.end(),forces.begin(),forces.end());
+    r.virial.insert(r.virial.end(),virial.begin(),virial.end());
+  }
+  return r;
+}
+
+double maxdiff(const std::vector<double> & a,const std::vector<double> & b) {
+  double d=0.0;
+  for(unsigned i=0; i<a.size(); i++) d=std::max(d,std::fabs(a[i]-b[i]));
+  return d;
+}
+
+void compare(std::ofstream & out,const std::string & name,const std::vector<std::string> & input) {
+  Result direct=run(input,1);
+  Result copy=run(input,0);
+  Result byDefault=run(input,-1);
+  out<<name<<"\n";
+  out<<"  zero copy used: "<<direct.zeroCopy<<" "<<copy.zeroCopy<<" "<<byDefault.zeroCopy<<"\n";
+// forces on the same atom from different actions are summed in a different order
+  out<<"  same bias: "<<(std::fabs(direct.bias-copy.bias)<1e-10)<<"\n";
+  out<<"  same forces: "<<(maxdiff(direct.forces,copy.forces)<1e-10)<<"\n";
+  out<<"  same virial: "<<(maxdiff(direct.virial,copy.virial)<1e-10)<<"\n";
+  out<<"  same forces by default: "<<(maxdiff(byDefault.forces,copy.forces)==0.0)<<"\n";
+}
+
+int main() {
+  std::ofstream out("output");
+  compare(out,"distances and virtual atoms", {
+    "d: DISTANCE ATOMS=1,5",
+    "c: COM ATOMS=2-10",
+    "g: CENTER ATOMS=11-20",
+    "t: TORSION ATOMS=c,g,3,4",
+    "e: DISTANCE ATOMS=c,20",
+    "RESTRAINT ARG=d,t,e AT=0.5,1.0,0.3 KAPPA=10,10,10"
+  });
+  compare(out,"modified positions", {
+    "WHOLEMOLECULES ENTITY0=1-10",
+    "d: DISTANCE ATOMS=1,10",
+    "RESTRAINT ARG=d AT=0.5 KAPPA=10"
+  });
+  compare(out,"global forces", {
+    "d: DISTANCE ATOMS=1,10",
+    "RESTRAINT ARG=d AT=0.5 KAPPA=10",
+    "FIT_TO_TEMPLATE STRIDE=1 REFERENCE=ref.pdb TYPE=OPTIMAL"
+  });
+  return 0;
+}
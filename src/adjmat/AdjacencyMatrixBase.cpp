@@ -31,7 +31,7 @@ namespace adjmat {
 
 void AdjacencyMatrixBase::registerKeywords( Keywords& keys ) {
   multicolvar::MultiColvarBase::registerKeywords( keys );
-  keys.remove("LOWMEM"); keys.use("HIGHMEM");
+  keys.remove("LOWMEM"); keys.use("HIGHMEM"); keys.use("NL_SKIN");
 }
 
 AdjacencyMatrixBase::AdjacencyMatrixBase(const ActionOptions& ao):
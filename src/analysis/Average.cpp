@@ -106,7 +106,7 @@ public:
 PLUMED_REGISTER_ACTION(Average,"AVERAGE")
 
 void Average::registerKeywords( Keywords& keys ) {
-  vesselbase::ActionWithAveraging::registerKeywords( keys ); keys.use("ARG");
+  vesselbase::ActionWithAveraging::registerKeywords( keys ); keys.use("ARG"); keys.use("WALKERS_MPI");
   keys.remove("SERIAL"); keys.remove("LOWMEM");
 }
 
@@ -131,7 +131,7 @@ Average::Average( const ActionOptions& ao ):
 }
 
 void Average::performOperations( const bool& from_update ) {
-  myaverage->accumulate( cweight, getArgument(0) );
+  myaverage->accumulate( lweight, getArgument(0) );
 }
 
 void Average::finishAveraging() {
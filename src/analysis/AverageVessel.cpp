@@ -20,6 +20,7 @@
    along with plumed.  If not, see <http://www.gnu.org/licenses/>.
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 #include "AverageVessel.h"
+#include "tools/Communicator.h"
 
 namespace PLMD {
 namespace analysis {
@@ -34,25 +35,42 @@ AverageVessel::AverageVessel( const vesselbase::VesselOptions& da):
 {
   parseVector("PERIODIC",domain);
   plumed_assert( domain.size()==2 || domain.size()==0 );
+  acc=Accumulator( domain.size()==2 ? 2 : 1 );
 }
 
 void AverageVessel::resize() {
-  resizeBuffer(0);
-  if( domain.size()==2 ) setDataSize(2);
-  else setDataSize(1);
+  resizeBuffer(0); setDataSize(0);
 }
 
-void AverageVessel::accumulate( const double& weight, const double& val ) {
+void AverageVessel::accumulate( const double& logweight, const double& val ) {
+  dataWasAdded();
   if( domain.size()==2 ) {
     // Average with Berry Phase
     double tval = 2*pi*( val - domain[0] ) / ( domain[1] - domain[0] );
-    addDataElement( 0, weight*sin(tval) ); addDataElement( 1, weight*cos(tval) );
-  } else addDataElement( 0, weight*val );
+    double sc[2]; sc[0]=sin(tval); sc[1]=cos(tval);
+    acc.add( sc, logweight );
+  } else acc.add( val, logweight );
 }
 
 double AverageVessel::getAverage() const {
-  if( domain.size()==2 ) return domain[0] + (( domain[1] - domain[0] )*atan2( getDataElement(0), getDataElement(1) ) / (2*pi));
-  return getDataElement(0);
+  if( acc.getNumberOfSamples()==0 ) return 0.0;
+  // The normalization does not change the direction of the Berry phase
+  if( domain.size()==2 ) return domain[0] + (( domain[1] - domain[0] )*atan2( acc.getMean(0), acc.getMean(1) ) / (2*pi));
+  // The weighted mean is converted to the unnormalised sum or to the sum divided by the number of samples if required
+  if( noAverage() ) return acc.getSumWeights()*acc.getMean(0);
+  if( countNormalization() ) return acc.getSumWeights()*acc.getMean(0) / acc.getNumberOfSamples();
+  return acc.getMean(0);
+}
+
+void AverageVessel::clear() {
+  AveragingVessel::clear(); acc.clear();
+}
+
+void AverageVessel::sumOverReplicas( Communicator& comm, Communicator& multi_sim_comm ) {
+  // Only the root of each replica communicates with the other replicas
+  std::vector<double> state; acc.getState( state );
+  if( comm.Get_rank()==0 ) { acc.mergeOverComm( multi_sim_comm ); acc.getState( state ); }
+  comm.Bcast( state, 0 ); acc.setState( state );
 }
 
 void AverageVessel::calculate( const unsigned& current, MultiValue& myvals, std::vector<double>& buffer, std::vector<unsigned>& der_list ) const {
@@ -23,6 +23,7 @@
 #define __PLUMED_analysis_AverageVessel_h
 
 #include "vesselbase/AveragingVessel.h"
+#include "tools/Accumulator.h"
 
 namespace PLMD {
 namespace analysis {
@@ -30,6 +31,8 @@ namespace analysis {
 class AverageVessel : public vesselbase::AveragingVessel {
 private:
   std::vector<double> domain;
+/// The weighted average of the quantity (or of its sine and cosine if it is periodic)
+  Accumulator acc;
 public:
   /// keywords
   static void registerKeywords( Keywords& keys );
@@ -40,8 +43,12 @@ public:
 /// This does nothing
   void calculate( const unsigned& current, MultiValue& myvals, std::vector<double>& buffer, std::vector<unsigned>& der_list ) const ;
   std::string description() { return ""; }
-/// Accumulate the average
-  void accumulate( const double& weight, const double& val );
+/// Accumulate the average using the logarithm of the weight
+  void accumulate( const double& logweight, const double& val );
+/// Clear the accumulated average
+  void clear();
+/// Merge the averages accumulated by all the replicas
+  void sumOverReplicas( Communicator& comm, Communicator& multi_sim_comm );
 /// Get the average value
   double getAverage() const ;
 };
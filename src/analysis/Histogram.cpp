@@ -224,7 +224,7 @@ public:
 PLUMED_REGISTER_ACTION(Histogram,"HISTOGRAM")
 
 void Histogram::registerKeywords( Keywords& keys ) {
-  gridtools::ActionWithGrid::registerKeywords( keys ); keys.use("ARG"); keys.remove("NORMALIZATION");
+  gridtools::ActionWithGrid::registerKeywords( keys ); keys.use("ARG"); keys.use("WALKERS_MPI"); keys.remove("NORMALIZATION");
   keys.add("compulsory","NORMALIZATION","ndata","This controls how the data is normalized it can be set equal to true, false or ndata.  See above for an explanation");
   keys.add("optional","DATA","input data from action with vessel and compute histogram");
   keys.add("optional","VECTORS","input three dimsnional vectors for computing histogram");
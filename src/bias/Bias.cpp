@@ -53,6 +53,8 @@ void Bias::registerKeywords( Keywords& keys ) {
   ActionWithValue::registerKeywords(keys);
   ActionWithArguments::registerKeywords(keys);
   keys.add("hidden","STRIDE","the frequency with which the forces due to the bias should be calculated.  This can be used to correctly set up multistep algorithms");
+  keys.add("optional","MTS_STRIDE","apply the forces only every this number of steps, scaled by the same number, as in a multiple time step (impulse) integrator. "
+           "The arguments are then only computed on these steps, unless they are needed by other actions");
   componentsAreNotOptional(keys);
   keys.addOutputComponent("bias","default","the instantaneous value of the bias potential");
 }
@@ -142,6 +142,7 @@ External::External(const ActionOptions& ao):
   std::string funcl=getLabel() + ".bias";
   BiasGrid_=Grid::create(funcl,getArguments(),gridfile,sparsegrid,spline,true);
   gridfile.close();
+  addMemoryUsage("bias grid",[this]() { return BiasGrid_->getMemoryUsage(); });
   if(BiasGrid_->getDimension()!=getNumberOfArguments()) error("mismatch between dimensionality of input grid and number of arguments");
   for(unsigned i=0; i<getNumberOfArguments(); ++i) {
     if( getPntrToArgument(i)->isPeriodic()!=BiasGrid_->getIsPeriodic()[i] ) error("periodicity mismatch between arguments and input bias");
@@ -88,7 +88,11 @@ This default choice should be reasonable for most applications.
 
 Metadynamics can be restarted either from a HILLS file as well as from a GRID, in this second
 case one can first save a GRID using GRID_WFILE (and GRID_WSTRIDE) and at a later stage read
-it using GRID_RFILE.
+it using GRID_RFILE. For large grids, the flag GRID_BINARY can be used to write the grid in a binary
+format, which is much faster to write and to read than the text format. The binary file is replaced atomically,
+so that a complete grid is always available in case of a crash. GRID_RFILE recognizes binary files automatically.
+Binary grid files are not portable across machines with a different byte order. Writing them
+on a memory file system (e.g. /dev/shm on Linux) allows restarts on the same node without disk access.
 
 Another option that is available in plumed is well-tempered metadynamics \cite Barducci:2008. In this
 varient of metadynamics the heights of the Gaussian hills are rescaled at each step so the bias is now
@@ -369,6 +373,8 @@ private:
   bool storeOldGrids_;
   int wgridstride_;
   bool grid_;
+  bool gridBinary_;
+  string gridBinaryFile_;
   double height0_;
   double biasf_;
   static const size_t n_tempering_options_ = 1;
@@ -476,6 +482,7 @@ void MetaD::registerKeywords(Keywords& keys) {
   keys.add("optional","GRID_WSTRIDE","write the grid to a file every N steps");
   keys.add("optional","GRID_WFILE","the file on which to write the grid");
   keys.add("optional","GRID_RFILE","a grid file from which the bias should be read at the initial step of the simulation");
+  keys.addFlag("GRID_BINARY",false,"write the grid on GRID_WFILE in a binary format that is replaced atomically and is much faster to read and write than the text format");
   keys.addFlag("STORE_GRIDS",false,"store all the grid files the calculation generates. They will be deleted if this keyword is not present");
   keys.add("optional","ADAPTIVE","use a geometric (=GEOM) or diffusion (=DIFF) based hills width scheme. Sigma is one number that has distance units or timestep dimensions");
   keys.add("optional","WALKERS_ID", "walker id");
@@ -507,7 +514,7 @@ void MetaD::registerTemperingKeywords(const std::string &name_stem, const std::s
 MetaD::MetaD(const ActionOptions& ao):
   PLUMED_BIAS_INIT(ao),
 // Grid stuff initialization
-  wgridstride_(0), grid_(false),
+  wgridstride_(0), grid_(false), gridBinary_(false),
 // Metadynamics basic parameters
   height0_(std::numeric_limits<double>::max()), biasf_(-1.0), dampfactor_(0.0),
   tt_specs_(false, "TT", "Transition Tempered", -1.0, 0.0, 1.0),
@@ -586,6 +593,7 @@ MetaD::MetaD(const ActionOptions& ao):
   parse("HEIGHT",height0_);
   parse("PACE",stride_);
   if(stride_<=0 ) error("frequency for hill addition is nonsensical");
+  if(stride_%getStride()!=0) error("PACE should be a multiple of MTS_STRIDE");
   string hillsfname="HILLS";
   parse("FILE",hillsfname);
 
@@ -712,6 +720,11 @@ MetaD::MetaD(const ActionOptions& ao):
   string gridfilename_;
   parse("GRID_WFILE",gridfilename_);
   parseFlag("STORE_GRIDS",storeOldGrids_);
+  parseFlag("GRID_BINARY",gridBinary_);
+  if(gridBinary_ && gridfilename_.length()==0) error("GRID_BINARY requires GRID_WFILE");
+  if(gridBinary_ && !grid_) error("GRID_BINARY requires a grid, use GRID_MIN, GRID_MAX and GRID_BIN");
+  if(gridBinary_ && wgridstride_<=0) error("GRID_BINARY requires GRID_WSTRIDE");
+  if(gridBinary_ && storeOldGrids_) error("STORE_GRIDS cannot be used with GRID_BINARY");
   if(grid_ && gridfilename_.length()>0) {
     if(wgridstride_==0 ) error("frequency with which to output grid not specified use GRID_WSTRIDE");
   }
@@ -856,6 +869,7 @@ MetaD::MetaD(const ActionOptions& ao):
     if(spline) {log.printf("  Grid uses spline interpolation\n");}
     if(sparsegrid) {log.printf("  Grid uses sparse grid\n");}
     if(wgridstride_>0) {log.printf("  Grid is written on file %s with stride %d\n",gridfilename_.c_str(),wgridstride_);}
+    if(gridBinary_) {log.printf("  Grid is written in binary format\n");}
   }
 
   if(mw_n_>1) {
@@ -1000,8 +1014,13 @@ MetaD::MetaD(const ActionOptions& ao):
       error("The GRID file you want to read: " + gridreadfilename_ + ", cannot be found!");
     }
     std::string funcl=getLabel() + ".bias";
-    BiasGrid_=Grid::create(funcl, getArguments(), gridfile, gmin, gmax, gbin, sparsegrid, spline, true);
-    gridfile.close();
+    if(Grid::isBinaryFile(gridfile.getPath())) {
+      gridfile.close();
+      BiasGrid_=Grid::createFromBinary(funcl, getArguments(), gridfile.getPath(), gmin, gmax, gbin, sparsegrid, spline, true);
+    } else {
+      BiasGrid_=Grid::create(funcl, getArguments(), gridfile, gmin, gmax, gbin, sparsegrid, spline, true);
+      gridfile.close();
+    }
     if(BiasGrid_->getDimension()!=getNumberOfArguments()) error("mismatch between dimensionality of input grid and number of arguments");
     for(unsigned i=0; i<getNumberOfArguments(); ++i) {
       if( getPntrToArgument(i)->isPeriodic()!=BiasGrid_->getIsPeriodic()[i] ) error("periodicity mismatch between arguments and input bias");
@@ -1108,7 +1127,21 @@ MetaD::MetaD(const ActionOptions& ao):
   }
 
   // open grid file for writing
-  if(wgridstride_>0) {
+  if(wgridstride_>0 && gridBinary_) {
+    // binary grids are written directly by the root process, with the same naming as text grids
+    std::string suffix=plumed.getSuffix();
+    if(walkers_mpi || mw_n_>1) suffix="";
+    int r=0;
+    if(walkers_mpi) {
+      if(comm.Get_rank()==0) r=multi_sim_comm.Get_rank();
+      comm.Bcast(r,0);
+    }
+    if(r==0 && comm.Get_rank()==0) gridBinaryFile_=OFile::appendSuffix(gridfilename_,suffix);
+    if(gridBinaryFile_.length()>0 && !getRestart()) {
+      OFile backup; backup.link(*this);
+      backup.backupFile("bck",gridBinaryFile_);
+    }
+  } else if(wgridstride_>0) {
     gridfile_.link(*this);
     if(walkers_mpi) {
       int r=0;
@@ -1155,6 +1188,18 @@ MetaD::MetaD(const ActionOptions& ao):
     }
   }
 
+  addMemoryUsage("bias grid",[this]() {
+    std::size_t m=0;
+    if(BiasGrid_) m+=BiasGrid_->getMemoryUsage();
+    if(TargetGrid_) m+=TargetGrid_->getMemoryUsage();
+    return m;
+  });
+  addMemoryUsage("hills",[this]() {
+    std::size_t m=hills_.capacity()*sizeof(Gaussian);
+    for(const auto & h : hills_) m+=(h.center.capacity()+h.sigma.capacity()+h.invsigma.capacity())*sizeof(double);
+    return m;
+  });
+
   log<<"  Bibliography "<<plumed.cite("Laio and Parrinello, PNAS 99, 12562 (2002)");
   if(welltemp_) log<<plumed.cite(
                        "Barducci, Bussi, and Parrinello, Phys. Rev. Lett. 100, 020603 (2008)");
@@ -1313,8 +1358,9 @@ void MetaD::addGaussian(const Gaussian& hill)
         BiasGrid_->getPoint(ineigh,xx);
         allbias[i]=evaluateGaussian(xx,hill,&allder[ncv*i]);
       }
-      comm.Sum(allbias);
-      comm.Sum(allder);
+      comm.DeferSum(allbias);
+      comm.DeferSum(allder);
+      comm.SumDeferred();
       for(unsigned i=0; i<neighbors.size(); ++i) {
         Grid::index_t ineigh=neighbors[i];
         for(unsigned j=0; j<ncv; ++j) {der[j]=allder[ncv*i+j];}
@@ -1394,8 +1440,9 @@ double MetaD::getBiasAndDerivatives(const vector<double>& cv, double* der)
     for(unsigned i=rank; i<hills_.size(); i+=stride) {
       bias+=evaluateGaussian(cv,hills_[i],der);
     }
-    comm.Sum(bias);
-    if(der) comm.Sum(der,getNumberOfArguments());
+    comm.DeferSum(bias);
+    if(der) comm.DeferSum(der,getNumberOfArguments());
+    comm.SumDeferred();
   } else {
     if(der) {
       vector<double> vder(getNumberOfArguments());
@@ -1663,7 +1710,10 @@ void MetaD::update() {
   work_+=vbias1-vbias;
 
   // dump grid on file
-  if(wgridstride_>0&&(getStep()%wgridstride_==0||getCPT())) {
+  if(gridBinary_&&wgridstride_>0&&(getStep()%wgridstride_==0||getCPT())) {
+    // only the root process of the first replica writes binary grids
+    if(gridBinaryFile_.length()>0) BiasGrid_->writeBinary(gridBinaryFile_);
+  } else if(wgridstride_>0&&(getStep()%wgridstride_==0||getCPT())) {
     // in case old grids are stored, a sequence of grids should appear
     // this call results in a repetition of the header:
     if(storeOldGrids_) gridfile_.clearFields();
@@ -1831,7 +1881,8 @@ void MetaD::computeReweightingFactor()
     sum1 += exp( afactor*currentb );
     sum2 += exp( afactor2*currentb );
   }
-  comm.Sum( sum1 ); comm.Sum( sum2 );
+  comm.DeferSum( sum1 ); comm.DeferSum( sum2 );
+  comm.SumDeferred();
   reweight_factor = kbt_ * std::log( sum1/sum2 );
   getPntrToComponent("rct")->set(reweight_factor);
 }
@@ -396,6 +396,7 @@ PBMetaD::PBMetaD(const ActionOptions& ao):
   parse("HEIGHT",height0_);
   parse("PACE",stride_);
   if(stride_<=0) error("frequency for hill addition is nonsensical");
+  if(stride_%getStride()!=0) error("PACE should be a multiple of MTS_STRIDE");
 
   parseVector("FILE",hillsfname);
   if(hillsfname.size()==0) {
@@ -530,6 +531,12 @@ PBMetaD::PBMetaD(const ActionOptions& ao):
 
   checkRead();
 
+  addMemoryUsage("bias grids",[this]() {
+    std::size_t m=0;
+    for(const auto & g : BiasGrids_) m+=g->getMemoryUsage();
+    return m;
+  });
+
   log.printf("  Gaussian width ");
   if (adaptive_==FlexibleBin::diffusion)log.printf(" (Note: The units of sigma are in timesteps) ");
   if (adaptive_==FlexibleBin::geometry)log.printf(" (Note: The units of sigma are in dist units) ");
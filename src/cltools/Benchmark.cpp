@@ -0,0 +1,320 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2018 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "CLTool.h"
+#include "CLToolRegister.h"
+#include "core/PlumedMain.h"
+#include "tools/Tools.h"
+#include "tools/Vector.h"
+#include "tools/Random.h"
+#include "tools/Stopwatch.h"
+#include "tools/Communicator.h"
+#include "tools/OFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+namespace PLMD {
+namespace cltools {
+
+//+PLUMEDOC TOOLS benchmark
+/*
+benchmark runs a PLUMED input on a trajectory and measures how long each part of the calculation takes.
+
+The input is first run for a number of warm-up steps that are not included in the statistics
+(so as to exclude the time spent allocating memory, reading grids, building the first
+neighbor lists, etc.) and then for the number of steps that are measured.
+The trajectory is either generated on the fly, with the atoms sitting close to the sites
+of a cubic lattice and diffusing a little at every step, or read from an xyz file.
+In the latter case the frames are reused cyclically if the file contains less frames
+than the number of steps required.
+
+Detailed timers are switched on, so that the time taken by each action in the forward (4A) and in the
+backward (5A) loop is measured separately. At the end of the calculation a file is written that contains,
+for each timer, the number of cycles measured, the total time and the minimum, median,
+99th percentile and maximum time of a single cycle, all in seconds. The number of steps per second and
+the maximum resident memory of the process (in kB) are written as constant fields at the top of the file,
+together with the time taken to initialize PLUMED (in seconds), which includes reading the input and the files it refers to.
+Since this is the same format used by \ref PRINT, the results are easily compared across PLUMED versions
+so as to detect performance regressions.
+
+A set of inputs that can be used to benchmark some of the most expensive actions in PLUMED
+can be found in the directory test/benchmarks of the PLUMED distribution.
+
+\par Examples
+
+The following command runs the input in plumed.dat on a synthetic trajectory of 1000 atoms for
+10 warm-up steps and 500 measured steps and writes the timings in the file benchmark.dat
+\verbatim
+plumed benchmark --plumed plumed.dat --natoms 1000 --nsteps 500
+\endverbatim
+
+The following command does the same using the frames of the trajectory traj.xyz
+\verbatim
+plumed benchmark --plumed plumed.dat --ixyz traj.xyz --nsteps 500
+\endverbatim
+
+*/
+//+ENDPLUMEDOC
+
+class Benchmark:
+  public CLTool
+{
+/// Read all the frames of an xyz file
+  static void readXYZ(const string & file,vector<vector<Vector> > & frames,vector<Vector> & boxes);
+/// Value of the percentile p (between 0 and 1) of a sorted vector, using the nearest rank
+  static double percentile(const vector<long long int> & sorted,double p);
+public:
+  static void registerKeywords( Keywords& keys );
+  explicit Benchmark(const CLToolOptions& co );
+  int main(FILE* in, FILE*out,Communicator& pc);
+  string description()const {
+    return "run a plumed input on a trajectory and measure its performance";
+  }
+};
+
+PLUMED_REGISTER_CLTOOL(Benchmark,"benchmark")
+
+void Benchmark::registerKeywords( Keywords& keys ) {
+  CLTool::registerKeywords( keys );
+  keys.add("compulsory","--plumed","plumed.dat","the name of the plumed input file");
+  keys.add("compulsory","--nsteps","100","the number of steps that are measured");
+  keys.add("compulsory","--nwarmup","10","the number of steps that are run before starting the measure");
+  keys.add("compulsory","--output","benchmark.dat","the file on which the timings are written");
+  keys.add("compulsory","--log","benchmark.log","the file on which the plumed log is written");
+  keys.add("compulsory","--timestep","0.002","the timestep passed to plumed in picoseconds");
+  keys.add("compulsory","--density","100","the number of atoms per cubic nanometer in the synthetic trajectory");
+  keys.add("compulsory","--seed","1","the seed for the random numbers used to generate the synthetic trajectory");
+  keys.add("optional","--natoms","the number of atoms in the synthetic trajectory");
+  keys.add("optional","--ixyz","a trajectory in xyz format to be used in place of the synthetic one");
+  keys.add("optional","--kt","set kBT, it will not be necessary to specify temperature in input file");
+}
+
+Benchmark::Benchmark(const CLToolOptions& co ):
+  CLTool(co)
+{
+  inputdata=commandline;
+}
+
+void Benchmark::readXYZ(const string & file,vector<vector<Vector> > & frames,vector<Vector> & boxes) {
+  FILE* fp=fopen(file.c_str(),"r");
+  if(!fp) plumed_merror("cannot open trajectory file " + file);
+  string line;
+  while(Tools::getline(fp,line)) {
+    unsigned natoms;
+    if(!Tools::convert(line,natoms)) plumed_merror("wrong number of atoms in file " + file);
+    bool ok=Tools::getline(fp,line);
+    if(!ok) plumed_merror("premature end of trajectory file " + file);
+    vector<string> words=Tools::getWords(line);
+    Vector box;
+    if(words.size()<3) plumed_merror("the second line of each frame of " + file + " should contain the box");
+    for(unsigned k=0; k<3; k++) Tools::convert(words[k],box[k]);
+    vector<Vector> positions(natoms);
+    for(unsigned i=0; i<natoms; i++) {
+      ok=Tools::getline(fp,line);
+      if(!ok) plumed_merror("premature end of trajectory file " + file);
+      words=Tools::getWords(line);
+      if(words.size()<4) plumed_merror("wrong line in trajectory file " + file + ": " + line);
+      for(unsigned k=0; k<3; k++) Tools::convert(words[k+1],positions[i][k]);
+    }
+    if(frames.size()>0 && natoms!=frames[0].size()) plumed_merror("all the frames in " + file + " should have the same number of atoms");
+    frames.push_back(positions);
+    boxes.push_back(box);
+  }
+  fclose(fp);
+  if(frames.size()==0) plumed_merror("no frames found in trajectory file " + file);
+}
+
+double Benchmark::percentile(const vector<long long int> & sorted,double p) {
+  if(sorted.size()==0) return 0.0;
+  long int rank=static_cast<long int>(std::ceil(p*sorted.size()))-1;
+  if(rank<0) rank=0;
+  return 1e-9*sorted[rank];
+}
+
+int Benchmark::main(FILE* in, FILE*out,Communicator& pc) {
+  string plumedFile; parse("--plumed",plumedFile);
+  int nsteps; parse("--nsteps",nsteps);
+  int nwarmup; parse("--nwarmup",nwarmup);
+  string outputFile; parse("--output",outputFile);
+  string logFile; parse("--log",logFile);
+  double timestep; parse("--timestep",timestep);
+  double density; parse("--density",density);
+  int seed; parse("--seed",seed);
+  string trajectoryFile; parse("--ixyz",trajectoryFile);
+  string natomsString; parse("--natoms",natomsString);
+  string ktString; parse("--kt",ktString);
+  if(nsteps<=0) error("--nsteps should be positive");
+  if(nwarmup<0) error("--nwarmup should not be negative");
+
+// trajectory: either read from file or generated on a lattice
+  vector<vector<Vector> > frames;
+  vector<Vector> boxes;
+  int natoms=0;
+  double spacing=0.0;
+  Random random;
+  random.setSeed(-seed);
+  if(trajectoryFile.length()>0) {
+    if(natomsString.length()>0) error("--natoms cannot be used with --ixyz");
+    readXYZ(trajectoryFile,frames,boxes);
+    natoms=frames[0].size();
+  } else {
+    if(natomsString.length()==0) error("either --natoms or --ixyz should be specified");
+    if(!Tools::convert(natomsString,natoms) || natoms<=0) error("--natoms should be a positive integer");
+    if(density<=0.0) error("--density should be positive");
+    int nside=1;
+    while(nside*nside*nside<natoms) nside++;
+    spacing=std::cbrt(1.0/density);
+    frames.resize(1);
+    frames[0].resize(natoms);
+    for(int i=0; i<natoms; i++) {
+      int ix=i/(nside*nside), iy=(i/nside)%nside, iz=i%nside;
+      frames[0][i]=spacing*Vector(ix+0.1*random.Gaussian(),iy+0.1*random.Gaussian(),iz+0.1*random.Gaussian());
+    }
+    boxes.push_back(Vector(nside*spacing,nside*spacing,nside*spacing));
+  }
+
+  vector<Vector> positions(frames[0]);
+  vector<Vector> forces(natoms);
+  vector<double> masses(natoms,1.0);
+  vector<double> charges(natoms,0.0);
+  double box[3][3];
+  double virial[3][3];
+
+  PlumedMain p;
+  int s=sizeof(double);
+  p.cmd("setRealPrecision",&s);
+  if(Communicator::initialized()) p.cmd("setMPIComm",&pc.Get_comm());
+  p.cmd("setMDEngine","benchmark");
+  p.cmd("setNatoms",&natoms);
+  p.cmd("setTimestep",&timestep);
+  p.cmd("setPlumedDat",plumedFile.c_str());
+  p.cmd("setLogFile",logFile.c_str());
+  if(ktString.length()>0) {
+    double kt;
+    if(!Tools::convert(ktString,kt)) error("cannot read --kt");
+    p.cmd("setKbT",&kt);
+  }
+  auto startInit=std::chrono::steady_clock::now();
+  p.cmd("init");
+  double initTime=std::chrono::duration<double>(std::chrono::steady_clock::now()-startInit).count();
+  p.detailedTimers=true;
+
+  Stopwatch & sw(p.getStopwatch());
+  sw.setKeepLaps(true);
+  vector<long long int> stepLaps;
+  stepLaps.reserve(nsteps);
+  auto start=std::chrono::steady_clock::now();
+
+  for(int istep=0; istep<nwarmup+nsteps; istep++) {
+    if(istep==nwarmup) {
+      sw.clearLaps();
+      start=std::chrono::steady_clock::now();
+    }
+    if(trajectoryFile.length()>0) {
+      unsigned iframe=istep%frames.size();
+      positions=frames[iframe];
+      for(unsigned i=0; i<3; i++) for(unsigned j=0; j<3; j++) box[i][j]=0.0;
+      for(unsigned i=0; i<3; i++) box[i][i]=boxes[iframe][i];
+    } else {
+// atoms diffuse a little so that neighbor lists are updated from time to time
+      if(istep>0) for(int i=0; i<natoms; i++) positions[i]+=0.01*spacing*Vector(random.Gaussian(),random.Gaussian(),random.Gaussian());
+      for(unsigned i=0; i<3; i++) for(unsigned j=0; j<3; j++) box[i][j]=0.0;
+      for(unsigned i=0; i<3; i++) box[i][i]=boxes[0][i];
+    }
+    for(int i=0; i<natoms; i++) forces[i].zero();
+    for(unsigned i=0; i<3; i++) for(unsigned j=0; j<3; j++) virial[i][j]=0.0;
+    long int step=istep;
+    p.cmd("setStepLong",&step);
+    p.cmd("setPositions",&positions[0][0]);
+    p.cmd("setMasses",&masses[0]);
+    p.cmd("setCharges",&charges[0]);
+    p.cmd("setForces",&forces[0][0]);
+    p.cmd("setVirial",&virial[0][0]);
+    p.cmd("setBox",&box[0][0]);
+    auto t0=std::chrono::steady_clock::now();
+    p.cmd("calc");
+    if(istep>=nwarmup) stepLaps.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-t0).count());
+  }
+  double elapsed=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+
+  long maxrss=0;
+#if defined(__unix__) || defined(__APPLE__)
+  struct rusage usage;
+  if(getrusage(RUSAGE_SELF,&usage)==0) maxrss=usage.ru_maxrss;
+#ifdef __APPLE__
+// on OSX this is in bytes
+  maxrss/=1024;
+#endif
+#endif
+
+  if(pc.Get_rank()==0) {
+    OFile ofile;
+    ofile.open(outputFile);
+    ofile.addConstantField("natoms").printField("natoms",natoms);
+    ofile.addConstantField("nsteps").printField("nsteps",nsteps);
+    ofile.addConstantField("steps_per_second").printField("steps_per_second",nsteps/elapsed);
+    ofile.addConstantField("max_rss_kb").printField("max_rss_kb",static_cast<int>(maxrss));
+    ofile.addConstantField("init_seconds").printField("init_seconds",initTime);
+    ofile.fmtField(" %.9f");
+    vector<string> names(sw.getNames());
+// the total time of a step measured here goes first
+    names.insert(names.begin(),"step");
+    for(const auto & name : names) {
+      vector<long long int> laps(name=="step" ? stepLaps : sw.getLaps(name));
+      if(laps.size()==0) continue;
+      std::sort(laps.begin(),laps.end());
+      long long int total=0;
+      for(const auto & l : laps) total+=l;
+// spaces are not allowed in fields
+      string field(name);
+      std::replace(field.begin(),field.end(),' ','_');
+      ofile.printField("timer",field);
+      ofile.printField("cycles",static_cast<int>(laps.size()));
+      ofile.printField("total",1e-9*total);
+      ofile.printField("min",1e-9*laps[0]);
+      ofile.printField("median",percentile(laps,0.5));
+      ofile.printField("p99",percentile(laps,0.99));
+      ofile.printField("max",1e-9*laps.back());
+      ofile.printField();
+    }
+    ofile.close();
+    fprintf(out,"Number of atoms            : %d\n",natoms);
+    fprintf(out,"Warm-up steps              : %d\n",nwarmup);
+    fprintf(out,"Measured steps             : %d\n",nsteps);
+    fprintf(out,"Steps per second           : %f\n",nsteps/elapsed);
+    fprintf(out,"Maximum resident memory    : %ld kB\n",maxrss);
+    fprintf(out,"Initialization time        : %f s\n",initTime);
+    fprintf(out,"Timings written on         : %s\n",outputFile.c_str());
+  }
+  return 0;
+}
+
+}
+}
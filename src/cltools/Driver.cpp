@@ -31,10 +31,15 @@
 #include <vector>
 #include <map>
 #include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 #include "tools/Units.h"
 #include "tools/PDB.h"
 #include "tools/FileBase.h"
 #include "tools/IFile.h"
+#include "tools/OFile.h"
 
 // when using molfile plugin
 #ifdef __PLUMED_HAS_MOLFILE_PLUGINS
@@ -174,6 +179,33 @@ Notice that the xdrfile implementation of xtc and trr
 is more robust than the molfile one, since it provides support for generic cell shapes.
 In addition, it allows \ref DUMPATOMS to write compressed xtc files.
 
+When a long trajectory is analyzed, reading and decoding the frames can take a significant fraction of the time.
+With the `--read-ahead` option the frames are read by a separate thread while PLUMED is working on the previous frames.
+The following command reads up to four frames in advance:
+\verbatim
+plumed driver --plumed plumed.dat --ixyz trajectory.xyz --read-ahead 4
+\endverbatim
+At the end of the run the driver reports the time spent reading the trajectory and the time
+that was spent waiting for frames that were not ready yet.
+
+If the quantities that are computed do not depend on the history of the trajectory, the frames can be
+divided between the MPI processes with the `--parallel-frames` option.  Each process runs a separate copy
+of PLUMED on one out of every \f$N\f$ frames, where \f$N\f$ is the number of processes, and writes its own output files
+with a suffix equal to its index.  The files listed with `--merge-files`, which must contain one line per frame (or per set of lines)
+starting with the time as the files written by \ref PRINT, are merged in the order of time at the end of the calculation.
+Histograms and averages that are computed using the WALKERS_MPI flag are summed over all the processes at the end of the
+calculation, so that the grids output by \ref DUMPGRID at the end of the calculation contain the data from the whole trajectory.
+\verbatim
+mpirun -np 4 plumed driver --plumed plumed.dat --ixyz trajectory.xyz --parallel-frames --merge-files colvar
+\endverbatim
+where `plumed.dat` is
+\plumedfile
+d: DISTANCE ATOMS=1,2
+PRINT ARG=d FILE=colvar
+hh: HISTOGRAM ARG=d GRID_MIN=0 GRID_MAX=3 GRID_BIN=100 BANDWIDTH=0.05 WALKERS_MPI
+DUMPGRID GRID=hh FILE=histo
+\endplumedfile
+
 
 */
 //+ENDPLUMEDOC
@@ -195,6 +227,368 @@ static int register_cb(void *v, vmdplugin_t *p) {
 }
 #endif
 
+/// A frame of the trajectory that has been read by the driver
+template<typename real>
+class DriverFrame {
+public:
+/// The number of atoms in the frame
+  int natoms;
+/// The step number stored in the file (only for xtc/trr files)
+  int step;
+/// The positions of the atoms and the cell
+  std::vector<real> coordinates;
+  std::vector<real> cell;
+/// If the frame could not be read this contains the reason
+  std::string error;
+/// False if the frame was skipped without reading the positions
+  bool decoded;
+  DriverFrame(): natoms(0), step(0), cell(9,real(0.0)), decoded(true) {}
+};
+
+/// This reads the frames of the trajectory for the driver.
+/// The files are opened and closed by the driver.
+template<typename real>
+class DriverReader {
+public:
+  std::string trajectory_fmt;
+  bool use_molfile;
+  FILE* fp;
+#ifdef __PLUMED_HAS_MOLFILE_PLUGINS
+  molfile_plugin_t *api;
+  void *h_in;
+  molfile_timestep_t ts_in;
+  std::unique_ptr<float[]> ts_in_coords;
+#endif
+#ifdef __PLUMED_HAS_XDRFILE
+  XDRFILE* xd;
+  std::unique_ptr<rvec[]> pos;
+#endif
+/// The number of atoms for formats that store it in the header
+  int natoms;
+  bool pbc_cli_given;
+  std::vector<double> pbc_cli_box;
+  std::string line;
+  DriverReader():
+    use_molfile(false),
+    fp(NULL),
+#ifdef __PLUMED_HAS_MOLFILE_PLUGINS
+    api(NULL),
+    h_in(NULL),
+#endif
+#ifdef __PLUMED_HAS_XDRFILE
+    xd(NULL),
+#endif
+    natoms(0),
+    pbc_cli_given(false),
+    pbc_cli_box(9,0.0)
+  {
+#ifdef __PLUMED_HAS_MOLFILE_PLUGINS
+    ts_in.coords=NULL;
+    ts_in.A=-1; // we use this to check whether cell is provided or not
+#endif
+  }
+/// Set the number of atoms for formats that store it in the header
+  void setNatoms( const int& n );
+/// Read the next frame. Returns false at the end of the file.
+/// If decode is false the positions may not be read
+  bool read( DriverFrame<real>& frame, const bool& decode=true );
+};
+
+template<typename real>
+void DriverReader<real>::setNatoms( const int& n ) {
+  natoms=n;
+#ifdef __PLUMED_HAS_MOLFILE_PLUGINS
+  if( use_molfile ) {
+    ts_in_coords.reset(new float [3*natoms]);
+    ts_in.coords = ts_in_coords.get();
+  }
+#endif
+#ifdef __PLUMED_HAS_XDRFILE
+  if( trajectory_fmt=="xdr-xtc" || trajectory_fmt=="xdr-trr" ) pos.reset(new rvec[natoms]);
+#endif
+}
+
+template<typename real>
+bool DriverReader<real>::read( DriverFrame<real>& frame, const bool& decode ) {
+  frame.error.clear(); frame.decoded=true;
+  std::vector<real>& coordinates(frame.coordinates);
+  std::vector<real>& cell(frame.cell);
+  if(use_molfile) {
+#ifdef __PLUMED_HAS_MOLFILE_PLUGINS
+    int rc;
+    // molfile plugins skip the frame when they are given a NULL timestep
+    rc = api->read_next_timestep(h_in, natoms, decode ? &ts_in : NULL);
+    if(rc==MOLFILE_EOF) return false;
+    frame.natoms=natoms;
+    if(!decode) { frame.decoded=false; return true; }
+    coordinates.resize(3*natoms);
+    if(pbc_cli_given==false) {
+      if(ts_in.A>0.0) { // this is negative if molfile does not provide box
+        // info on the cell: convert using pbcset.tcl from pbctools in vmd distribution
+        real cosBC=cos(ts_in.alpha*pi/180.);
+        //double sinBC=sin(ts_in.alpha*pi/180.);
+        real cosAC=cos(ts_in.beta*pi/180.);
+        real cosAB=cos(ts_in.gamma*pi/180.);
+        real sinAB=sin(ts_in.gamma*pi/180.);
+        real Ax=ts_in.A;
+        real Bx=ts_in.B*cosAB;
+        real By=ts_in.B*sinAB;
+        real Cx=ts_in.C*cosAC;
+        real Cy=(ts_in.C*ts_in.B*cosBC-Cx*Bx)/By;
+        real Cz=sqrt(ts_in.C*ts_in.C-Cx*Cx-Cy*Cy);
+        cell[0]=Ax/10.; cell[1]=0.; cell[2]=0.;
+        cell[3]=Bx/10.; cell[4]=By/10.; cell[5]=0.;
+        cell[6]=Cx/10.; cell[7]=Cy/10.; cell[8]=Cz/10.;
+      } else {
+        cell[0]=0.0; cell[1]=0.0; cell[2]=0.0;
+        cell[3]=0.0; cell[4]=0.0; cell[5]=0.0;
+        cell[6]=0.0; cell[7]=0.0; cell[8]=0.0;
+      }
+    } else {
+      for(unsigned i=0; i<9; i++)cell[i]=pbc_cli_box[i];
+    }
+    // info on coords
+    // the order is xyzxyz...
+    for(int i=0; i<3*natoms; i++) {
+      coordinates[i]=real(ts_in.coords[i]/10.); //convert to nm
+    }
+#endif
+  } else if(trajectory_fmt=="xdr-xtc" || trajectory_fmt=="xdr-trr") {
+#ifdef __PLUMED_HAS_XDRFILE
+    int localstep;
+    float time;
+    matrix box;
+    float prec,lambda;
+    int ret=exdrOK;
+    if(trajectory_fmt=="xdr-xtc") ret=read_xtc(xd,natoms,&localstep,&time,box,pos.get(),&prec);
+    if(trajectory_fmt=="xdr-trr") ret=read_trr(xd,natoms,&localstep,&time,&lambda,box,pos.get(),NULL,NULL);
+    if(ret==exdrENDOFFILE) return false;
+    if(ret!=exdrOK) return false;
+    frame.natoms=natoms; frame.step=localstep; coordinates.resize(3*natoms);
+    for(unsigned i=0; i<3; i++) for(unsigned j=0; j<3; j++) cell[3*i+j]=box[i][j];
+    for(int i=0; i<natoms; i++) for(unsigned j=0; j<3; j++)
+        coordinates[3*i+j]=real(pos[i][j]);
+#endif
+  } else {
+    if(!Tools::getline(fp,line)) return false;
+    if(trajectory_fmt=="gro") if(!Tools::getline(fp,line)) { frame.error="premature end of trajectory file"; return true; }
+    sscanf(line.c_str(),"%100d",&frame.natoms);
+    int nat=frame.natoms;
+    if(!decode) {
+      // the lines with the box and the positions are read but not parsed
+      for(int i=0; i<nat+1; i++) {
+        if(!Tools::getline(fp,line)) { frame.error="premature end of trajectory file"; return true; }
+      }
+      frame.decoded=false; return true;
+    }
+    coordinates.resize(3*nat);
+
+    if(trajectory_fmt=="xyz") {
+      if(!Tools::getline(fp,line)) { frame.error="premature end of trajectory file"; return true; }
+
+      std::vector<double> celld(9,0.0);
+      if(pbc_cli_given==false) {
+        std::vector<std::string> words;
+        words=Tools::getWords(line);
+        if(words.size()==3) {
+          sscanf(line.c_str(),"%100lf %100lf %100lf",&celld[0],&celld[4],&celld[8]);
+        } else if(words.size()==9) {
+          sscanf(line.c_str(),"%100lf %100lf %100lf %100lf %100lf %100lf %100lf %100lf %100lf",
+                 &celld[0], &celld[1], &celld[2],
+                 &celld[3], &celld[4], &celld[5],
+                 &celld[6], &celld[7], &celld[8]);
+        } else { frame.error="needed box in second line of xyz file"; return true; }
+      } else {			// from command line
+        celld=pbc_cli_box;
+      }
+      for(unsigned i=0; i<9; i++)cell[i]=real(celld[i]);
+    }
+    int ddist=0;
+    // Read coordinates
+    for(int i=0; i<nat; i++) {
+      bool ok=Tools::getline(fp,line);
+      if(!ok) { frame.error="premature end of trajectory file"; return true; }
+      double cc[3];
+      if(trajectory_fmt=="xyz") {
+        char dummy[1000];
+        int ret=std::sscanf(line.c_str(),"%999s %100lf %100lf %100lf",dummy,&cc[0],&cc[1],&cc[2]);
+        if(ret!=4) { frame.error="cannot read line"+line; return true; }
+      } else if(trajectory_fmt=="gro") {
+        // do the gromacs way
+        if(!i) {
+          //
+          // calculate the distance between dots (as in gromacs gmxlib/confio.c, routine get_w_conf )
+          //
+          const char      *p1, *p2, *p3;
+          p1 = strchr(line.c_str(), '.');
+          if (p1 == NULL) { frame.error="seems there are no coordinates in the gro file"; return true; }
+          p2 = strchr(&p1[1], '.');
+          if (p2 == NULL) { frame.error="seems there is only one coordinates in the gro file"; return true; }
+          ddist = p2 - p1;
+          p3 = strchr(&p2[1], '.');
+          if (p3 == NULL) { frame.error="seems there are only two coordinates in the gro file"; return true; }
+          if (p3 - p2 != ddist) { frame.error="not uniform spacing in fields in the gro file"; return true; }
+        }
+        Tools::convert(line.substr(20,ddist),cc[0]);
+        Tools::convert(line.substr(20+ddist,ddist),cc[1]);
+        Tools::convert(line.substr(20+ddist+ddist,ddist),cc[2]);
+      } else plumed_error();
+      coordinates[3*i]=real(cc[0]);
+      coordinates[3*i+1]=real(cc[1]);
+      coordinates[3*i+2]=real(cc[2]);
+    }
+    if(trajectory_fmt=="gro") {
+      if(!Tools::getline(fp,line)) { frame.error="premature end of trajectory file"; return true; }
+      std::vector<string> words=Tools::getWords(line);
+      if(words.size()<3) { frame.error="cannot understand box format"; return true; }
+      for(unsigned i=0; i<9; i++) cell[i]=real(0.0);
+      Tools::convert(words[0],cell[0]);
+      Tools::convert(words[1],cell[4]);
+      Tools::convert(words[2],cell[8]);
+      if(words.size()>3) Tools::convert(words[3],cell[1]);
+      if(words.size()>4) Tools::convert(words[4],cell[2]);
+      if(words.size()>5) Tools::convert(words[5],cell[3]);
+      if(words.size()>6) Tools::convert(words[6],cell[5]);
+      if(words.size()>7) Tools::convert(words[7],cell[6]);
+      if(words.size()>8) Tools::convert(words[8],cell[7]);
+    }
+  }
+  return true;
+}
+
+/// This gives the driver the frames of the trajectory one after the other.
+/// When the number of frames to read ahead is larger than zero the frames are read
+/// by a separate thread and stored in a ring of buffers while plumed is computing.
+template<typename real>
+class DriverPipeline {
+  DriverReader<real>& reader;
+/// The ring of frames
+  std::vector<DriverFrame<real> > frames;
+/// The first frame in the ring and the number of frames that have been read
+  unsigned head, nready;
+/// Is the driver using the frame at the head of the ring
+  bool holding;
+/// Has the reader reached the end of the file or has it been asked to stop
+  bool finished, stop;
+  std::mutex mtx;
+  std::condition_variable ready, space;
+  std::thread thread;
+/// Time spent by the driver waiting for frames and time spent reading frames
+  double stall, readtime;
+  unsigned nframes;
+/// Only the first frame and the frames with index equal to offset modulo every are decoded
+  unsigned every, offset, nread;
+/// Read the next frame from the file
+  bool readFrame( DriverFrame<real>& frame );
+/// The loop done by the thread that reads the frames
+  void readLoop();
+public:
+  DriverPipeline( DriverReader<real>& r, const unsigned& nahead, const unsigned& every=1, const unsigned& offset=0 );
+  ~DriverPipeline();
+/// Stop the thread that reads the frames.  This must be done before the files are closed
+  void finish();
+/// Get the next frame.  Returns NULL at the end of the trajectory.  The frame
+/// can be used until the next call.
+  DriverFrame<real>* next();
+/// Is the trajectory being read in a separate thread
+  bool isThreaded() const { return thread.joinable(); }
+/// Time spent by the driver waiting for frames
+  double getStallTime() const { return stall; }
+/// Time spent reading and decoding frames
+  double getReadTime() const { return readtime; }
+  unsigned getNumberOfFrames() const { return nframes; }
+};
+
+template<typename real>
+DriverPipeline<real>::DriverPipeline( DriverReader<real>& r, const unsigned& nahead, const unsigned& e, const unsigned& o ):
+  reader(r),
+  frames(nahead+1),
+  head(0),
+  nready(0),
+  holding(false),
+  finished(false),
+  stop(false),
+  stall(0),
+  readtime(0),
+  nframes(0),
+  every(e),
+  offset(o),
+  nread(0)
+{
+  if( nahead>0 ) {
+    try {
+      thread=std::thread( &DriverPipeline<real>::readLoop, this );
+    } catch(const std::system_error&) {
+      // threads are not available: frames will be read when they are needed
+    }
+  }
+}
+
+template<typename real>
+DriverPipeline<real>::~DriverPipeline() {
+  finish();
+}
+
+template<typename real>
+void DriverPipeline<real>::finish() {
+  if( thread.joinable() ) {
+    { std::lock_guard<std::mutex> lk(mtx); stop=true; }
+    space.notify_one();
+    thread.join();
+  }
+}
+
+template<typename real>
+bool DriverPipeline<real>::readFrame( DriverFrame<real>& frame ) {
+  bool decode=( nread==0 || nread%every==offset ); nread++;
+  return reader.read( frame, decode );
+}
+
+template<typename real>
+void DriverPipeline<real>::readLoop() {
+  std::unique_lock<std::mutex> lk(mtx);
+  while(true) {
+    space.wait( lk, [this] { return stop || nready<frames.size(); } );
+    if( stop ) return;
+    unsigned slot=(head+nready)%frames.size();
+    lk.unlock();
+    auto t0=std::chrono::steady_clock::now();
+    bool ok=readFrame( frames[slot] );
+    std::chrono::duration<double> dt=std::chrono::steady_clock::now() - t0;
+    lk.lock();
+    readtime+=dt.count();
+    if( ok ) nready++;
+    // Nothing more is read after the end of the file or an error
+    if( !ok || !frames[slot].error.empty() ) finished=true;
+    ready.notify_one();
+    if( finished ) return;
+  }
+}
+
+template<typename real>
+DriverFrame<real>* DriverPipeline<real>::next() {
+  if( !thread.joinable() ) {
+    auto t0=std::chrono::steady_clock::now();
+    bool ok=readFrame( frames[0] );
+    std::chrono::duration<double> dt=std::chrono::steady_clock::now() - t0;
+    readtime+=dt.count(); stall+=dt.count();
+    if( !ok ) return NULL;
+    nframes++; return &frames[0];
+  }
+  std::unique_lock<std::mutex> lk(mtx);
+  if( holding ) {
+    head=(head+1)%frames.size(); nready--; holding=false;
+    space.notify_one();
+  }
+  auto t0=std::chrono::steady_clock::now();
+  ready.wait( lk, [this] { return nready>0 || finished; } );
+  std::chrono::duration<double> dt=std::chrono::steady_clock::now() - t0;
+  stall+=dt.count();
+  if( nready==0 ) return NULL;
+  holding=true; nframes++;
+  return &frames[head];
+}
+
 template<typename real>
 class Driver : public CLTool {
 public:
@@ -204,6 +598,8 @@ public:
   void evaluateNumericalDerivatives( const long int& step, Plumed& p, const std::vector<real>& coordinates,
                                      const std::vector<real>& masses, const std::vector<real>& charges,
                                      std::vector<real>& cell, const double& base, std::vector<real>& numder );
+/// Merge the files written by the processes with --parallel-frames in the order of time
+  void mergeFiles( const std::string& name, const unsigned& nfiles );
   string description()const;
 };
 
@@ -220,6 +616,10 @@ void Driver<real>::registerKeywords( Keywords& keys ) {
 #endif
           );
   keys.add("compulsory","--multi","0","set number of replicas for multi environment (needs mpi)");
+  keys.addFlag("--parallel-frames",false,"divide the frames of the trajectory between the MPI processes.  Each process runs a separate copy of plumed");
+  keys.add("optional","--merge-files","comma separated list of the files that are written by the processes when --parallel-frames is used and that should be "
+           "merged in the order of time at the end of the calculation");
+  keys.add("compulsory","--read-ahead","0","the number of frames of the trajectory that are read and decoded in a separate thread while plumed is computing");
   keys.addFlag("--noatoms",false,"don't read in a trajectory.  Just use colvar files as specified in plumed.dat");
   keys.add("atoms","--ixyz","the trajectory in xyz format");
   keys.add("atoms","--igro","the trajectory in gro format");
@@ -285,6 +685,15 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
   }
   // Are we reading trajectory data
   bool noatoms; parseFlag("--noatoms",noatoms);
+  // Are the frames divided between the processes
+  bool parallel_frames; parseFlag("--parallel-frames",parallel_frames);
+  std::vector<std::string> mergefiles;
+  if(parallel_frames) {
+    if(noatoms) error("cannot use --parallel-frames without atoms");
+    if(!Communicator::initialized() || pc.Get_size()<2) error("--parallel-frames needs mpi and more than one process");
+    std::string mergelist; parse("--merge-files",mergelist);
+    if(mergelist.length()>0) mergefiles=Tools::getWords(mergelist,",");
+  }
 
   std::string fakein;
   bool debugfloat=parse("--debug-float",fakein);
@@ -299,11 +708,17 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
   bool debug_dd=parse("--debug-dd",fakein);
   if( debug_pd || debug_dd ) {
     if(noatoms) error("cannot debug without atoms");
+    if(parallel_frames) error("cannot debug domain/particle decomposition with --parallel-frames");
   }
 
 // set up for multi replica driver:
   int multi=0;
   parse("--multi",multi);
+// with --parallel-frames each process is a separate replica that reads the same trajectory
+  if(parallel_frames) {
+    if(multi) error("cannot use --multi and --parallel-frames at the same time");
+    multi=pc.Get_size();
+  }
   Communicator intracomm;
   Communicator intercomm;
   if(multi) {
@@ -322,6 +737,7 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
   FILE*grex_log=NULL;
   if(debug_grex) {
     if(noatoms) error("must have atoms to debug_grex");
+    if(parallel_frames) error("cannot debug replica exchange with --parallel-frames");
     if(multi<2)  error("--debug_grex needs --multi with at least two replicas");
     Tools::convert(fakein,grex_stride);
     string n; Tools::convert(intercomm.Get_rank(),n);
@@ -351,6 +767,7 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
   if(dumpforces!="") parseFlag("--dump-full-virial",dumpfullvirial);
   if( debugforces!="" && (debug_dd || debug_pd) ) error("cannot debug forces and domain/particle decomposition at same time");
   if( debugforces!="" && sizeof(real)!=sizeof(double) ) error("cannot debug forces in single precision mode");
+  if( debugforces!="" && parallel_frames ) error("cannot debug forces with --parallel-frames");
 
   real kt=-1.0;
   parse("--kt",kt);
@@ -360,18 +777,13 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
 #ifdef __PLUMED_HAS_MOLFILE_PLUGINS
   molfile_plugin_t *api=NULL;
   void *h_in=NULL;
-  molfile_timestep_t ts_in; // this is the structure that has the timestep
-// a std::unique_ptr<float> with the same scope as ts_in
-// it is necessary in order to store the pointer to ts_in.coords
-  std::unique_ptr<float[]> ts_in_coords;
-  ts_in.coords=ts_in_coords.get();
-  ts_in.A=-1; // we use this to check whether cell is provided or not
 #endif
 
 // Read in an xyz file
   string trajectoryFile(""), pdbfile(""), mcfile("");
   bool pbc_cli_given=false; vector<double> pbc_cli_box(9,0.0);
   int command_line_natoms=-1;
+  unsigned readahead=0;
 
   if(!noatoms) {
     std::string traj_xyz; parse("--ixyz",traj_xyz);
@@ -461,6 +873,7 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
     }
 
     parse("--natoms",command_line_natoms);
+    parse("--read-ahead",readahead);
 
   }
 
@@ -470,7 +883,9 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
     if( !Communicator::initialized() ) error("needs mpi for debug-pd");
   }
 
-  Plumed p;
+// this is a pointer so that plumed can be finalized before the output files are merged
+  std::unique_ptr<Plumed> plumed_ptr(new Plumed);
+  Plumed& p(*plumed_ptr);
   int rr=sizeof(real);
   p.cmd("setRealPrecision",&rr);
   int checknatoms=-1;
@@ -500,10 +915,11 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
   XDRFILE* xd=NULL;
 #endif
   if(!noatoms) {
-    if (trajectoryFile=="-")
+    if (trajectoryFile=="-") {
+      if(parallel_frames) error("cannot read the trajectory from standard input with --parallel-frames");
       fp=in;
-    else {
-      if(multi) {
+    } else {
+      if(multi && !parallel_frames) {
         string n;
         Tools::convert(intercomm.Get_rank(),n);
         std::string testfile=FileBase::appendSuffix(trajectoryFile,"."+n);
@@ -517,8 +933,6 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
           if(command_line_natoms>=0) natoms=command_line_natoms;
           else error("this file format does not provide number of atoms; use --natoms on the command line");
         }
-        ts_in_coords.reset(new float [3*natoms]);
-        ts_in.coords = ts_in_coords.get();
 #endif
       } else if(trajectory_fmt=="xdr-xtc" || trajectory_fmt=="xdr-trr") {
 #ifdef __PLUMED_HAS_XDRFILE
@@ -558,7 +972,28 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
     }
   }
 
-  std::string line;
+  DriverReader<real> reader;
+  if(!noatoms) {
+    reader.trajectory_fmt=trajectory_fmt;
+    reader.use_molfile=use_molfile;
+    reader.fp=fp;
+#ifdef __PLUMED_HAS_MOLFILE_PLUGINS
+    reader.api=api; reader.h_in=h_in;
+#endif
+#ifdef __PLUMED_HAS_XDRFILE
+    reader.xd=xd;
+#endif
+    if(use_molfile || trajectory_fmt=="xdr-xtc" || trajectory_fmt=="xdr-trr") reader.setNatoms(natoms);
+    reader.pbc_cli_given=pbc_cli_given;
+    reader.pbc_cli_box=pbc_cli_box;
+  }
+// the frames are read in a separate thread if required
+  unsigned nparallel=1, frame_offset=0;
+  if(parallel_frames) { nparallel=pc.Get_size(); frame_offset=pc.Get_rank(); }
+  DriverPipeline<real> pipeline( reader, noatoms ? 0 : readahead, nparallel, frame_offset );
+  if(readahead>0 && !noatoms && !pipeline.isThreaded()) fprintf(out,"\nDRIVER: threads are not available, frames will not be read ahead\n");
+  DriverFrame<real>* frame=NULL;
+
   std::vector<real> coordinates;
   std::vector<real> forces;
   std::vector<real> masses;
@@ -581,31 +1016,14 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
 // random stream to choose decompositions
   Random rnd;
 
+  unsigned iframe=0;
   while(true) {
-    if(!noatoms) {
-      if(use_molfile==true) {
-#ifdef __PLUMED_HAS_MOLFILE_PLUGINS
-        int rc;
-        rc = api->read_next_timestep(h_in, natoms, &ts_in);
-        //if(rc==MOLFILE_SUCCESS){
-        //       printf(" read this one :success \n");
-        //}
-        if(rc==MOLFILE_EOF) {
-          //printf(" read this one :eof or error \n");
-          break;
-        }
-#endif
-      } else if(trajectory_fmt=="xyz" || trajectory_fmt=="gro") {
-        if(!Tools::getline(fp,line)) break;
-      }
-    }
-
     bool first_step=false;
     if(!noatoms) {
-      if(use_molfile==false && (trajectory_fmt=="xyz" || trajectory_fmt=="gro")) {
-        if(trajectory_fmt=="gro") if(!Tools::getline(fp,line)) error("premature end of trajectory file");
-        sscanf(line.c_str(),"%100d",&natoms);
-      }
+      frame=pipeline.next();
+      if(!frame) break;
+      if(!frame->error.empty()) error(frame->error);
+      natoms=frame->natoms;
     }
     if(checknatoms<0 && !noatoms) {
       pd_nlocal=natoms;
@@ -647,6 +1065,11 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
       std::string stepstr; Tools::convert(step,stepstr);
       error("number of atoms in frame " + stepstr + " does not match number of atoms in first frame");
     }
+// the frames that belong to the other processes are skipped
+    if(parallel_frames) {
+      bool skip=( iframe%nparallel!=frame_offset ); iframe++;
+      if(skip) { step+=stride; continue; }
+    }
 
     coordinates.assign(3*natoms,real(0.0));
     forces.assign(3*natoms,real(0.0));
@@ -708,130 +1131,15 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
 
     int plumedStopCondition=0;
     if(!noatoms) {
-      if(use_molfile) {
-#ifdef __PLUMED_HAS_MOLFILE_PLUGINS
-        if(pbc_cli_given==false) {
-          if(ts_in.A>0.0) { // this is negative if molfile does not provide box
-            // info on the cell: convert using pbcset.tcl from pbctools in vmd distribution
-            real cosBC=cos(ts_in.alpha*pi/180.);
-            //double sinBC=sin(ts_in.alpha*pi/180.);
-            real cosAC=cos(ts_in.beta*pi/180.);
-            real cosAB=cos(ts_in.gamma*pi/180.);
-            real sinAB=sin(ts_in.gamma*pi/180.);
-            real Ax=ts_in.A;
-            real Bx=ts_in.B*cosAB;
-            real By=ts_in.B*sinAB;
-            real Cx=ts_in.C*cosAC;
-            real Cy=(ts_in.C*ts_in.B*cosBC-Cx*Bx)/By;
-            real Cz=sqrt(ts_in.C*ts_in.C-Cx*Cx-Cy*Cy);
-            cell[0]=Ax/10.; cell[1]=0.; cell[2]=0.;
-            cell[3]=Bx/10.; cell[4]=By/10.; cell[5]=0.;
-            cell[6]=Cx/10.; cell[7]=Cy/10.; cell[8]=Cz/10.;
-          } else {
-            cell[0]=0.0; cell[1]=0.0; cell[2]=0.0;
-            cell[3]=0.0; cell[4]=0.0; cell[5]=0.0;
-            cell[6]=0.0; cell[7]=0.0; cell[8]=0.0;
-          }
-        } else {
-          for(unsigned i=0; i<9; i++)cell[i]=pbc_cli_box[i];
-        }
-        // info on coords
-        // the order is xyzxyz...
-        for(int i=0; i<3*natoms; i++) {
-          coordinates[i]=real(ts_in.coords[i]/10.); //convert to nm
-          //cerr<<"COOR "<<coordinates[i]<<endl;
-        }
-#endif
-      } else if(trajectory_fmt=="xdr-xtc" || trajectory_fmt=="xdr-trr") {
-#ifdef __PLUMED_HAS_XDRFILE
-        int localstep;
-        float time;
-        matrix box;
-        std::unique_ptr<rvec[]> pos(new rvec[natoms]);
-        float prec,lambda;
-        int ret=exdrOK;
-        if(trajectory_fmt=="xdr-xtc") ret=read_xtc(xd,natoms,&localstep,&time,box,pos.get(),&prec);
-        if(trajectory_fmt=="xdr-trr") ret=read_trr(xd,natoms,&localstep,&time,&lambda,box,pos.get(),NULL,NULL);
-        if(stride==0) step=localstep;
-        if(ret==exdrENDOFFILE) break;
-        if(ret!=exdrOK) break;
-        for(unsigned i=0; i<3; i++) for(unsigned j=0; j<3; j++) cell[3*i+j]=box[i][j];
-        for(int i=0; i<natoms; i++) for(unsigned j=0; j<3; j++)
-            coordinates[3*i+j]=real(pos[i][j]);
-#endif
-      } else {
-        if(trajectory_fmt=="xyz") {
-          if(!Tools::getline(fp,line)) error("premature end of trajectory file");
-
-          std::vector<double> celld(9,0.0);
-          if(pbc_cli_given==false) {
-            std::vector<std::string> words;
-            words=Tools::getWords(line);
-            if(words.size()==3) {
-              sscanf(line.c_str(),"%100lf %100lf %100lf",&celld[0],&celld[4],&celld[8]);
-            } else if(words.size()==9) {
-              sscanf(line.c_str(),"%100lf %100lf %100lf %100lf %100lf %100lf %100lf %100lf %100lf",
-                     &celld[0], &celld[1], &celld[2],
-                     &celld[3], &celld[4], &celld[5],
-                     &celld[6], &celld[7], &celld[8]);
-            } else error("needed box in second line of xyz file");
-          } else {			// from command line
-            celld=pbc_cli_box;
-          }
-          for(unsigned i=0; i<9; i++)cell[i]=real(celld[i]);
-        }
-        int ddist=0;
-        // Read coordinates
-        for(int i=0; i<natoms; i++) {
-          bool ok=Tools::getline(fp,line);
-          if(!ok) error("premature end of trajectory file");
-          double cc[3];
-          if(trajectory_fmt=="xyz") {
-            char dummy[1000];
-            int ret=std::sscanf(line.c_str(),"%999s %100lf %100lf %100lf",dummy,&cc[0],&cc[1],&cc[2]);
-            if(ret!=4) error("cannot read line"+line);
-          } else if(trajectory_fmt=="gro") {
-            // do the gromacs way
-            if(!i) {
-              //
-              // calculate the distance between dots (as in gromacs gmxlib/confio.c, routine get_w_conf )
-              //
-              const char      *p1, *p2, *p3;
-              p1 = strchr(line.c_str(), '.');
-              if (p1 == NULL) error("seems there are no coordinates in the gro file");
-              p2 = strchr(&p1[1], '.');
-              if (p2 == NULL) error("seems there is only one coordinates in the gro file");
-              ddist = p2 - p1;
-              p3 = strchr(&p2[1], '.');
-              if (p3 == NULL)error("seems there are only two coordinates in the gro file");
-              if (p3 - p2 != ddist)error("not uniform spacing in fields in the gro file");
-            }
-            Tools::convert(line.substr(20,ddist),cc[0]);
-            Tools::convert(line.substr(20+ddist,ddist),cc[1]);
-            Tools::convert(line.substr(20+ddist+ddist,ddist),cc[2]);
-          } else plumed_error();
-          if(!debug_pd || ( i>=pd_start && i<pd_start+pd_nlocal) ) {
-            coordinates[3*i]=real(cc[0]);
-            coordinates[3*i+1]=real(cc[1]);
-            coordinates[3*i+2]=real(cc[2]);
-          }
-        }
-        if(trajectory_fmt=="gro") {
-          if(!Tools::getline(fp,line)) error("premature end of trajectory file");
-          std::vector<string> words=Tools::getWords(line);
-          if(words.size()<3) error("cannot understand box format");
-          Tools::convert(words[0],cell[0]);
-          Tools::convert(words[1],cell[4]);
-          Tools::convert(words[2],cell[8]);
-          if(words.size()>3) Tools::convert(words[3],cell[1]);
-          if(words.size()>4) Tools::convert(words[4],cell[2]);
-          if(words.size()>5) Tools::convert(words[5],cell[3]);
-          if(words.size()>6) Tools::convert(words[6],cell[5]);
-          if(words.size()>7) Tools::convert(words[7],cell[6]);
-          if(words.size()>8) Tools::convert(words[8],cell[7]);
-        }
-
+// the frame gets the old buffers, that are overwritten when the next frame is read
+      coordinates.swap(frame->coordinates);
+      cell.swap(frame->cell);
+// with particle decomposition only the local atoms are known to this process
+      if(debug_pd) {
+        for(int i=0; i<3*pd_start; i++) coordinates[i]=real(0.0);
+        for(int i=3*(pd_start+pd_nlocal); i<3*natoms; i++) coordinates[i]=real(0.0);
       }
+      if(stride==0) step=frame->step;
 
       p.cmd("setStepLong",&step);
       p.cmd("setStopFlag",&plumedStopCondition);
@@ -943,6 +1251,12 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
   }
   p.cmd("runFinalJobs");
 
+  if(readahead>0 && !noatoms && pc.Get_rank()==0) {
+    fprintf(out,"\nDRIVER: read %u frames reading ahead by %u frames\n",pipeline.getNumberOfFrames(),readahead);
+    fprintf(out,"DRIVER: %f seconds spent reading the trajectory, %f seconds spent waiting for frames\n",pipeline.getReadTime(),pipeline.getStallTime());
+  }
+  pipeline.finish();
+
   if(fp_forces) fclose(fp_forces);
   if(debugforces.length()>0) fp_dforces.close();
   if(fp && fp!=in)fclose(fp);
@@ -954,9 +1268,55 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
 #endif
   if(grex_log) fclose(grex_log);
 
+  if(parallel_frames) {
+    plumed_ptr.reset();
+    pc.Barrier();
+    if(pc.Get_rank()==0) for(unsigned i=0; i<mergefiles.size(); ++i) mergeFiles( mergefiles[i], pc.Get_size() );
+  }
+
   return 0;
 }
 
+template<typename real>
+void Driver<real>::mergeFiles( const std::string& name, const unsigned& nfiles ) {
+  std::vector<std::unique_ptr<IFile> > ifiles( nfiles );
+  std::vector<std::string> fnames( nfiles ), lines( nfiles );
+  std::vector<double> times( nfiles );
+  std::vector<bool> active( nfiles, false );
+  OFile ofile; ofile.open( name );
+  for(unsigned i=0; i<nfiles; ++i) {
+    std::string n; Tools::convert(i,n);
+    fnames[i]=FileBase::appendSuffix(name,"."+n);
+    ifiles[i].reset( new IFile );
+    if( !ifiles[i]->FileExist(fnames[i]) ) error("cannot find file " + fnames[i] + " to merge");
+    ifiles[i]->open( fnames[i] );
+  }
+  // The comments are only copied from the file of the first process
+  auto nextLine=[&]( const unsigned& i ) {
+    active[i]=false;
+    while( ifiles[i]->getline( lines[i] ) ) {
+      if( lines[i].length()==0 ) continue;
+      if( lines[i][0]=='#' ) { if( i==0 ) ofile.printf("%s\n",lines[i].c_str()); continue; }
+      const char* start=lines[i].c_str(); char* end;
+      times[i]=std::strtod( start, &end );
+      if( end==start ) error("cannot merge file " + fnames[i] + ": all the lines should start with the time");
+      active[i]=true; break;
+    }
+  };
+  for(unsigned i=0; i<nfiles; ++i) nextLine( i );
+  while(true) {
+    int imin=-1;
+    for(unsigned i=0; i<nfiles; ++i) {
+      if( active[i] && (imin<0 || times[i]<times[imin]) ) imin=i;
+    }
+    if( imin<0 ) break;
+    ofile.printf("%s\n",lines[imin].c_str());
+    nextLine( imin );
+  }
+  ofile.close();
+  for(unsigned i=0; i<nfiles; ++i) { ifiles[i]->close(); std::remove( fnames[i].c_str() ); }
+}
+
 template<typename real>
 void Driver<real>::evaluateNumericalDerivatives( const long int& step, Plumed& p, const std::vector<real>& coordinates,
     const std::vector<real>& masses, const std::vector<real>& charges,
@@ -24,11 +24,14 @@
 #include "wrapper/Plumed.h"
 #include "tools/Vector.h"
 #include "tools/Random.h"
+#include "tools/OpenMP.h"
+#include "tools/Communicator.h"
 #include <string>
 #include <cstdio>
 #include <cmath>
 #include <vector>
 #include <memory>
+#include <algorithm>
 
 using namespace std;
 
@@ -71,6 +74,22 @@ input file will be output.
 plumed simplemd --help
 \endverbatim
 
+When the box is at least three times larger than listcutoff the neighbour list is
+built using link cells, so that large systems can be simulated. Forces are computed
+using the number of OpenMP threads set with the PLUMED_NUM_THREADS environment variable.
+
+If simplemd is run with MPI and the directive domaindecomposition is set to true,
+the box is divided in slabs along x and each process computes the forces acting
+on the atoms in its own slab. Every process still stores the whole system, but only the atoms
+that are in its slab are passed to PLUMED with setAtomsNlocal and setAtomsGatindex,
+as is done by MD codes that use domain decomposition. This allows one to test the
+parallel parts of PLUMED without an external MD code. Since the standard input
+might only be available on the first process, the input file should then be passed
+as an argument:
+\verbatim
+mpirun -np 4 plumed simplemd in
+\endverbatim
+
 */
 //+ENDPLUMEDOC
 
@@ -103,6 +122,7 @@ public:
     keys.add("compulsory","idum","0","The random number seed");
     keys.add("compulsory","ndim","3","The dimensionality of the system (some interesting LJ clusters are two dimensional)");
     keys.add("compulsory","wrapatoms","false","If true, atomic coordinates are written wrapped in minimal cell");
+    keys.add("compulsory","domaindecomposition","false","If true, the box is divided in slabs along x between the MPI processes and only the atoms in its slab are passed to PLUMED by each process");
   }
 
   explicit SimpleMD( const CLToolOptions& co ) :
@@ -127,6 +147,7 @@ private:
              int&    nconfig,
              int&    nstat,
              bool&   wrapatoms,
+             bool&   domaindecomposition,
              string& inputfile,
              string& outputfile,
              string& trajfile,
@@ -186,6 +207,10 @@ private:
     parse("wrapatoms",w);
     wrapatoms=false;
     if(w.length()>0 && (w[0]=='T' || w[0]=='t')) wrapatoms=true;
+    std::string dd;
+    parse("domaindecomposition",dd);
+    domaindecomposition=false;
+    if(dd.length()>0 && (dd[0]=='T' || dd[0]=='t')) domaindecomposition=true;
   }
 
   void read_natoms(const string & inputfile,int & natoms) {
@@ -249,65 +274,164 @@ private:
   }
 
 
+  int domain(const double cell[3],const Vector & pos,const int ndomains) {
+// index of the slab along x containing position pos
+    double s=pos[0]/cell[0];
+    s-=floor(s);
+    int d=int(s*ndomains);
+    return (d<ndomains?d:ndomains-1);
+  }
+
   void compute_list(const int natoms,const int listsize,const vector<Vector>& positions,const double cell[3],const double listcutoff,
-                    vector<int>& point,vector<int>& list) {
+                    const vector<char>& owned,vector<int>& point,vector<int>& list) {
 // see Allen-Tildesey for a definition of point and list
-    Vector distance;     // distance of the two atoms
-    Vector distance_pbc; // minimum-image distance of the two atoms
+// only atoms for which owned is true have neighbours in the list
+// neighbours are stored in increasing order, so that the list does not depend on how it is built
     double listcutoff2;  // squared list cutoff
     listcutoff2=listcutoff*listcutoff;
-    point[0]=0;
-    for(int iatom=0; iatom<natoms-1; iatom++) {
-      point[iatom+1]=point[iatom];
-      for(int jatom=iatom+1; jatom<natoms; jatom++) {
-        for(int k=0; k<3; k++) distance[k]=positions[iatom][k]-positions[jatom][k];
-        pbc(cell,distance,distance_pbc);
+// link cells are used if there are at least three of them in each direction,
+// otherwise all pairs are checked
+    int ncell[3];
+    bool linkcells=true;
+    for(int k=0; k<3; k++) {
+      ncell[k]=int(floor(cell[k]/listcutoff));
+      if(ncell[k]<3) linkcells=false;
+    }
+    vector<int> cellstart, cellatoms;
+    if(linkcells) {
+// atoms are sorted by cell, keeping them in increasing order within each cell
+      vector<int> atomcell(natoms);
+      cellstart.assign(ncell[0]*ncell[1]*ncell[2]+1,0);
+      for(int iatom=0; iatom<natoms; iatom++) {
+        int c[3];
+        for(int k=0; k<3; k++) {
+          double s=positions[iatom][k]/cell[k];
+          s-=floor(s);
+          c[k]=int(s*ncell[k]);
+          if(c[k]>=ncell[k]) c[k]=ncell[k]-1;
+        }
+        atomcell[iatom]=(c[0]*ncell[1]+c[1])*ncell[2]+c[2];
+        cellstart[atomcell[iatom]+1]++;
+      }
+      for(unsigned c=1; c<cellstart.size(); c++) cellstart[c]+=cellstart[c-1];
+      vector<int> fill(cellstart.begin(),cellstart.end()-1);
+      cellatoms.resize(natoms);
+      for(int iatom=0; iatom<natoms; iatom++) cellatoms[fill[atomcell[iatom]]++]=iatom;
+    }
+
+// each thread builds the list for a contiguous block of atoms, and the blocks are then joined in order
+    unsigned nt=OpenMP::getNumThreads();
+    vector<vector<int> > threadlist(nt);
+    vector<int> nneigh(natoms,0);
+    #pragma omp parallel num_threads(nt)
+    {
+      vector<int>& mylist(threadlist[OpenMP::getThreadNum()]);
+      vector<int> neigh;
+      Vector distance;     // distance of the two atoms
+      Vector distance_pbc; // minimum-image distance of the two atoms
+      #pragma omp for schedule(static)
+      for(int iatom=0; iatom<natoms-1; iatom++) {
+        if(!owned[iatom]) continue;
+        neigh.clear();
+        if(linkcells) {
+          int c[3];
+          for(int k=0; k<3; k++) {
+            double s=positions[iatom][k]/cell[k];
+            s-=floor(s);
+            c[k]=int(s*ncell[k]);
+            if(c[k]>=ncell[k]) c[k]=ncell[k]-1;
+          }
+          for(int dx=-1; dx<=1; dx++) for(int dy=-1; dy<=1; dy++) for(int dz=-1; dz<=1; dz++) {
+                int cx=(c[0]+dx+ncell[0])%ncell[0];
+                int cy=(c[1]+dy+ncell[1])%ncell[1];
+                int cz=(c[2]+dz+ncell[2])%ncell[2];
+                int cc=(cx*ncell[1]+cy)*ncell[2]+cz;
+                for(int j=cellstart[cc]; j<cellstart[cc+1]; j++) {
+                  int jatom=cellatoms[j];
+                  if(jatom<=iatom) continue;
+                  for(int k=0; k<3; k++) distance[k]=positions[iatom][k]-positions[jatom][k];
+                  pbc(cell,distance,distance_pbc);
+                  double d2=0; for(int k=0; k<3; k++) d2+=distance_pbc[k]*distance_pbc[k];
+                  if(d2>listcutoff2)continue;
+                  neigh.push_back(jatom);
+                }
+              }
+          std::sort(neigh.begin(),neigh.end());
+        } else {
+          for(int jatom=iatom+1; jatom<natoms; jatom++) {
+            for(int k=0; k<3; k++) distance[k]=positions[iatom][k]-positions[jatom][k];
+            pbc(cell,distance,distance_pbc);
 // if the interparticle distance is larger than the cutoff, skip
-        double d2=0; for(int k=0; k<3; k++) d2+=distance_pbc[k]*distance_pbc[k];
-        if(d2>listcutoff2)continue;
-        if(point[iatom+1]>listsize) {
-// too many neighbours
-          fprintf(stderr,"%s","Verlet list size exceeded\n");
-          fprintf(stderr,"%s","Increase maxneighbours\n");
-          exit(1);
+            double d2=0; for(int k=0; k<3; k++) d2+=distance_pbc[k]*distance_pbc[k];
+            if(d2>listcutoff2)continue;
+            neigh.push_back(jatom);
+          }
         }
-        list[point[iatom+1]]=jatom;
-        point[iatom+1]++;
+        nneigh[iatom]=neigh.size();
+        mylist.insert(mylist.end(),neigh.begin(),neigh.end());
       }
     }
+
+    point[0]=0;
+    for(int iatom=0; iatom<natoms-1; iatom++) point[iatom+1]=point[iatom]+nneigh[iatom];
+    if(natoms>0 && point[natoms-1]>listsize) {
+// too many neighbours
+      fprintf(stderr,"%s","Verlet list size exceeded\n");
+      fprintf(stderr,"%s","Increase maxneighbours\n");
+      exit(1);
+    }
+    int pos=0;
+    for(unsigned it=0; it<nt; it++) {
+      std::copy(threadlist[it].begin(),threadlist[it].end(),list.begin()+pos);
+      pos+=threadlist[it].size();
+    }
   }
 
   void compute_forces(const int natoms,const int listsize,const vector<Vector>& positions,const double cell[3],
                       double forcecutoff,const vector<int>& point,const vector<int>& list,vector<Vector>& forces,double & engconf)
   {
-    Vector distance;        // distance of the two atoms
-    Vector distance_pbc;    // minimum-image distance of the two atoms
-    double distance_pbc2;   // squared minimum-image distance
     double forcecutoff2;    // squared force cutoff
-    Vector f;               // force
     double engcorrection;   // energy necessary shift the potential avoiding discontinuities
 
     forcecutoff2=forcecutoff*forcecutoff;
     engconf=0.0;
     for(int i=0; i<natoms; i++)for(int k=0; k<3; k++) forces[i][k]=0.0;
     engcorrection=4.0*(1.0/pow(forcecutoff2,6.0)-1.0/pow(forcecutoff2,3));
-    for(int iatom=0; iatom<natoms-1; iatom++) {
-      for(int jlist=point[iatom]; jlist<point[iatom+1]; jlist++) {
-        int jatom=list[jlist];
-        for(int k=0; k<3; k++) distance[k]=positions[iatom][k]-positions[jatom][k];
-        pbc(cell,distance,distance_pbc);
-        distance_pbc2=0.0; for(int k=0; k<3; k++) distance_pbc2+=distance_pbc[k]*distance_pbc[k];
+// with more than one thread each thread accumulates the forces in a private array
+// atoms are distributed in small chunks since the later atoms have shorter lists
+    unsigned nt=OpenMP::getNumThreads();
+    #pragma omp parallel num_threads(nt)
+    {
+      Vector distance;        // distance of the two atoms
+      Vector distance_pbc;    // minimum-image distance of the two atoms
+      double distance_pbc2;   // squared minimum-image distance
+      Vector f;               // force
+      vector<Vector> omp_forces;
+      if(nt>1) omp_forces.resize(natoms);
+      vector<Vector>& myforces(nt>1?omp_forces:forces);
+      #pragma omp for reduction(+:engconf) schedule(static,64)
+      for(int iatom=0; iatom<natoms-1; iatom++) {
+        for(int jlist=point[iatom]; jlist<point[iatom+1]; jlist++) {
+          int jatom=list[jlist];
+          for(int k=0; k<3; k++) distance[k]=positions[iatom][k]-positions[jatom][k];
+          pbc(cell,distance,distance_pbc);
+          distance_pbc2=0.0; for(int k=0; k<3; k++) distance_pbc2+=distance_pbc[k]*distance_pbc[k];
 // if the interparticle distance is larger than the cutoff, skip
-        if(distance_pbc2>forcecutoff2) continue;
-        double distance_pbc6=distance_pbc2*distance_pbc2*distance_pbc2;
-        double distance_pbc8=distance_pbc6*distance_pbc2;
-        double distance_pbc12=distance_pbc6*distance_pbc6;
-        double distance_pbc14=distance_pbc12*distance_pbc2;
-        engconf+=4.0*(1.0/distance_pbc12 - 1.0/distance_pbc6) - engcorrection;
-        for(int k=0; k<3; k++) f[k]=2.0*distance_pbc[k]*4.0*(6.0/distance_pbc14-3.0/distance_pbc8);
+          if(distance_pbc2>forcecutoff2) continue;
+          double distance_pbc6=distance_pbc2*distance_pbc2*distance_pbc2;
+          double distance_pbc8=distance_pbc6*distance_pbc2;
+          double distance_pbc12=distance_pbc6*distance_pbc6;
+          double distance_pbc14=distance_pbc12*distance_pbc2;
+          engconf+=4.0*(1.0/distance_pbc12 - 1.0/distance_pbc6) - engcorrection;
+          for(int k=0; k<3; k++) f[k]=2.0*distance_pbc[k]*4.0*(6.0/distance_pbc14-3.0/distance_pbc8);
 // same force on the two atoms, with opposite sign:
-        for(int k=0; k<3; k++) forces[iatom][k]+=f[k];
-        for(int k=0; k<3; k++) forces[jatom][k]-=f[k];
+          for(int k=0; k<3; k++) myforces[iatom][k]+=f[k];
+          for(int k=0; k<3; k++) myforces[jatom][k]-=f[k];
+        }
+      }
+      if(nt>1) {
+        #pragma omp critical
+        for(int i=0; i<natoms; i++) forces[i]+=omp_forces[i];
       }
     }
   }
@@ -431,6 +555,7 @@ private:
     int         idum;              // seed
     int         plumedWantsToStop; // stop flag
     bool        wrapatoms;         // if true, atomic coordinates are written wrapped in minimal cell
+    bool        domaindecomposition; // if true, forces and atoms passed to plumed are divided between processes
     string      inputfile;         // name of file with starting configuration (xyz)
     string      outputfile;        // name of file with final configuration (xyz)
     string      trajfile;          // name of the trajectory file (xyz)
@@ -442,6 +567,16 @@ private:
 
     bool recompute_list;           // control if the neighbour list have to be recomputed
 
+// domain decomposition variables
+    int            ndomains=1;   // number of slabs, one per process
+    int            mydomain=0;   // slab of this process
+    vector<char>   owned;        // atoms whose neighbours are in the list of this process
+    vector<int>    gatindex;     // global indexes of the atoms passed to plumed by this process
+    vector<Vector> lpositions;   // positions of the atoms passed to plumed
+    vector<Vector> lforces;      // forces on the atoms passed to plumed
+    vector<double> lmasses;      // masses of the atoms passed to plumed
+    vector<Vector> bforces;      // forces added by plumed on all the atoms
+
     Random random;                 // random numbers stream
 
     std::unique_ptr<Plumed> plumed;
@@ -456,9 +591,16 @@ private:
 
     read_input(temperature,tstep,friction,forcecutoff,
                listcutoff,nstep,nconfig,nstat,
-               wrapatoms,inputfile,outputfile,trajfile,statfile,
+               wrapatoms,domaindecomposition,inputfile,outputfile,trajfile,statfile,
                maxneighbour,ndim,idum);
 
+    if(domaindecomposition) {
+      ndomains=pc.Get_size();
+      mydomain=pc.Get_rank();
+// only the first process writes
+      if(mydomain>0) out=fopen("/dev/null","w");
+    }
+
 // number of atoms is read from file inputfile
     read_natoms(inputfile,natoms);
 
@@ -480,6 +622,7 @@ private:
     fprintf(out,"%s %d\n","Dimensionality                   :",ndim);
     fprintf(out,"%s %d\n","Seed                             :",idum);
     fprintf(out,"%s %s\n","Are atoms wrapped on output?     :",(wrapatoms?"T":"F"));
+    fprintf(out,"%s %d\n","Number of domains                :",ndomains);
 
 // Setting the seed
     random.setSeed(idum);
@@ -496,6 +639,7 @@ private:
     masses.resize(natoms);
     point.resize(natoms);
     list.resize(listsize);
+    owned.assign(natoms,1);
 
 // masses are hard-coded to 1
     for(int i=0; i<natoms; ++i) masses[i]=1.0;
@@ -523,17 +667,24 @@ private:
       if(pversion>1) {
         plumed->cmd("setKbT",&temperature);
       }
+      if(domaindecomposition && Communicator::initialized()) plumed->cmd("setMPIComm",&pc.Get_comm());
       plumed->cmd("init");
     }
 
 // neighbour list are computed, and reference positions are saved
-    compute_list(natoms,listsize,positions,cell,listcutoff,point,list);
+// with domain decomposition, each process has in its list the atoms in its slab
+    if(domaindecomposition) for(int iatom=0; iatom<natoms; ++iatom) owned[iatom]=(domain(cell,positions[iatom],ndomains)==mydomain);
+    compute_list(natoms,listsize,positions,cell,listcutoff,owned,point,list);
 
     fprintf(out,"List size: %d\n",point[natoms-1]);
     for(int iatom=0; iatom<natoms; ++iatom) for(int k=0; k<3; ++k) positions0[iatom][k]=positions[iatom][k];
 
 // forces are computed before starting md
     compute_forces(natoms,listsize,positions,cell,forcecutoff,point,list,forces,engconf);
+    if(domaindecomposition) {
+      pc.Sum(&forces[0][0],3*natoms);
+      pc.Sum(engconf);
+    }
 
 // remove forces if ndim<3
     if(ndim<3)
@@ -562,15 +713,62 @@ private:
 // a check is performed to decide whether to recalculate the neighbour list
       check_list(natoms,positions,positions0,listcutoff,forcecutoff,recompute_list);
       if(recompute_list) {
-        compute_list(natoms,listsize,positions,cell,listcutoff,point,list);
+        if(domaindecomposition) for(int iatom=0; iatom<natoms; ++iatom) owned[iatom]=(domain(cell,positions[iatom],ndomains)==mydomain);
+        compute_list(natoms,listsize,positions,cell,listcutoff,owned,point,list);
         for(int iatom=0; iatom<natoms; ++iatom) for(int k=0; k<3; ++k) positions0[iatom][k]=positions[iatom][k];
         fprintf(out,"Neighbour list recomputed at step %d\n",istep);
         fprintf(out,"List size: %d\n",point[natoms-1]);
       }
 
       compute_forces(natoms,listsize,positions,cell,forcecutoff,point,list,forces,engconf);
+// with domain decomposition, forces are summed over the processes but
+// plumed receives the energy computed by this process only
+      double englocal=engconf;
+      if(domaindecomposition) {
+        pc.Sum(&forces[0][0],3*natoms);
+        pc.Sum(engconf);
+      }
 
-      if(plumed) {
+      if(plumed && domaindecomposition) {
+        int istepplusone=istep+1;
+        plumedWantsToStop=0;
+        for(int i=0; i<3; i++)for(int k=0; k<3; k++) cell9[i][k]=0.0;
+        for(int i=0; i<3; i++) cell9[i][i]=cell[i];
+// atoms currently in the slab of this process are passed to plumed;
+// as in MD codes, the local indexes are only updated when they change
+// on some process (setAtomsGatindex should be called by all of them)
+        vector<int> newgatindex;
+        for(int iatom=0; iatom<natoms; iatom++) if(domain(cell,positions[iatom],ndomains)==mydomain) newgatindex.push_back(iatom);
+        int nlocal=newgatindex.size();
+        int changed=(istep==0 || newgatindex!=gatindex);
+        pc.Sum(changed);
+        if(changed>0) {
+          gatindex.swap(newgatindex);
+          plumed->cmd("setAtomsNlocal",&nlocal);
+          plumed->cmd("setAtomsGatindex",gatindex.data());
+        }
+        lpositions.resize(nlocal);
+        lmasses.resize(nlocal);
+        lforces.assign(nlocal,Vector(0.0,0.0,0.0));
+        for(int i=0; i<nlocal; i++) {
+          lpositions[i]=positions[gatindex[i]];
+          lmasses[i]=masses[gatindex[i]];
+        }
+        plumed->cmd("setStep",&istepplusone);
+        plumed->cmd("setMasses",lmasses.data());
+        plumed->cmd("setForces",lforces.data());
+        plumed->cmd("setEnergy",&englocal);
+        plumed->cmd("setPositions",lpositions.data());
+        plumed->cmd("setBox",cell9);
+        plumed->cmd("setStopFlag",&plumedWantsToStop);
+        plumed->cmd("calc");
+// forces added by plumed on the local atoms are shared with all the processes
+        bforces.assign(natoms,Vector(0.0,0.0,0.0));
+        for(int i=0; i<nlocal; i++) bforces[gatindex[i]]=lforces[i];
+        pc.Sum(&bforces[0][0],3*natoms);
+        for(int iatom=0; iatom<natoms; iatom++) forces[iatom]+=bforces[iatom];
+        if(plumedWantsToStop) nstep=istep;
+      } else if(plumed) {
         int istepplusone=istep+1;
         plumedWantsToStop=0;
         for(int i=0; i<3; i++)for(int k=0; k<3; k++) cell9[i][k]=0.0;
@@ -598,16 +796,19 @@ private:
       compute_engkin(natoms,masses,velocities,engkin);
 
 // eventually, write positions and statistics
-      if((istep+1)%nconfig==0) write_positions(trajfile,natoms,positions,cell,wrapatoms);
-      if((istep+1)%nstat==0)   write_statistics(statfile,istep+1,tstep,natoms,ndim,engkin,engconf,engint);
+      if(mydomain==0) {
+        if((istep+1)%nconfig==0) write_positions(trajfile,natoms,positions,cell,wrapatoms);
+        if((istep+1)%nstat==0)   write_statistics(statfile,istep+1,tstep,natoms,ndim,engkin,engconf,engint);
+      }
 
     }
 
 // write final positions
-    write_final_positions(outputfile,natoms,positions,cell,wrapatoms);
+    if(mydomain==0) write_final_positions(outputfile,natoms,positions,cell,wrapatoms);
 
 // close the statistic file if it was open:
     if(write_statistics_fp) fclose(write_statistics_fp);
+    if(mydomain>0) fclose(out);
 
     return 0;
   }
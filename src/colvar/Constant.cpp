@@ -69,6 +69,7 @@ class Constant : public Colvar {
 public:
   explicit Constant(const ActionOptions&);
   virtual void calculate();
+  bool isTimeIndependent()const {return true;}
   static void registerKeywords( Keywords& keys );
 };
 
@@ -182,6 +182,7 @@ ContactMap::ContactMap(const ActionOptions&ao):
   }
   // Create neighbour lists
   nl.reset(new NeighborList(ga_lista,gb_lista,true,pbc,getPbc()));
+  addMemoryUsage("neighbor list",[this]() { return nl->getMemoryUsage(); });
 
   // Read in switching functions
   std::string errors; sfs.resize( ga_lista.size() ); unsigned nswitch=0;
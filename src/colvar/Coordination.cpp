@@ -104,6 +104,7 @@ public:
 // active methods:
   static void registerKeywords( Keywords& keys );
   virtual double pairing(double distance,double&dfunc,unsigned i,unsigned j)const;
+  virtual void pairingBlock(const double* distance,unsigned n,const unsigned* i,const unsigned* j,double* result,double* dfunc)const;
 };
 
 PLUMED_REGISTER_ACTION(Coordination,"COORDINATION")
@@ -153,6 +154,12 @@ double Coordination::pairing(double distance,double&dfunc,unsigned i,unsigned j)
   return switchingFunction.calculateSqr(distance,dfunc);
 }
 
+void Coordination::pairingBlock(const double* distance,unsigned n,const unsigned* i,const unsigned* j,double* result,double* dfunc)const {
+  (void) i; // avoid warnings
+  (void) j; // avoid warnings
+  switchingFunction.calculateSqr(distance,n,result,dfunc);
+}
+
 }
 
 }
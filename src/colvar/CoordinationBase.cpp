@@ -23,6 +23,8 @@
 #include "tools/NeighborList.h"
 #include "tools/Communicator.h"
 #include "tools/OpenMP.h"
+#include "tools/Arena.h"
+#include "core/PlumedMain.h"
 
 #include <string>
 
@@ -86,6 +88,7 @@ CoordinationBase::CoordinationBase(const ActionOptions&ao):
   }
 
   requestAtoms(nl->getFullAtomList());
+  addMemoryUsage("neighbor list",[this]() { return nl->getMemoryUsage(); });
 
   log.printf("  between two groups of %u and %u atoms\n",static_cast<unsigned>(ga_lista.size()),static_cast<unsigned>(gb_lista.size()));
   log.printf("  first group:\n");
@@ -128,13 +131,19 @@ void CoordinationBase::prepare() {
 }
 
 // calculator
+void CoordinationBase::pairingBlock(const double* distance,unsigned n,const unsigned* i,const unsigned* j,double* result,double* dfunc)const {
+  for(unsigned k=0; k<n; ++k) result[k]=pairing(distance[k],dfunc[k],i[k],j[k]);
+}
+
 void CoordinationBase::calculate()
 {
 
   double ncoord=0.;
   Tensor virial;
-  vector<Vector> deriv(getNumberOfAtoms());
-// deriv.resize(getPositions().size());
+// temporaries are taken from the arena, so that no heap allocation is done at every step,
+// and released on return, so that calculate() can be called many times per step
+  ArenaScope scope(plumed.getArena());
+  ArenaVector<Vector> deriv(getNumberOfAtoms(),Vector(),ArenaAllocator<Vector>(plumed.getArena()));
 
   if(nl->getStride()>0 && invalidateList) {
     nl->update(getPositions());
@@ -153,43 +162,58 @@ void CoordinationBase::calculate()
   unsigned nt=OpenMP::getNumThreads();
 
   const unsigned nn=nl->size();
+// number of pairs that are passed together to pairingBlock()
+  const unsigned pairBlockSize=64;
 
   if(nt*stride*10>nn) nt=nn/stride/10;
   if(nt==0)nt=1;
 
   #pragma omp parallel num_threads(nt)
   {
-    std::vector<Vector> omp_deriv(getPositions().size());
+    Arena& arena(plumed.getArena());
+    ArenaScope omp_scope(arena);
+    ArenaVector<Vector> omp_deriv(nt>1?getPositions().size():0,Vector(),ArenaAllocator<Vector>(arena));
     Tensor omp_virial;
+// pairs are gathered in blocks so that the pairing function is computed for many pairs at once
+    ArenaVector<unsigned> b0(pairBlockSize,0,ArenaAllocator<unsigned>(arena)), b1(b0);
+    ArenaVector<Vector> bdistance(pairBlockSize,Vector(),ArenaAllocator<Vector>(arena));
+    ArenaVector<double> bdistance2(pairBlockSize,0.0,ArenaAllocator<double>(arena)), bresult(bdistance2), bdfunc(bdistance2);
 
     #pragma omp for reduction(+:ncoord) nowait
-    for(unsigned int i=rank; i<nn; i+=stride) {
-
-      Vector distance;
-      unsigned i0=nl->getClosePair(i).first;
-      unsigned i1=nl->getClosePair(i).second;
-
-      if(getAbsoluteIndex(i0)==getAbsoluteIndex(i1)) continue;
-
-      if(pbc) {
-        distance=pbcDistance(getPosition(i0),getPosition(i1));
-      } else {
-        distance=delta(getPosition(i0),getPosition(i1));
+    for(unsigned int ib=rank*pairBlockSize; ib<nn; ib+=stride*pairBlockSize) {
+
+      unsigned nb=0;
+      for(unsigned i=ib; i<nn && i<ib+pairBlockSize; ++i) {
+        unsigned i0=nl->getClosePair(i).first;
+        unsigned i1=nl->getClosePair(i).second;
+
+        if(getAbsoluteIndex(i0)==getAbsoluteIndex(i1)) continue;
+
+        if(pbc) {
+          bdistance[nb]=pbcDistance(getPosition(i0),getPosition(i1));
+        } else {
+          bdistance[nb]=delta(getPosition(i0),getPosition(i1));
+        }
+        bdistance2[nb]=bdistance[nb].modulo2();
+        b0[nb]=i0; b1[nb]=i1; nb++;
       }
 
-      double dfunc=0.;
-      ncoord += pairing(distance.modulo2(), dfunc,i0,i1);
-
-      Vector dd(dfunc*distance);
-      Tensor vv(dd,distance);
-      if(nt>1) {
-        omp_deriv[i0]-=dd;
-        omp_deriv[i1]+=dd;
-        omp_virial-=vv;
-      } else {
-        deriv[i0]-=dd;
-        deriv[i1]+=dd;
-        virial-=vv;
+      pairingBlock(bdistance2.data(),nb,b0.data(),b1.data(),bresult.data(),bdfunc.data());
+
+      for(unsigned k=0; k<nb; ++k) {
+        ncoord += bresult[k];
+
+        Vector dd(bdfunc[k]*bdistance[k]);
+        Tensor vv(dd,bdistance[k]);
+        if(nt>1) {
+          omp_deriv[b0[k]]-=dd;
+          omp_deriv[b1[k]]+=dd;
+          omp_virial-=vv;
+        } else {
+          deriv[b0[k]]-=dd;
+          deriv[b1[k]]+=dd;
+          virial-=vv;
+        }
       }
 
     }
@@ -44,6 +44,10 @@ public:
   virtual void calculate();
   virtual void prepare();
   virtual double pairing(double distance,double&dfunc,unsigned i,unsigned j)const=0;
+/// Compute the pairing function for a block of n pairs of atoms.
+/// By default this calls pairing() for each pair.  It can be overridden
+/// to compute all the pairs at once.
+  virtual void pairingBlock(const double* distance,unsigned n,const unsigned* i,const unsigned* j,double* result,double* dfunc)const;
   static void registerKeywords( Keywords& keys );
 };
 
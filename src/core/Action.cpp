@@ -64,6 +64,8 @@ Action::Action(const ActionOptions&ao):
   doCheckPoint(ao.plumed.getCPT()),
   plumed(ao.plumed),
   log(plumed.getLog()),
+  memoryHighWater(0),
+  upToDate(false),
   comm(plumed.comm),
   multi_sim_comm(plumed.multi_sim_comm),
   keywords(ao.keys)
@@ -104,6 +106,28 @@ Action::~Action() {
   }
 }
 
+void Action::addMemoryUsage(const std::string& name,const std::function<std::size_t()>& bytes) {
+  memoryUsage.push_back(std::pair<std::string,std::function<std::size_t()> >(name,bytes));
+}
+
+std::size_t Action::getMemoryUsage()const {
+  std::size_t m=0;
+  for(const auto & b : memoryUsage) m+=b.second();
+  return m;
+}
+
+std::size_t Action::updateMemoryHighWater() {
+  std::size_t m=getMemoryUsage();
+  if(m>memoryHighWater) memoryHighWater=m;
+  return m;
+}
+
+std::vector<std::pair<std::string,std::size_t> > Action::getMemoryBlocks()const {
+  std::vector<std::pair<std::string,std::size_t> > blocks;
+  for(const auto & b : memoryUsage) blocks.push_back(std::pair<std::string,std::size_t>(b.first,b.second()));
+  return blocks;
+}
+
 FILE* Action::fopen(const char *path, const char *mode) {
   bool write(false);
   for(const char*p=mode; *p; p++) if(*p=='w' || *p=='a' || *p=='+') write=true;
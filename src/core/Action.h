@@ -24,6 +24,7 @@
 #include <vector>
 #include <string>
 #include <set>
+#include <functional>
 #include "tools/Keywords.h"
 #include "Value.h"
 #include "tools/Tools.h"
@@ -173,6 +174,17 @@ private:
 /// Assignment operator is deleted
   Action& operator=(const Action&a) = delete;
   int replica_index;
+/// Blocks of memory owned by this action, see addMemoryUsage()
+  std::vector<std::pair<std::string,std::function<std::size_t()> > > memoryUsage;
+/// Largest memory used by this action at the end of a step
+  std::size_t memoryHighWater;
+/// The values computed in a previous step are still valid, see isTimeIndependent()
+  bool upToDate;
+protected:
+/// Register a block of memory owned by this action (a grid, a buffer, ...).
+/// The function returns the number of bytes currently allocated for the block,
+/// and it is called every time the memory used by the action is measured.
+  void addMemoryUsage(const std::string& name,const std::function<std::size_t()>& bytes);
 public:
 /// Check if Action was properly read.
 /// This checks if Action::line is empty. It must be called after
@@ -262,6 +274,16 @@ public:
 /// Check if the action needs gradient
   virtual bool checkNeedsGradients()const {return false;}
 
+/// Check if the values computed by the action only depend on the values of the actions
+/// it depends on (and not on atoms, time or any internal state).
+/// When this is true and none of these actions has been calculated again, the values
+/// computed in a previous step are reused and calculate() is not called.
+  virtual bool isTimeIndependent()const {return false;}
+/// Check if the values computed in a previous step are still valid
+  bool isUpToDate()const {return upToDate;}
+/// Set if the values computed in this step can be reused in the following ones
+  void setUpToDate(bool u) {upToDate=u;}
+
 /// Perform calculation using numerical derivatives
 /// N.B. only pass an ActionWithValue to this routine if you know exactly what you
 /// are doing.
@@ -287,6 +309,15 @@ public:
 
 /// Cite a paper see PlumedMain::cite
   std::string cite(const std::string&s);
+
+/// Get the memory currently used by the blocks registered with addMemoryUsage() (bytes)
+  std::size_t getMemoryUsage()const;
+/// Measure the memory used by the action and update its high-water mark
+  std::size_t updateMemoryHighWater();
+/// Get the largest memory measured by updateMemoryHighWater() (bytes)
+  std::size_t getMemoryHighWater()const {return memoryHighWater;}
+/// Get the names and the current sizes (bytes) of the blocks registered with addMemoryUsage()
+  std::vector<std::pair<std::string,std::size_t> > getMemoryBlocks()const;
 };
 
 /////////////////////
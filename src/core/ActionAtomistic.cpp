@@ -219,7 +219,17 @@ void ActionAtomistic::retrieveAtoms() {
   const vector<Vector> & p(atoms.positions);
   const vector<double> & c(atoms.charges);
   const vector<double> & m(atoms.masses);
-  for(unsigned j=0; j<indexes.size(); j++) positions[j]=p[indexes[j].index()];
+  if(atoms.directPositions) {
+// real atoms are read from the MD code, virtual atoms from Atoms
+    const Vector* d(atoms.directPositions);
+    const unsigned n=atoms.natoms;
+    for(unsigned j=0; j<indexes.size(); j++) {
+      const unsigned k=indexes[j].index();
+      positions[j]=(k<n?d[k]:p[k]);
+    }
+  } else {
+    for(unsigned j=0; j<indexes.size(); j++) positions[j]=p[indexes[j].index()];
+  }
   for(unsigned j=0; j<indexes.size(); j++) charges[j]=c[indexes[j].index()];
   for(unsigned j=0; j<indexes.size(); j++) masses[j]=m[indexes[j].index()];
 }
@@ -245,9 +255,20 @@ void ActionAtomistic::setForcesOnAtoms( const std::vector<double>& forcesToApply
 
 void ActionAtomistic::applyForces() {
   if(donotforce) return;
+  atoms.forcesApplied=true;
   vector<Vector>   & f(atoms.forces);
   Tensor           & v(atoms.virial);
-  for(unsigned j=0; j<indexes.size(); j++) f[indexes[j].index()]+=forces[j];
+  if(atoms.directForces) {
+    Vector* d(atoms.directForces);
+    const unsigned n=atoms.natoms;
+    for(unsigned j=0; j<indexes.size(); j++) {
+      const unsigned k=indexes[j].index();
+      if(k<n) d[k]+=forces[j];
+      else f[k]+=forces[j];
+    }
+  } else {
+    for(unsigned j=0; j<indexes.size(); j++) f[indexes[j].index()]+=forces[j];
+  }
   v+=virial;
   atoms.forceOnEnergy+=forceOnEnergy;
 }
@@ -150,7 +150,10 @@ public:
 /// Make atoms whole, assuming they are in the proper order
   void makeWhole();
 /// Allow calls to modifyGlobalForce()
-  void allowToAccessGlobalForces() {atoms.zeroallforces=true;}
+  void allowToAccessGlobalForces() {atoms.zeroallforces=true; atoms.forbidZeroCopy();}
+/// Allow calls to modifyPosition().
+/// Positions of all atoms are then copied from the MD code at every step.
+  void allowToModifyGlobalPositions() {atoms.forbidZeroCopy();}
 /// updates local unique atoms
   void updateUniqueLocal();
 public:
@@ -189,11 +192,13 @@ const Vector & ActionAtomistic::getPosition(int i)const {
 
 inline
 const Vector & ActionAtomistic::getPosition(AtomNumber i)const {
+  if(atoms.directPositions && int(i.index())<atoms.natoms) return atoms.directPositions[i.index()];
   return atoms.positions[i.index()];
 }
 
 inline
 Vector & ActionAtomistic::modifyPosition(AtomNumber i) {
+  plumed_massert(!atoms.directPositions || int(i.index())>=atoms.natoms,"modifyPosition() can only be used after allowToModifyGlobalPositions()");
   return atoms.positions[i.index()];
 }
 
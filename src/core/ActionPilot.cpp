@@ -37,6 +37,15 @@ ActionPilot::ActionPilot(const ActionOptions&ao):
   } else {
     stride=0;
   }
+  if( keywords.exists("MTS_STRIDE") ) {
+    int mts=0;
+    parse("MTS_STRIDE",mts);
+    if( mts<0 ) error("MTS_STRIDE should be positive");
+    if( mts>0 ) {
+      if( keywords.exists("STRIDE") && stride!=1 ) error("STRIDE and MTS_STRIDE cannot be used together");
+      stride=mts;
+    }
+  }
 }
 
 bool ActionPilot::onStep()const {
@@ -34,7 +34,9 @@ that does not inherit from PLMD::Action is only run when some other Action requi
 it in order to run.  This class is used in PLMD::Bias
  Action which drives the execution of other Action's.
  Action's of this kind are executed with a fixed stride
- which is specified on the directive line with a STRIDE= keyword
+ which is specified on the directive line with a STRIDE= keyword.
+ Actions that apply forces can also register a MTS_STRIDE= keyword, which
+ sets the same stride and is meant for multiple time step integration.
 */
 class ActionPilot:
   public virtual Action
@@ -46,6 +48,9 @@ public:
   static void registerKeywords(Keywords& keys);
 /// Check if the action is active on this step
   virtual bool onStep()const;
+/// Check if onStep() only depends on the step modulo the stride.
+/// Actions that override onStep() with a different logic should return false.
+  virtual bool onStepIsPeriodic()const {return true;}
 /// Set the value of the stride
   void setStride( const int& n );
 /// Get the stride
@@ -59,6 +59,11 @@ ActionWithValue::ActionWithValue(const ActionOptions&ao):
 {
   if( keywords.exists("NUMERICAL_DERIVATIVES") ) parseFlag("NUMERICAL_DERIVATIVES",numericalDerivatives);
   if(numericalDerivatives) log.printf("  using numerical derivatives\n");
+  addMemoryUsage("values",[this]() {
+    std::size_t m=0;
+    for(const auto & v : values) m+=v->getMemoryUsage();
+    return m;
+  });
 }
 
 ActionWithValue::~ActionWithValue() {
@@ -47,7 +47,12 @@ ActionWithVirtualAtom::~ActionWithVirtualAtom() {
 
 void ActionWithVirtualAtom::apply() {
   Vector & f(atoms.forces[index.index()]);
-  for(unsigned i=0; i<getNumberOfAtoms(); i++) modifyForces()[i]=matmul(derivatives[i],f);
+  vector<Vector> & forces(modifyForces());
+  if(!derivativeWeights.empty()) {
+    for(unsigned i=0; i<getNumberOfAtoms(); i++) forces[i]=derivativeWeights[i]*f;
+  } else {
+    for(unsigned i=0; i<getNumberOfAtoms(); i++) forces[i]=matmul(derivatives[i],f);
+  }
   Tensor & v(modifyVirial());
   for(unsigned i=0; i<3; i++) v+=boxDerivatives[i]*f[i];
   f.zero(); // after propagating the force to the atoms used to compute the vatom, we reset this to zero
@@ -68,11 +73,11 @@ void ActionWithVirtualAtom::setGradients() {
     if(atoms.isVirtualAtom(an)) {
       const ActionWithVirtualAtom* a=atoms.getVirtualAtomsAction(an);
       for(const auto & p : a->gradients) {
-        gradients[p.first]+=matmul(derivatives[i],p.second);
+        gradients[p.first]+=matmul(getAtomDerivative(i),p.second);
       }
       // this case if the atom is a normal one
     } else {
-      gradients[an]+=derivatives[i];
+      gradients[an]+=getAtomDerivative(i);
     }
   }
 }
@@ -95,7 +100,7 @@ void ActionWithVirtualAtom::setBoxDerivativesNoPbc() {
 // and derivatives. Notice that this only works only when Pbc have not been used to compute
 // derivatives.
         for(unsigned l=0; l<getNumberOfAtoms(); l++) {
-          bd[k][i][j]-=getPosition(l)[i]*derivatives[l][j][k];
+          bd[k][i][j]-=getPosition(l)[i]*getAtomDerivative(l)[j][k];
         }
       }
   setBoxDerivatives(bd);
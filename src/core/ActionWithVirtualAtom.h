@@ -42,9 +42,13 @@ class ActionWithVirtualAtom:
 {
   AtomNumber index;
   std::vector<Tensor> derivatives;
+/// weights of the atoms, used instead of derivatives when set with setAtomsWeights()
+  std::vector<double> derivativeWeights;
   std::vector<Tensor> boxDerivatives;
   std::map<AtomNumber,Tensor> gradients;
   void apply();
+/// Get the derivative of the virtual atom coordinate wrt atom i
+  Tensor getAtomDerivative(unsigned i)const;
 protected:
 /// Set position of the virtual atom
   void setPosition(const Vector &);
@@ -56,6 +60,10 @@ protected:
   void requestAtoms(const std::vector<AtomNumber> & a);
 /// Set the derivatives of virtual atom coordinate wrt atoms on which it dependes
   void setAtomsDerivatives(const std::vector<Tensor> &d);
+/// Set the derivatives of a virtual atom which is a weighted average of the atoms
+/// it depends on (e.g. vatom::COM and vatom::Center), so that the derivative
+/// wrt atom i is w[i] times the identity. Only the weights are stored.
+  void setAtomsWeights(const std::vector<double> &w);
 /// Set the box derivatives.
 /// This should be a vector of size 3. First index corresponds
 /// to the components of the virtual atom.
@@ -107,6 +115,19 @@ void ActionWithVirtualAtom::setCharge(double c) {
 inline
 void ActionWithVirtualAtom::setAtomsDerivatives(const std::vector<Tensor> &d) {
   derivatives=d;
+  derivativeWeights.clear();
+}
+
+inline
+void ActionWithVirtualAtom::setAtomsWeights(const std::vector<double> &w) {
+  derivativeWeights=w;
+  if(!derivatives.empty()) std::vector<Tensor>().swap(derivatives);
+}
+
+inline
+Tensor ActionWithVirtualAtom::getAtomDerivative(unsigned i)const {
+  if(!derivativeWeights.empty()) return derivativeWeights[i]*Tensor::identity();
+  return derivatives[i];
 }
 
 inline
@@ -61,6 +61,11 @@ Atoms::Atoms(PlumedMain&plumed):
   timestep(0.0),
   forceOnEnergy(0.0),
   zeroallforces(false),
+  zeroCopy(false),
+  zeroCopyAllowed(true),
+  directPositions(NULL),
+  directForces(NULL),
+  forcesApplied(false),
   kbT(0.0),
   asyncSent(false),
   atomsNeeded(false),
@@ -183,20 +188,38 @@ void Atoms::shareAll() {
 void Atoms::share(const std::set<AtomNumber>& unique) {
   plumed_assert( positionsHaveBeenSet==3 && massesHaveBeenSet );
 
+// when all atoms are local and in order, actions can read and write directly in the MD arrays.
+// this is not done if the force on the energy is needed, since MD forces are then rescaled at the end
+  directPositions=NULL;
+  directForces=NULL;
+  if(zeroCopy && zeroCopyAllowed && !collectEnergy && int(gatindex.size())==natoms && shuffledAtoms==0) {
+    directPositions=mdatoms->getDirectPositions();
+    directForces=mdatoms->getDirectForces();
+    if(!directPositions || !directForces) {
+      directPositions=NULL;
+      directForces=NULL;
+    }
+  }
+
   virial.zero();
-  if(zeroallforces || int(gatindex.size())==natoms) {
+  if(directForces) {
+// forces on real atoms go straight to the MD code
+  } else if(zeroallforces || int(gatindex.size())==natoms) {
     for(int i=0; i<natoms; i++) forces[i].zero();
   } else {
     for(const auto & p : unique) forces[p.index()].zero();
   }
   for(unsigned i=getNatoms(); i<positions.size(); i++) forces[i].zero(); // virtual atoms
   forceOnEnergy=0.0;
+  forcesApplied=false;
   mdatoms->getBox(box);
 
   if(!atomsNeeded) return;
   atomsNeeded=false;
 
-  if(int(gatindex.size())==natoms && shuffledAtoms==0) {
+  if(directPositions) {
+// nothing to copy
+  } else if(int(gatindex.size())==natoms && shuffledAtoms==0) {
 // faster version, which retrieves all atoms
     mdatoms->getPositions(0,natoms,positions);
   } else {
@@ -317,7 +340,12 @@ void Atoms::wait() {
 
 void Atoms::updateForces() {
   plumed_assert( forcesHaveBeenSet==3 );
-  if(forceOnEnergy*forceOnEnergy>epsilon) {
+  if(directForces) {
+// forces have already been added by the actions
+    plumed_assert(forceOnEnergy*forceOnEnergy<=epsilon);
+  } else if(!forcesApplied) {
+// no action has added forces in this step, so that there is nothing to add to the MD forces
+  } else if(forceOnEnergy*forceOnEnergy>epsilon) {
     double alpha=1.0-forceOnEnergy;
     mdatoms->rescaleForces(gatindex,alpha);
     mdatoms->updateForces(gatindex,forces);
@@ -524,13 +552,16 @@ void Atoms::removeGroup(const std::string&name) {
 }
 
 void Atoms::writeBinary(std::ostream&o)const {
-  o.write(reinterpret_cast<const char*>(&positions[0][0]),natoms*3*sizeof(double));
+  const Vector* p=(directPositions?directPositions:positions.data());
+  o.write(reinterpret_cast<const char*>(&p[0][0]),natoms*3*sizeof(double));
   o.write(reinterpret_cast<const char*>(&box(0,0)),9*sizeof(double));
   o.write(reinterpret_cast<const char*>(&energy),sizeof(double));
 }
 
 void Atoms::readBinary(std::istream&i) {
   i.read(reinterpret_cast<char*>(&positions[0][0]),natoms*3*sizeof(double));
+// positions of the MD code cannot be used anymore
+  directPositions=NULL;
   i.read(reinterpret_cast<char*>(&box(0,0)),9*sizeof(double));
   i.read(reinterpret_cast<char*>(&energy),sizeof(double));
   pbc.setBox(box);
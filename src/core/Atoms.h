@@ -101,6 +101,22 @@ class Atoms
 /// for actions accessing to modifyGlobalForce() (e.g. FIT_TO_TEMPLATE).
   bool zeroallforces;
 
+/// if set to true, positions are read and forces are added directly
+/// in the arrays of the MD code when possible, without copying them in positions and forces.
+/// It is false by default and can be switched on by the MD code, which then promises
+/// not to modify the arrays between setPositions/setForces and the end of calc
+  bool zeroCopy;
+/// set to false by actions that need the global positions and forces arrays
+/// (e.g. WHOLEMOLECULES, that modifies the positions)
+  bool zeroCopyAllowed;
+/// positions of the MD code, or NULL if they have been copied in positions in this step
+  const Vector* directPositions;
+/// forces of the MD code, or NULL if forces should be accumulated in forces in this step
+  Vector* directForces;
+/// set to true by the actions that add forces in this step. When it is false
+/// (e.g. between the steps of a multiple time step bias) MD forces are not updated
+  bool forcesApplied;
+
   double kbT;
 
   std::vector<ActionAtomistic*> actions;
@@ -171,6 +187,11 @@ public:
 
   void setCollectEnergy(bool b) { collectEnergy=b; }
 
+  void setZeroCopy(bool b) { zeroCopy=b; }
+/// Forbid the zero-copy access, for actions that need the global arrays of positions and forces
+  void forbidZeroCopy() { zeroCopyAllowed=false; }
+  bool isZeroCopy()const { return directPositions!=NULL; }
+
   void setDomainDecomposition(Communicator&);
   void setAtomsGatindex(int*,bool);
   void setAtomsContiguous(int);
@@ -22,10 +22,15 @@
 #include "GREX.h"
 #include "PlumedMain.h"
 #include "Atoms.h"
+#include "ActionSet.h"
+#include "ActionAtomistic.h"
+#include "ActionWithValue.h"
+#include "ActionWithArguments.h"
 #include "tools/Tools.h"
 #include "tools/Communicator.h"
 #include <sstream>
 #include <unordered_map>
+#include <cstdlib>
 
 #include "GREXEnum.inc"
 
@@ -51,9 +56,17 @@ GREX::GREX(PlumedMain&p):
   foreignDeltaBias(0),
   localUNow(0),
   localUSwap(0),
-  myreplica(-1) // = unset
+  myreplica(-1), // = unset
+  exchangeColvars(false),
+  colvarsChecked(false)
 {
   p.setSuffix(".NA");
+  const char* env=std::getenv("PLUMED_GREX_EXCHANGE_COLVARS");
+  if(env && *env) {
+    int i;
+    plumed_massert(Tools::convert(std::string(env),i),"PLUMED_GREX_EXCHANGE_COLVARS should be set to an integer, found "+std::string(env));
+    exchangeColvars=(i!=0);
+  }
 }
 
 GREX::~GREX() {
@@ -107,6 +120,7 @@ void GREX::cmd(const string&key,void*val) {
         Tools::convert(myreplica,s);
         plumedMain.setSuffix("."+s);
       }
+      checkColvars();
       break;
     case cmd_prepare:
       CHECK_INIT(initialized,key);
@@ -118,6 +132,11 @@ void GREX::cmd(const string&key,void*val) {
       CHECK_INIT(initialized,key);
       partner=*static_cast<int*>(val);
       break;
+    case cmd_setExchangeColvars:
+      CHECK_NOTNULL(val,key);
+      exchangeColvars=(*static_cast<int*>(val)!=0);
+      if(initialized) checkColvars();
+      break;
     case cmd_savePositions:
       CHECK_INIT(initialized,key);
       savePositions();
@@ -187,6 +206,12 @@ void GREX::cmd(const string&key,void*val) {
 }
 
 void GREX::savePositions() {
+  if(exchangeColvars) {
+// the input might have been read after the mode was enabled
+    checkColvars();
+    saveColvars();
+    return;
+  }
   plumedMain.prepareDependencies();
   plumedMain.resetActive(true);
   atoms.shareAll();
@@ -196,23 +221,93 @@ void GREX::savePositions() {
   buffer=o.str();
 }
 
+void GREX::saveColvars() {
+// savePositions is called after the calculation of the step, so that active
+// actions have been computed. The same actions are active on the exchange step,
+// since they are activated by the same pilots at the same step.
+  colvarBuffer.clear();
+  for(const auto & p : plumedMain.getActionSet()) {
+    if(!p->isActive()) continue;
+    ActionWithValue*av=dynamic_cast<ActionWithValue*>(p.get());
+    if(av && dynamic_cast<ActionAtomistic*>(p.get())) {
+      for(int i=0; i<av->getNumberOfComponents(); ++i) colvarBuffer.push_back(av->copyOutput(i)->get());
+    }
+  }
+}
+
+void GREX::checkColvars() {
+  if(!exchangeColvars || colvarsChecked || plumedMain.getActionSet().empty()) return;
+  for(const auto & p : plumedMain.getActionSet()) {
+    if(dynamic_cast<ActionAtomistic*>(p.get())) continue;
+// other actions should only use the values of the actions depending on the atoms
+    ActionWithArguments*aa=dynamic_cast<ActionWithArguments*>(p.get());
+    for(const auto & d : p->getDependencies()) {
+      if(!dynamic_cast<ActionAtomistic*>(d)) continue;
+      bool found=false;
+      if(aa) for(const auto & a : aa->getArguments()) if(a->getPntrToAction()==d) {found=true; break;}
+      if(!found) plumed_merror("action "+p->getLabel()+" uses data of "+d->getLabel()+" which are not values, so that it cannot be computed when exchanging colvars with GREX");
+    }
+  }
+  colvarsChecked=true;
+}
+
+void GREX::setColvars(const std::vector<double> & values) {
+  unsigned k=0;
+  for(const auto & p : plumedMain.getActionSet()) {
+    if(!p->isActive()) continue;
+    if(dynamic_cast<ActionAtomistic*>(p.get())) {
+      ActionWithValue*av=dynamic_cast<ActionWithValue*>(p.get());
+      if(av) for(int i=0; i<av->getNumberOfComponents(); ++i) {
+          plumed_massert(k<values.size(),"when exchanging colvars with GREX, actions depending on atoms should be the same on all replicas");
+          av->copyOutput(i)->set(values[k++]);
+        }
+      p->deactivate();
+    }
+  }
+  plumed_massert(k==values.size(),"when exchanging colvars with GREX, actions depending on atoms should be the same on all replicas");
+}
+
 void GREX::calculate() {
 //fprintf(stderr,"CALCULATE %d %d\n",intercomm.Get_rank(),partner);
-  unsigned nn=buffer.size();
-  vector<char> rbuf(nn);
   localDeltaBias=-plumedMain.getBias();
-  if(intracomm.Get_rank()==0) {
-    Communicator::Request req=intercomm.Isend(buffer,partner,1066);
-    intercomm.Recv(rbuf,partner,1066);
-    req.wait();
+  if(exchangeColvars) {
+// only the values of the actions depending on the atoms are exchanged,
+// and the other actions are computed from them
+    vector<double> rbuf(colvarBuffer.size());
+    if(intracomm.Get_rank()==0) {
+      unsigned n=colvarBuffer.size(),rn=0;
+      Communicator::Request req=intercomm.Isend(n,partner,1068);
+      intercomm.Recv(rn,partner,1068);
+      req.wait();
+      plumed_massert(rn==n,"when exchanging colvars with GREX, actions depending on atoms should be the same on all replicas");
+      if(n>0) {
+        req=intercomm.Isend(colvarBuffer,partner,1066);
+        intercomm.Recv(rbuf,partner,1066);
+        req.wait();
+      }
+    }
+    intracomm.Bcast(rbuf,0);
+    plumedMain.setExchangeStep(true);
+    plumedMain.prepareDependencies();
+    setColvars(rbuf);
+    plumedMain.justCalculate();
+    plumedMain.setExchangeStep(false);
+  } else {
+    unsigned nn=buffer.size();
+    vector<char> rbuf(nn);
+    if(intracomm.Get_rank()==0) {
+      Communicator::Request req=intercomm.Isend(buffer,partner,1066);
+      intercomm.Recv(rbuf,partner,1066);
+      req.wait();
+    }
+    intracomm.Bcast(rbuf,0);
+    istringstream i(string(&rbuf[0],rbuf.size()));
+    atoms.readBinary(i);
+    plumedMain.setExchangeStep(true);
+    plumedMain.prepareDependencies();
+    plumedMain.justCalculate();
+    plumedMain.setExchangeStep(false);
   }
-  intracomm.Bcast(rbuf,0);
-  istringstream i(string(&rbuf[0],rbuf.size()));
-  atoms.readBinary(i);
-  plumedMain.setExchangeStep(true);
-  plumedMain.prepareDependencies();
-  plumedMain.justCalculate();
-  plumedMain.setExchangeStep(false);
   localDeltaBias+=plumedMain.getBias();
   localDeltaBias+=localUSwap-localUNow;
   if(intracomm.Get_rank()==0) {
@@ -51,6 +51,20 @@ class GREX:
   std::vector<double> allDeltaBias;
   std::string buffer;
   int myreplica;
+/// if true, the values of the actions that depend on the atoms are exchanged instead of the positions,
+/// and only the rest of the actions (functions and biases) are computed on the exchange step
+  bool exchangeColvars;
+/// values of the actions that depend on the atoms, as computed in this step
+  std::vector<double> colvarBuffer;
+/// true when the actions have been checked to be compatible with exchangeColvars
+  bool colvarsChecked;
+/// check that the actions that do not depend on the atoms only use the values of those that do.
+/// This is done as soon as the mode is enabled and the input has been read
+  void checkColvars();
+/// store the values of the actions that depend on the atoms
+  void saveColvars();
+/// set the values of the actions that depend on the atoms to those of the partner and deactivate them
+  void setColvars(const std::vector<double> & values);
 public:
   explicit GREX(PlumedMain&);
   ~GREX();
@@ -30,6 +30,19 @@ using namespace std;
 
 namespace PLMD {
 
+/// Array of interleaved coordinates seen as an array of Vector.
+/// Only possible for doubles, see the overload below.
+template <class T>
+static Vector* asVectors(T*,int,T) {
+  return NULL;
+}
+
+static Vector* asVectors(double*p,int stride,double scale) {
+  static_assert(sizeof(Vector)==3*sizeof(double),"Vector should be made of three contiguous doubles");
+  if(!p || stride!=3 || scale!=1.0) return NULL;
+  return reinterpret_cast<Vector*>(p);
+}
+
 /// Class containing the pointers to the MD data
 /// It is templated so that single and double precision versions coexist
 /// IT IS STILL UNDOCUMENTED. IT PROBABLY NEEDS A STRONG CLEANUP
@@ -80,6 +93,12 @@ public:
   void updateForces(const std::set<AtomNumber>&index,const vector<unsigned>&i,const vector<Vector>&forces);
   void rescaleForces(const vector<int>&index,double factor);
   unsigned  getRealPrecision()const;
+  const Vector* getDirectPositions()const {
+    return asVectors(px,stride,scalep);
+  }
+  Vector* getDirectForces()const {
+    return asVectors(fx,stride,scalef);
+  }
 };
 
 template <class T>
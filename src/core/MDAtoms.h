@@ -107,6 +107,12 @@ public:
 /// Rescale all the forces, including the virial.
 /// It is applied to all atoms with local index going from 0 to index.size()-1
   virtual void rescaleForces(const std::vector<int>&index,double factor)=0;
+/// Get the positions array of the MD code seen as an array of Vector.
+/// This is only possible if the MD code uses doubles, passes the coordinates as
+/// a single interleaved array and no unit conversion is needed. Otherwise NULL is returned.
+  virtual const Vector* getDirectPositions()const=0;
+/// Get the forces array of the MD code seen as an array of Vector (see getDirectPositions()).
+  virtual Vector* getDirectForces()const=0;
 };
 
 }
@@ -37,7 +37,9 @@
 #include "tools/Exception.h"
 #include "tools/IFile.h"
 #include "tools/Log.h"
+#include "tools/OFile.h"
 #include "tools/OpenMP.h"
+#include "tools/Arena.h"
 #include "tools/Tools.h"
 #include "tools/Stopwatch.h"
 #include "DataFetchingObject.h"
@@ -70,6 +72,7 @@ PlumedMain::PlumedMain():
   endPlumed(false),
   atoms_fwd(*this),
   actionSet_fwd(*this),
+  pilotsPeriod(0),
   bias(0.0),
   work(0.0),
   exchangeStep(false),
@@ -84,12 +87,26 @@ PlumedMain::PlumedMain():
   log.setLinePrefix("PLUMED: ");
   stopwatch.start();
   stopwatch.pause();
+  timerPrepare=stopwatch.getTimerId("1 Prepare dependencies");
+  timerShare=stopwatch.getTimerId("2 Sharing data");
+  timerWait=stopwatch.getTimerId("3 Waiting for data");
+  timerForward=stopwatch.getTimerId("4 Calculating (forward loop)");
+  timerBackward=stopwatch.getTimerId("5 Applying (backward loop)");
+  timerUpdateForces=stopwatch.getTimerId("5B Update forces");
+  timerUpdate=stopwatch.getTimerId("6 Update");
 }
 
 PlumedMain::~PlumedMain() {
+  if(traceFile) {
+    stopwatch.writeTrace(*traceFile,comm.Get_rank());
+    traceFile->printf("\n]\n");
+  }
   stopwatch.start();
   stopwatch.stop();
-  if(initialized) log<<stopwatch;
+  if(initialized) {
+    writeMemoryReport();
+    log<<stopwatch;
+  }
 }
 
 /////////////////////////////////////////////////////////////
@@ -332,6 +349,11 @@ void PlumedMain::cmd(const std::string & word,void*val) {
         CHECK_NOTINIT(initialized,word);
         novirial=true;
         break;
+      case cmd_setZeroCopy:
+        CHECK_NOTINIT(initialized,word);
+        CHECK_NOTNULL(val,word);
+        atoms.setZeroCopy(*static_cast<int*>(val)!=0);
+        break;
       case cmd_setPlumedDat:
         CHECK_NOTINIT(initialized,word);
         CHECK_NOTNULL(val,word);
@@ -436,6 +458,14 @@ void PlumedMain::cmd(const std::string & word,void*val) {
         CHECK_NOTNULL(val,word);
         atoms.double2MD(getBias()/(atoms.getMDUnits().getEnergy()/atoms.getUnits().getEnergy()),val);
         break;
+      case cmd_getMemoryReport:
+        CHECK_INIT(initialized,word);
+        {
+          std::size_t total=writeMemoryReport();
+// optionally, the total number of bytes is returned as a long
+          if(val) *static_cast<long*>(val)=total;
+        }
+        break;
       case cmd_checkAction:
         CHECK_NOTNULL(val,word);
         plumed_assert(nw==2);
@@ -496,6 +526,8 @@ void PlumedMain::init() {
   log.printf("Precision of reals: %d\n",atoms.getRealPrecision());
   log.printf("Running over %d %s\n",comm.Get_size(),(comm.Get_size()>1?"nodes":"node"));
   log<<"Number of threads: "<<OpenMP::getNumThreads()<<"\n";
+  arenas.resize(OpenMP::getNumThreads());
+  for(auto & a : arenas) a.reset(new Arena);
   log<<"Cache line size: "<<OpenMP::getCachelineSize()<<"\n";
   log.printf("Number of atoms: %d\n",atoms.getNatoms());
   if(grex) log.printf("GROMACS-like replica exchange is on\n");
@@ -515,6 +547,7 @@ void PlumedMain::init() {
   log<<"Relevant bibliography:\n";
   log<<citations;
   log<<"Please read and cite where appropriate!\n";
+  if(!actionSet.empty()) writeMemoryReport();
   log<<"Finished setup\n";
 }
 
@@ -532,6 +565,7 @@ void PlumedMain::readInputFile(std::string str) {
   log.flush();
 
   pilots=actionSet.select<ActionPilot*>();
+  setupPilots();
 }
 
 void PlumedMain::readInputLine(const std::string & str) {
@@ -571,6 +605,7 @@ void PlumedMain::readInputWords(const std::vector<std::string> & words) {
   };
 
   pilots=actionSet.select<ActionPilot*>();
+  setupPilots();
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -599,7 +634,7 @@ void PlumedMain::prepareCalc() {
 // traverse them in this order:
 void PlumedMain::prepareDependencies() {
 
-  stopwatch.start("1 Prepare dependencies");
+  stopwatch.start(timerPrepare);
 
 // activate all the actions which are on step
 // activation is recursive and enables also the dependencies
@@ -614,12 +649,24 @@ void PlumedMain::prepareDependencies() {
 
 // for optimization, an "active" flag remains false if no action at all is active
   active=mydatafetcher->activate();
-  for(unsigned i=0; i<pilots.size(); ++i) {
-    if(pilots[i]->onStep()) {
-      pilots[i]->activate();
-      active=true;
+  if(pilotsPeriod>0) {
+// the pilots that are on step only depend on the phase of the step, and are only looked for
+// the first time a phase is met
+    unsigned phase=((step%pilotsPeriod)+pilotsPeriod)%pilotsPeriod;
+    if(!pilotsOnStepDone[phase]) {
+      for(const auto & p : pilots) if(p->onStep()) pilotsOnStep[phase].push_back(p);
+      pilotsOnStepDone[phase]=true;
     }
-  };
+    for(const auto & p : pilotsOnStep[phase]) p->activate();
+    if(!pilotsOnStep[phase].empty()) active=true;
+  } else {
+    for(unsigned i=0; i<pilots.size(); ++i) {
+      if(pilots[i]->onStep()) {
+        pilots[i]->activate();
+        active=true;
+      }
+    };
+  }
 
 // also, if one of them is the total energy, tell to atoms that energy should be collected
   for(const auto & p : actionSet) {
@@ -628,15 +675,33 @@ void PlumedMain::prepareDependencies() {
     }
   }
 
-  stopwatch.stop("1 Prepare dependencies");
+  stopwatch.stop(timerPrepare);
+}
+
+void PlumedMain::setupPilots() {
+// the period is the least common multiple of the strides
+// if it is too long, or if some pilot is not periodic, nothing is cached
+  const long int maxPeriod=10000;
+  pilotsPeriod=1;
+  for(const auto & p : pilots) {
+    if(!p->onStepIsPeriodic()) {pilotsPeriod=0; break;}
+    long int s=p->getStride();
+    if(s<=0) continue;
+    long int a=pilotsPeriod, b=s;
+    while(b>0) {long int t=a%b; a=b; b=t;}
+    pilotsPeriod=pilotsPeriod/a*s;
+    if(pilotsPeriod>maxPeriod) {pilotsPeriod=0; break;}
+  }
+  pilotsOnStep.assign(pilotsPeriod,std::vector<ActionPilot*>());
+  pilotsOnStepDone.assign(pilotsPeriod,false);
 }
 
 void PlumedMain::shareData() {
 // atom positions are shared (but only if there is something to do)
   if(!active)return;
-  stopwatch.start("2 Sharing data");
+  stopwatch.start(timerShare);
   if(atoms.getNatoms()>0) atoms.share();
-  stopwatch.stop("2 Sharing data");
+  stopwatch.stop(timerShare);
 }
 
 void PlumedMain::performCalcNoUpdate() {
@@ -655,51 +720,55 @@ void PlumedMain::performCalc() {
 
 void PlumedMain::waitData() {
   if(!active)return;
-  stopwatch.start("3 Waiting for data");
+  stopwatch.start(timerWait);
   if(atoms.getNatoms()>0) atoms.wait();
-  stopwatch.stop("3 Waiting for data");
+  stopwatch.stop(timerWait);
 }
 
 void PlumedMain::justCalculate() {
   if(!active)return;
-  stopwatch.start("4 Calculating (forward loop)");
+  stopwatch.start(timerForward);
   bias=0.0;
   work=0.0;
+// temporaries of the previous step are not needed anymore
+  for(auto & a : arenas) a->reset();
+  if(detailedTimers) setupDetailedTimers();
 
   int iaction=0;
 // calculate the active actions in order (assuming *backward* dependence)
   for(const auto & pp : actionSet) {
     Action* p(pp.get());
     if(p->isActive()) {
-      std::string actionNumberLabel;
-      if(detailedTimers) {
-        Tools::convert(iaction,actionNumberLabel);
-        actionNumberLabel="4A "+actionNumberLabel+" "+p->getLabel();
-        stopwatch.start(actionNumberLabel);
-      }
+      if(detailedTimers) stopwatch.start(forwardTimers[iaction]);
       ActionWithValue*av=dynamic_cast<ActionWithValue*>(p);
       ActionAtomistic*aa=dynamic_cast<ActionAtomistic*>(p);
+// values (and derivatives) can be reused if they do not depend on anything that has been calculated again
+      bool depsUpToDate=p->isTimeIndependent() && !p->checkNumericalDerivatives();
+      if(depsUpToDate) for(const auto & d : p->getDependencies()) if(!d->isUpToDate()) {depsUpToDate=false; break;}
+      bool reuse=depsUpToDate && p->isUpToDate();
       {
         if(av) av->clearInputForces();
-        if(av) av->clearDerivatives();
+        if(av && !reuse) av->clearDerivatives();
       }
       {
         if(aa) aa->clearOutputForces();
         if(aa) if(aa->isActive()) aa->retrieveAtoms();
       }
-      if(p->checkNumericalDerivatives()) p->calculateNumericalDerivatives();
+      if(reuse) {}
+      else if(p->checkNumericalDerivatives()) p->calculateNumericalDerivatives();
       else p->calculate();
+      p->setUpToDate(depsUpToDate);
       // This retrieves components called bias
       if(av) bias+=av->getOutputQuantity("bias");
       if(av) work+=av->getOutputQuantity("work");
       if(av)av->setGradientsIfNeeded();
       ActionWithVirtualAtom*avv=dynamic_cast<ActionWithVirtualAtom*>(p);
       if(avv)avv->setGradientsIfNeeded();
-      if(detailedTimers) stopwatch.stop(actionNumberLabel);
+      if(detailedTimers) stopwatch.stop(forwardTimers[iaction]);
     }
     iaction++;
   }
-  stopwatch.stop("4 Calculating (forward loop)");
+  stopwatch.stop(timerForward);
 }
 
 void PlumedMain::justApply() {
@@ -710,40 +779,71 @@ void PlumedMain::justApply() {
 void PlumedMain::backwardPropagate() {
   if(!active)return;
   int iaction=0;
-  stopwatch.start("5 Applying (backward loop)");
+  stopwatch.start(timerBackward);
+  if(detailedTimers) setupDetailedTimers();
 // apply them in reverse order
   for(auto pp=actionSet.rbegin(); pp!=actionSet.rend(); ++pp) {
     const auto & p(pp->get());
     if(p->isActive()) {
 
-      std::string actionNumberLabel;
-      if(detailedTimers) {
-        Tools::convert(iaction,actionNumberLabel);
-        actionNumberLabel="5A "+actionNumberLabel+" "+p->getLabel();
-        stopwatch.start(actionNumberLabel);
-      }
+      if(detailedTimers) stopwatch.start(backwardTimers[iaction]);
 
       p->apply();
       ActionAtomistic*a=dynamic_cast<ActionAtomistic*>(p);
 // still ActionAtomistic has a special treatment, since they may need to add forces on atoms
       if(a) a->applyForces();
 
-      if(detailedTimers) stopwatch.stop(actionNumberLabel);
+      if(detailedTimers) stopwatch.stop(backwardTimers[iaction]);
     }
     iaction++;
   }
 
 // this is updating the MD copy of the forces
-  if(detailedTimers) stopwatch.start("5B Update forces");
+  if(detailedTimers) stopwatch.start(timerUpdateForces);
   if(atoms.getNatoms()>0) atoms.updateForces();
-  if(detailedTimers) stopwatch.stop("5B Update forces");
-  stopwatch.stop("5 Applying (backward loop)");
+  if(detailedTimers) stopwatch.stop(timerUpdateForces);
+  stopwatch.stop(timerBackward);
+}
+
+Arena & PlumedMain::getArena() {
+  unsigned t=OpenMP::getThreadNum();
+  plumed_massert(t<arenas.size(),"arenas are only available after initialization and within the configured number of threads");
+  return *arenas[t];
+}
+
+void PlumedMain::setupDetailedTimers() {
+// timers are created once, and again only if actions are added
+  unsigned n=actionSet.size();
+  if(forwardTimers.size()==n) return;
+  forwardTimers.resize(n);
+  backwardTimers.resize(n);
+  for(unsigned i=0; i<n; i++) {
+    std::string num; Tools::convert(i,num);
+    forwardTimers[i]=stopwatch.getTimerId("4A "+num+" "+actionSet[i]->getLabel());
+// in the backward loop actions are numbered in reverse order
+    backwardTimers[i]=stopwatch.getTimerId("5A "+num+" "+actionSet[n-1-i]->getLabel());
+  }
+}
+
+void PlumedMain::startTrace(const std::string&file) {
+  plumed_massert(!traceFile,"a timeline is already being written");
+// each process writes its own file
+  std::string name=file;
+  if(comm.Get_rank()>0) {
+    std::string rank; Tools::convert(comm.Get_rank(),rank);
+    name+="."+rank;
+  }
+  traceFile.reset(new OFile);
+  traceFile->enforceSuffix(getSuffix());
+  traceFile->open(name);
+  traceFile->printf("[\n");
+  stopwatch.setTrace(true);
 }
 
 void PlumedMain::update() {
   if(!active)return;
 
-  stopwatch.start("6 Update");
+  stopwatch.start(timerUpdate);
 // update step (for statistics, etc)
   updateFlags.push(true);
   for(const auto & p : actionSet) {
@@ -766,7 +866,33 @@ void PlumedMain::update() {
     log.flush();
     for(const auto & p : actionSet) p->fflush();
   }
-  stopwatch.stop("6 Update");
+  stopwatch.stop(timerUpdate);
+// the timeline is written at every step so as to keep the memory footprint small
+  if(traceFile) stopwatch.writeTrace(*traceFile,comm.Get_rank());
+  updateMemoryHighWater();
+}
+
+std::size_t PlumedMain::updateMemoryHighWater() {
+  std::size_t total=0;
+  for(const auto & p : actionSet) total+=p->updateMemoryHighWater();
+  if(total>memoryHighWater) memoryHighWater=total;
+  return total;
+}
+
+std::size_t PlumedMain::writeMemoryReport() {
+  updateMemoryHighWater();
+  log.printf("Memory used by the actions (kB):\n");
+  log.printf("  %-40s %14s %14s\n","","current","high-water");
+  std::size_t total=0;
+  for(const auto & p : actionSet) {
+    std::size_t m=p->getMemoryUsage();
+    total+=m;
+    if(m==0 && p->getMemoryHighWater()==0) continue;
+    log.printf("  %-40s %14.1f %14.1f\n",(p->getLabel()+" ("+p->getName()+")").c_str(),m/1024.0,p->getMemoryHighWater()/1024.0);
+    for(const auto & b : p->getMemoryBlocks()) if(b.second>0) log.printf("    %-38s %14.1f\n",b.first.c_str(),b.second/1024.0);
+  }
+  log.printf("  %-40s %14.1f %14.1f\n","total",total/1024.0,memoryHighWater/1024.0);
+  return total;
 }
 
 void PlumedMain::load(const std::string& ss) {
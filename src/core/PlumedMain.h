@@ -63,6 +63,8 @@ class Stopwatch;
 class Citations;
 class ExchangePatterns;
 class FileBase;
+class OFile;
+class Arena;
 class DataFetchingObject;
 
 /**
@@ -104,6 +106,23 @@ private:
   ForwardDecl<Stopwatch> stopwatch_fwd;
   Stopwatch& stopwatch=*stopwatch_fwd;
 
+/// IDs of the timers of the steps of calc()
+  unsigned timerPrepare,timerShare,timerWait,timerForward,timerBackward,timerUpdateForces,timerUpdate;
+/// IDs of the detailed timers of each action in the forward and backward loops
+  std::vector<unsigned> forwardTimers,backwardTimers;
+/// Create the detailed timers of the actions, if they have changed
+  void setupDetailedTimers();
+/// File on which the timeline of the calculation is written
+  std::unique_ptr<OFile> traceFile;
+
+/// Arenas for the temporary storage of the step, one per OpenMP thread
+  std::vector<std::unique_ptr<Arena>> arenas;
+
+/// Largest memory used by all the actions at the end of a step
+  std::size_t memoryHighWater=0;
+/// Measure the memory used by the actions and update the high-water marks
+  std::size_t updateMemoryHighWater();
+
   std::unique_ptr<WithCmd> grex;
 /// Flag to avoid double initialization
   bool  initialized;
@@ -152,6 +171,15 @@ private:
 /// These are the action the, if they are Pilot::onStep(), can trigger execution
   std::vector<ActionPilot*> pilots;
 
+/// Number of steps after which the pilots that are on step repeat (zero if they do not)
+  long int pilotsPeriod;
+/// The pilots that are on step, for each step modulo pilotsPeriod
+  std::vector<std::vector<ActionPilot*> > pilotsOnStep;
+/// The elements of pilotsOnStep that have already been computed
+  std::vector<bool> pilotsOnStepDone;
+/// Compute pilotsPeriod from the strides of the pilots
+  void setupPilots();
+
 /// Suffix string for file opening, useful for multiple simulations in the same directory
   std::string suffix;
 
@@ -319,6 +347,16 @@ public:
   const ActionSet & getActionSet()const;
 /// Referenge to the log stream
   Log & getLog();
+/// Reference to the timers
+  Stopwatch & getStopwatch() {return stopwatch;}
+/// Arena of the calling OpenMP thread.
+/// It can be used for temporary storage that is not needed after the end of
+/// the step, since all the arenas are reset at the beginning of every calculation.
+  Arena & getArena();
+/// Start writing on file a timeline of the calculation in the Chrome trace event format
+  void startTrace(const std::string&file);
+/// Write on the log the memory used by each action, and return the total (bytes)
+  std::size_t writeMemoryReport();
 /// Return the number of the step
   long int getStep()const {return step;}
 /// Stop the run
@@ -115,6 +115,8 @@ public:
   unsigned getNumberOfDerivatives() const;
 /// Set the number of derivatives
   void resizeDerivatives(int n);
+/// Get the memory allocated for this value (bytes)
+  std::size_t getMemoryUsage() const;
 /// Set all the derivatives to zero
   void clearDerivatives();
 /// Add some derivative to the ith component of the derivatives array
@@ -217,6 +219,11 @@ const std::string& Value::getName()const {
   return name;
 }
 
+inline
+std::size_t Value::getMemoryUsage() const {
+  return sizeof(Value)+derivatives.capacity()*sizeof(double);
+}
+
 inline
 unsigned Value::getNumberOfDerivatives() const {
   plumed_massert(hasDeriv,"the derivatives array for this value has zero size");
@@ -23,6 +23,7 @@
 #include "tools/SwitchingFunction.h"
 
 #include <string>
+#include <vector>
 #include <cmath>
 
 using namespace std;
@@ -32,7 +33,7 @@ namespace crystallization {
 
 void CubicHarmonicBase::registerKeywords( Keywords& keys ) {
   multicolvar::MultiColvarBase::registerKeywords( keys );
-  keys.use("SPECIES"); keys.use("SPECIESA"); keys.use("SPECIESB");
+  keys.use("SPECIES"); keys.use("SPECIESA"); keys.use("SPECIESB"); keys.use("NL_SKIN");
   keys.add("compulsory","NN","6","The n parameter of the switching function ");
   keys.add("compulsory","MM","0","The m parameter of the switching function; 0 implies 2*NN");
   keys.add("compulsory","D_0","0.0","The d_0 parameter of the switching function");
@@ -100,44 +101,50 @@ double CubicHarmonicBase::compute( const unsigned& tindex, multicolvar::AtomValu
   // Calculate the coordination number
   Vector myder, rotateder, fder; unsigned nat=myatoms.getNumberOfAtoms();
 
-  double d2;
+  // Find the atoms that are within the cutoff and compute all the switching functions at once
+  // The scratch arrays are owned by the MultiValue of the thread, so that they are not allocated for every task
+  MultiValue& myvals=myatoms.getUnderlyingMultiValue();
+  unsigned nn=0; unsigned* nind=myvals.getWorkIndices( nat );
+  double* d2=myvals.getWorkVector( 3*nat ); double* swv=d2+nat; double* dfuncv=swv+nat;
   for(unsigned i=1; i<nat; ++i) {
     Vector& distance=myatoms.getPosition(i);
-
-    if ( (d2=distance[0]*distance[0])<rcut2 &&
-         (d2+=distance[1]*distance[1])<rcut2 &&
-         (d2+=distance[2]*distance[2])<rcut2 &&
-         d2>epsilon ) {
-
-      double sw = switchingFunction.calculateSqr( d2, dfunc );
-
-      rotatedis[0]=rotationmatrix[0][0]*distance[0]
-                   +rotationmatrix[0][1]*distance[1]
-                   +rotationmatrix[0][2]*distance[2];
-      rotatedis[1]=rotationmatrix[1][0]*distance[0]
-                   +rotationmatrix[1][1]*distance[1]
-                   +rotationmatrix[1][2]*distance[2];
-      rotatedis[2]=rotationmatrix[2][0]*distance[0]
-                   +rotationmatrix[2][1]*distance[1]
-                   +rotationmatrix[2][2]*distance[2];
-
-      double tmp = calculateCubicHarmonic( rotatedis, d2, rotateder );
-
-      myder[0]=rotationmatrix[0][0]*rotateder[0]
-               +rotationmatrix[1][0]*rotateder[1]
-               +rotationmatrix[2][0]*rotateder[2];
-      myder[1]=rotationmatrix[0][1]*rotateder[0]
-               +rotationmatrix[1][1]*rotateder[1]
-               +rotationmatrix[2][1]*rotateder[2];
-      myder[2]=rotationmatrix[0][2]*rotateder[0]
-               +rotationmatrix[1][2]*rotateder[1]
-               +rotationmatrix[2][2]*rotateder[2];
-
-      fder = (+dfunc)*tmp*distance + sw*myder;
-
-      accumulateSymmetryFunction( 1, i, sw*tmp, fder, Tensor(distance,-fder), myatoms );
-      accumulateSymmetryFunction( -1, i, sw, (+dfunc)*distance, (-dfunc)*Tensor(distance,distance), myatoms );
-    }
+    if ( (d2[nn]=distance[0]*distance[0])<rcut2 &&
+         (d2[nn]+=distance[1]*distance[1])<rcut2 &&
+         (d2[nn]+=distance[2]*distance[2])<rcut2 &&
+         d2[nn]>epsilon ) { nind[nn]=i; nn++; }
+  }
+  switchingFunction.calculateSqr( d2, nn, swv, dfuncv );
+
+  for(unsigned k=0; k<nn; ++k) {
+    unsigned i=nind[k]; Vector& distance=myatoms.getPosition(i);
+    double sw=swv[k]; dfunc=dfuncv[k];
+
+    rotatedis[0]=rotationmatrix[0][0]*distance[0]
+                 +rotationmatrix[0][1]*distance[1]
+                 +rotationmatrix[0][2]*distance[2];
+    rotatedis[1]=rotationmatrix[1][0]*distance[0]
+                 +rotationmatrix[1][1]*distance[1]
+                 +rotationmatrix[1][2]*distance[2];
+    rotatedis[2]=rotationmatrix[2][0]*distance[0]
+                 +rotationmatrix[2][1]*distance[1]
+                 +rotationmatrix[2][2]*distance[2];
+
+    double tmp = calculateCubicHarmonic( rotatedis, d2[k], rotateder );
+
+    myder[0]=rotationmatrix[0][0]*rotateder[0]
+             +rotationmatrix[1][0]*rotateder[1]
+             +rotationmatrix[2][0]*rotateder[2];
+    myder[1]=rotationmatrix[0][1]*rotateder[0]
+             +rotationmatrix[1][1]*rotateder[1]
+             +rotationmatrix[2][1]*rotateder[2];
+    myder[2]=rotationmatrix[0][2]*rotateder[0]
+             +rotationmatrix[1][2]*rotateder[1]
+             +rotationmatrix[2][2]*rotateder[2];
+
+    fder = (+dfunc)*tmp*distance + sw*myder;
+
+    accumulateSymmetryFunction( 1, i, sw*tmp, fder, Tensor(distance,-fder), myatoms );
+    accumulateSymmetryFunction( -1, i, sw, (+dfunc)*distance, (-dfunc)*Tensor(distance,distance), myatoms );
   }
   // values -> der of... value [0], weight[1], x coord [2], y, z... [more magic]
   updateActiveAtoms( myatoms );
@@ -21,7 +21,7 @@
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 #include "Steinhardt.h"
 #include "core/PlumedMain.h"
-#include <complex>
+#include <map>
 
 namespace PLMD {
 namespace crystallization {
@@ -35,7 +35,7 @@ void Steinhardt::registerKeywords( Keywords& keys ) {
   keys.add("optional","SWITCH","This keyword is used if you want to employ an alternative to the continuous swiching function defined above. "
            "The following provides information on the \\ref switchingfunction that are available. "
            "When this keyword is present you no longer need the NN, MM, D_0 and R_0 keywords.");
-  keys.use("SPECIES"); keys.use("SPECIESA"); keys.use("SPECIESB");
+  keys.use("SPECIES"); keys.use("SPECIESA"); keys.use("SPECIESB"); keys.use("NL_SKIN");
   keys.use("MEAN"); keys.use("LESS_THAN"); keys.use("MORE_THAN"); keys.use("VMEAN");
   keys.use("BETWEEN"); keys.use("HISTOGRAM"); keys.use("MOMENTS"); keys.use("MIN"); keys.use("ALT_MIN");
   keys.use("LOWEST"); keys.use("HIGHEST");
@@ -44,7 +44,8 @@ void Steinhardt::registerKeywords( Keywords& keys ) {
 Steinhardt::Steinhardt( const ActionOptions& ao ):
   Action(ao),
   VectorMultiColvar(ao),
-  tmom(0)
+  tmom(0),
+  poly_table(NULL)
 {
   // Read in the switching function
   std::string sw, errors; parse("SWITCH",sw);
@@ -65,86 +66,139 @@ Steinhardt::Steinhardt( const ActionOptions& ao ):
   std::vector<AtomNumber> all_atoms; setupMultiColvarBase( all_atoms );
 }
 
+const std::vector<double>& Steinhardt::getPolynomialTable( const unsigned& ang ) {
+  static std::map<unsigned,std::vector<double> > tables;
+  std::map<unsigned,std::vector<double> >::iterator it=tables.find( ang );
+  if( it!=tables.end() ) return it->second;
+
+  std::vector<double> fact( 2*ang+2 ); fact[0]=1.0;
+  for(unsigned i=1; i<fact.size(); ++i) fact[i]=fact[i-1]*i;
+  // Coefficients of the Legendre polynomial of order ang
+  std::vector<double> coeff( ang+1, 0.0 );
+  for(unsigned k=0; 2*k<=ang; ++k) {
+    double binom1=fact[ang]/(fact[k]*fact[ang-k]), binom2=fact[2*ang-2*k]/(fact[ang]*fact[ang-2*k]);
+    coeff[ang-2*k]=( (k%2==0) ? 1.0 : -1.0 )*binom1*binom2/std::pow(2.0,static_cast<double>(ang));
+  }
+  // Spherical harmonics normalization:
+  // even =  sqrt ( ((2l+1)*(l-m)!) / (4*pi*(l+m)!) )
+  // odd  = -sqrt ( ((2l+1)*(l-m)!) / (4*pi*(l+m)!) )
+  std::vector<double> norm( ang+1 );
+  for(unsigned m=0; m<=ang; ++m) {
+    norm[m]=( (m%2==0) ? 1.0 : -1.0 )*sqrt( ( (2*ang+1)*fact[ang-m] ) / (4.0*pi*fact[ang+m]) );
+  }
+  // Element m*(ang+1)+j of the table is the coefficient of z^j in the m-th derivative of the
+  // Legendre polynomial multiplied by the normalization.  The last ang+1 elements are the
+  // coefficients of the polynomial and the ang+1 before that are the normalizations.
+  std::vector<double>& table=tables[ang]; table.assign( (ang+3)*(ang+1), 0.0 );
+  for(unsigned m=0; m<=ang; ++m) {
+    for(unsigned j=0; j<=ang-m; ++j) table[m*(ang+1)+j]=norm[m]*coeff[m+j]*fact[m+j]/fact[j];
+  }
+  for(unsigned m=0; m<=ang; ++m) { table[(ang+1)*(ang+1)+m]=norm[m]; table[(ang+2)*(ang+1)+m]=coeff[m]; }
+  return table;
+}
+
 void Steinhardt::setAngularMomentum( const unsigned& ang ) {
   tmom=ang; setVectorDimensionality( 2*(2*ang + 1) );
+  poly_table=&getPolynomialTable( tmom );
+  normaliz.assign( poly_table->begin()+(tmom+1)*(tmom+1), poly_table->begin()+(tmom+2)*(tmom+1) );
+  coeff_poly.assign( poly_table->begin()+(tmom+2)*(tmom+1), poly_table->end() );
 }
 
 void Steinhardt::calculateVector( multicolvar::AtomValuePack& myatoms ) const {
-  double dfunc, dpoly_ass, md, tq6, itq6, real_z, imag_z;
+  unsigned nat=myatoms.getNumberOfAtoms(), ncomp=2*tmom+1;
+
+  // Gather the atoms that are within the cutoff so the spherical harmonics
+  // can be computed for all the neighbors at once in the loops below.
+  // The scratch arrays are owned by the MultiValue of the thread and reused for all tasks
+  MultiValue& myvals=myatoms.getUnderlyingMultiValue();
+  unsigned* nind=myvals.getWorkIndices( nat );
+  double* sw=myvals.getWorkVector( 13*nat ); double* dfunc=sw+nat; double* dlen=dfunc+nat;
+  double* ux=dlen+nat; double* uy=ux+nat; double* uz=uy+nat;
+  double* poly=uz+nat; double* dpoly=poly+nat;
+  double* pr=dpoly+nat; double* pim=pr+nat; double* cr=pim+nat; double* ci=cr+nat;
+  double* dsq=ci+nat;
+
+  unsigned nn=0;
+  for(unsigned i=1; i<nat; ++i) {
+    Vector& distance=myatoms.getPosition(i);
+    if ( (dsq[nn]=distance[0]*distance[0])<rcut2 &&
+         (dsq[nn]+=distance[1]*distance[1])<rcut2 &&
+         (dsq[nn]+=distance[2]*distance[2])<rcut2 &&
+         dsq[nn]>epsilon ) { nind[nn]=i; nn++; }
+  }
+  switchingFunction.calculateSqr( dsq, nn, sw, dfunc );
+
+  // Unit vectors along the bonds
+  for(unsigned k=0; k<nn; ++k) {
+    const Vector& distance=myatoms.getPosition(nind[k]);
+    dlen[k]=sqrt(dsq[k]);
+    ux[k]=distance[0]/dlen[k]; uy[k]=distance[1]/dlen[k]; uz[k]=distance[2]/dlen[k];
+  }
+
+  // The weights in the denominator
+  for(unsigned k=0; k<nn; ++k) {
+    const Vector& distance=myatoms.getPosition(nind[k]);
+    accumulateSymmetryFunction( -1, nind[k], sw[k], (+dfunc[k])*distance, (-dfunc[k])*Tensor( distance,distance ), myatoms );
+  }
+
+  // (x+iy)/r to the power m-1 and to the power m
+  for(unsigned k=0; k<nn; ++k) { pr[k]=1.0; pim[k]=0.0; cr[k]=1.0; ci[k]=0.0; }
+
   Vector dz, myrealvec, myimagvec, real_dz, imag_dz;
-  // The square root of -1
-  std::complex<double> ii( 0.0, 1.0 ), dp_x, dp_y, dp_z;
-
-  unsigned ncomp=2*tmom+1;
-  double sw, poly_ass, d2, dlen; std::complex<double> powered;
-  for(unsigned i=1; i<myatoms.getNumberOfAtoms(); ++i) {
-    Vector& distance=myatoms.getPosition(i);  // getSeparation( myatoms.getPosition(0), myatoms.getPosition(i) );
-    if ( (d2=distance[0]*distance[0])<rcut2 &&
-         (d2+=distance[1]*distance[1])<rcut2 &&
-         (d2+=distance[2]*distance[2])<rcut2 &&
-         d2>epsilon ) {
-
-      dlen = sqrt(d2);
-      sw = switchingFunction.calculate( dlen, dfunc );
-      accumulateSymmetryFunction( -1, i, sw, (+dfunc)*distance, (-dfunc)*Tensor( distance,distance ), myatoms );
-      double dlen3 = d2*dlen;
-      // Do stuff for m=0
-      poly_ass=deriv_poly( 0, distance[2]/dlen, dpoly_ass );
+  for(unsigned m=0; m<=tmom; ++m) {
+    // Evaluate the polynomial and its derivative for all neighbors using Horner's rule
+    const double* coeff=poly_table->data()+m*(tmom+1); int nterm=tmom-m;
+    #pragma omp simd
+    for(unsigned k=0; k<nn; ++k) {
+      double p=coeff[nterm], dp=0.0;
+      for(int j=nterm-1; j>=0; --j) { dp=dp*uz[k]+p; p=p*uz[k]+coeff[j]; }
+      poly[k]=p; dpoly[k]=dp;
+    }
+    if( m>0 ) {
+      // Update the powers of the complex number
+      #pragma omp simd
+      for(unsigned k=0; k<nn; ++k) {
+        pr[k]=cr[k]; pim[k]=ci[k];
+        cr[k]=pr[k]*ux[k] - pim[k]*uy[k]; ci[k]=pr[k]*uy[k] + pim[k]*ux[k];
+      }
+    }
+    for(unsigned k=0; k<nn; ++k) {
+      const Vector& distance=myatoms.getPosition(nind[k]);
+      double dlen3=dlen[k]*dlen[k]*dlen[k];
       // Derivatives of z/r wrt x, y, z
-      dz = -( distance[2] / dlen3 )*distance; dz[2] += (1.0 / dlen);
-      // Derivative wrt to the vector connecting the two atoms
-      myrealvec = (+sw)*dpoly_ass*dz + poly_ass*(+dfunc)*distance;
-      // Accumulate the derivatives
-      accumulateSymmetryFunction( 2 + tmom, i, sw*poly_ass, myrealvec, Tensor( -myrealvec,distance ), myatoms );
-
-      // The complex number of which we have to take powers
-      std::complex<double> com1( distance[0]/dlen,distance[1]/dlen );
-      powered = std::complex<double>(1.0,0.0);
-
-      // Do stuff for all other m values
-      for(unsigned m=1; m<=tmom; ++m) {
-        // Calculate Legendre Polynomial
-        poly_ass=deriv_poly( m, distance[2]/dlen, dpoly_ass );
-        // Calculate power of complex number
-        // if(std::abs(com1)>epsilon) powered=pow(com1,m-1);
-        // else if(m==1) powered=std::complex<double>(1.,0);
-        // else powered = std::complex<double>(0.,0.);
-        // Real and imaginary parts of z
-        real_z = real(com1*powered); imag_z = imag(com1*powered );
-
-        // Calculate steinhardt parameter
-        tq6=poly_ass*real_z;   // Real part of steinhardt parameter
-        itq6=poly_ass*imag_z;  // Imaginary part of steinhardt parameter
-
-        // Derivatives wrt ( x/r + iy )^m
-        md=static_cast<double>(m);
-        dp_x = md*powered*( (1.0/dlen)-(distance[0]*distance[0])/dlen3-ii*(distance[0]*distance[1])/dlen3 );
-        dp_y = md*powered*( ii*(1.0/dlen)-(distance[0]*distance[1])/dlen3-ii*(distance[1]*distance[1])/dlen3 );
-        dp_z = md*powered*( -(distance[0]*distance[2])/dlen3-ii*(distance[1]*distance[2])/dlen3 );
-
-        // Derivatives of real and imaginary parts of above
-        real_dz[0] = real( dp_x ); real_dz[1] = real( dp_y ); real_dz[2] = real( dp_z );
-        imag_dz[0] = imag( dp_x ); imag_dz[1] = imag( dp_y ); imag_dz[2] = imag( dp_z );
-
-        // Complete derivative of steinhardt parameter
-        myrealvec = (+sw)*dpoly_ass*real_z*dz + (+dfunc)*distance*tq6 + (+sw)*poly_ass*real_dz;
-        myimagvec = (+sw)*dpoly_ass*imag_z*dz + (+dfunc)*distance*itq6 + (+sw)*poly_ass*imag_dz;
-
-        // Real part
-        accumulateSymmetryFunction( 2 + tmom + m, i, sw*tq6, myrealvec, Tensor( -myrealvec,distance ), myatoms );
-        // Imaginary part
-        accumulateSymmetryFunction( 2+ncomp+tmom+m, i, sw*itq6, myimagvec, Tensor( -myimagvec,distance ), myatoms );
-        // Store -m part of vector
-        double pref=pow(-1.0,m);
-        // -m part of vector is just +m part multiplied by (-1.0)**m and multiplied by complex
-        // conjugate of Legendre polynomial
-        // Real part
-        accumulateSymmetryFunction( 2+tmom-m, i, pref*sw*tq6, pref*myrealvec, pref*Tensor( -myrealvec,distance ), myatoms );
-        // Imaginary part
-        accumulateSymmetryFunction( 2+ncomp+tmom-m, i, -pref*sw*itq6, -pref*myimagvec, pref*Tensor( myimagvec,distance ), myatoms );
-        // Calculate next power of complex number
-        powered *= com1;
+      dz = -( distance[2] / dlen3 )*distance; dz[2] += (1.0 / dlen[k]);
+      if( m==0 ) {
+        // Derivative wrt to the vector connecting the two atoms
+        myrealvec = (+sw[k])*dpoly[k]*dz + poly[k]*(+dfunc[k])*distance;
+        accumulateSymmetryFunction( 2 + tmom, nind[k], sw[k]*poly[k], myrealvec, Tensor( -myrealvec,distance ), myatoms );
+        continue;
       }
+      // Real and imaginary parts of the steinhardt parameter
+      double tq6=poly[k]*cr[k], itq6=poly[k]*ci[k];
+      // Derivatives wrt ( x/r + iy/r )^m.  These are m*((x+iy)/r)^(m-1) times the derivative of (x+iy)/r
+      double md=static_cast<double>(m), ir=1.0/dlen[k];
+      double axr=ir-distance[0]*distance[0]/dlen3, axi=-distance[0]*distance[1]/dlen3;
+      double ayr=-distance[0]*distance[1]/dlen3, ayi=ir-distance[1]*distance[1]/dlen3;
+      double azr=-distance[0]*distance[2]/dlen3, azi=-distance[1]*distance[2]/dlen3;
+      real_dz[0] = md*(pr[k]*axr - pim[k]*axi); imag_dz[0] = md*(pr[k]*axi + pim[k]*axr);
+      real_dz[1] = md*(pr[k]*ayr - pim[k]*ayi); imag_dz[1] = md*(pr[k]*ayi + pim[k]*ayr);
+      real_dz[2] = md*(pr[k]*azr - pim[k]*azi); imag_dz[2] = md*(pr[k]*azi + pim[k]*azr);
+
+      // Complete derivative of steinhardt parameter
+      myrealvec = (+sw[k])*dpoly[k]*cr[k]*dz + (+dfunc[k])*distance*tq6 + (+sw[k])*poly[k]*real_dz;
+      myimagvec = (+sw[k])*dpoly[k]*ci[k]*dz + (+dfunc[k])*distance*itq6 + (+sw[k])*poly[k]*imag_dz;
+
+      // Real part
+      accumulateSymmetryFunction( 2 + tmom + m, nind[k], sw[k]*tq6, myrealvec, Tensor( -myrealvec,distance ), myatoms );
+      // Imaginary part
+      accumulateSymmetryFunction( 2+ncomp+tmom+m, nind[k], sw[k]*itq6, myimagvec, Tensor( -myimagvec,distance ), myatoms );
+      // -m part of vector is just +m part multiplied by (-1.0)**m and multiplied by complex
+      // conjugate of Legendre polynomial
+      double pref=( (m%2==0) ? 1.0 : -1.0 );
+      // Real part
+      accumulateSymmetryFunction( 2+tmom-m, nind[k], pref*sw[k]*tq6, pref*myrealvec, pref*Tensor( -myrealvec,distance ), myatoms );
+      // Imaginary part
+      accumulateSymmetryFunction( 2+ncomp+tmom-m, nind[k], -pref*sw[k]*itq6, -pref*myimagvec, pref*Tensor( myimagvec,distance ), myatoms );
     }
   }
 
@@ -154,20 +208,10 @@ void Steinhardt::calculateVector( multicolvar::AtomValuePack& myatoms ) const {
 }
 
 double Steinhardt::deriv_poly( const unsigned& m, const double& val, double& df ) const {
-  double fact=1.0;
-  for(unsigned j=1; j<=m; ++j) fact=fact*j;
-  double res=coeff_poly[m]*fact;
-
-  double pow=1.0, xi=val, dxi=1.0; df=0.0;
-  for(int i=m+1; i<=tmom; ++i) {
-    double fact=1.0;
-    for(unsigned j=i-m+1; j<=i; ++j) fact=fact*j;
-    res=res+coeff_poly[i]*fact*xi;
-    df = df + pow*coeff_poly[i]*fact*dxi;
-    xi=xi*val; dxi=dxi*val; pow+=1.0;
-  }
-  df = df*normaliz[m];
-  return normaliz[m]*res;
+  const double* coeff=poly_table->data()+m*(tmom+1);
+  double res=coeff[tmom-m]; df=0.0;
+  for(int j=tmom-m-1; j>=0; --j) { df=df*val+res; res=res*val+coeff[j]; }
+  return res;
 }
 
 }
@@ -22,7 +22,6 @@
 #ifndef __PLUMED_crystallization_Steinhardt_h
 #define __PLUMED_crystallization_Steinhardt_h
 
-#include <complex>
 #include "tools/SwitchingFunction.h"
 #include "VectorMultiColvar.h"
 
@@ -34,6 +33,11 @@ private:
   unsigned tmom;
   double rcut,rcut2;
   SwitchingFunction switchingFunction;
+/// The table of polynomial coefficients for all the values of m.  This is shared
+/// between all the Steinhardt parameters with the same angular momentum
+  const std::vector<double>* poly_table;
+/// Get the table of coefficients of the normalized associated Legendre polynomials
+  static const std::vector<double>& getPolynomialTable( const unsigned& ang );
 protected:
   std::vector<double> coeff_poly;
   std::vector<double> normaliz;
@@ -87,6 +87,7 @@ class Combine :
 public:
   explicit Combine(const ActionOptions&);
   void calculate();
+  bool isTimeIndependent()const {return true;}
   static void registerKeywords(Keywords& keys);
 };
 
@@ -181,19 +181,21 @@ void Ensemble::calculate() {
 
   vector<double> mean(narg);
   vector<double> dmean(narg,fact);
+  vector<double> v_moment, dv_moment;
+  if(do_moments) {
+    v_moment.resize(narg);
+    dv_moment.resize(narg);
+  }
   // calculate the mean
   if(master) {
     for(unsigned i=0; i<narg; ++i) mean[i] = fact*getArgument(i);
-    if(ens_dim>1) multi_sim_comm.Sum(&mean[0], narg);
+    if(ens_dim>1) multi_sim_comm.DeferSum(&mean[0], narg);
   }
-  comm.Sum(&mean[0], narg);
+  comm.DeferSum(&mean[0], narg);
 
-  vector<double> v_moment, dv_moment;
   // calculate other moments
   if(do_moments) {
-    v_moment.resize(narg);
-    dv_moment.resize(narg);
-    // standard moment
+    // standard moment, summed together with the mean
     if(!do_central) {
       if(master) {
         for(unsigned i=0; i<narg; ++i) {
@@ -201,15 +203,22 @@ void Ensemble::calculate() {
           v_moment[i]      = tmp*getArgument(i);
           dv_moment[i]     = moment*tmp;
         }
-        if(ens_dim>1) multi_sim_comm.Sum(&v_moment[0], narg);
+        if(ens_dim>1) multi_sim_comm.DeferSum(&v_moment[0], narg);
       } else {
         for(unsigned i=0; i<narg; ++i) {
           const double tmp = fact*pow(getArgument(i),moment-1);
           dv_moment[i]     = moment*tmp;
         }
       }
-      // central moment
-    } else {
+      comm.DeferSum(&v_moment[0], narg);
+    }
+  }
+  if(master && ens_dim>1) multi_sim_comm.SumDeferred();
+  comm.SumDeferred();
+
+  if(do_moments) {
+    // central moment
+    if(do_central) {
       if(master) {
         for(unsigned i=0; i<narg; ++i) {
           const double tmp = pow(getArgument(i)-mean[i],moment-1);
@@ -223,8 +232,8 @@ void Ensemble::calculate() {
           dv_moment[i]     = moment*tmp*(fact-fact/norm);
         }
       }
+      comm.Sum(&v_moment[0], narg);
     }
-    comm.Sum(&v_moment[0], narg);
   }
 
   // calculate powers of moments
@@ -188,6 +188,7 @@ class Matheval :
 public:
   explicit Matheval(const ActionOptions&);
   void calculate();
+  bool isTimeIndependent()const {return true;}
   static void registerKeywords(Keywords& keys);
 };
 
@@ -77,6 +77,7 @@ class Piecewise :
 public:
   explicit Piecewise(const ActionOptions&);
   void calculate();
+  bool isTimeIndependent()const {return true;}
   static void registerKeywords(Keywords& keys);
 };
 
@@ -63,6 +63,7 @@ class Sort :
 public:
   explicit Sort(const ActionOptions&);
   void calculate();
+  bool isTimeIndependent()const {return true;}
   static void registerKeywords(Keywords& keys);
 };
 
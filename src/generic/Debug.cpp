@@ -44,6 +44,17 @@ DEBUG DETAILED_TIMERS
 DEBUG logRequestedAtoms STRIDE=2
 \endplumedfile
 
+A timeline of the calculation can be written with the TRACE keyword.
+The resulting file uses the Chrome trace event format and can be opened with
+chrome://tracing or with Perfetto (https://ui.perfetto.dev).
+Every step shows the time spent sharing and waiting for atoms, in the forward and backward loops
+and in update. Combined with DETAILED_TIMERS it also shows the time spent in each action.
+When running with MPI, every process writes its own file, labelled with its rank.
+
+\plumedfile
+DEBUG DETAILED_TIMERS TRACE=trace.json
+\endplumedfile
+
 */
 //+ENDPLUMEDOC
 class Debug:
@@ -73,6 +84,7 @@ void Debug::registerKeywords( Keywords& keys ) {
   keys.addFlag("NOVIRIAL",false,"switch off the virial contribution for the entirity of the simulation");
   keys.addFlag("DETAILED_TIMERS",false,"switch on detailed timers");
   keys.add("optional","FILE","the name of the file on which to output these quantities");
+  keys.add("optional","TRACE","the name of the file on which to write a timeline of the calculation in the Chrome trace event format");
 }
 
 Debug::Debug(const ActionOptions&ao):
@@ -101,6 +113,12 @@ Debug::Debug(const ActionOptions&ao):
     log.printf("  on plumed log file\n");
     ofile.link(log);
   }
+  std::string trace;
+  parse("TRACE",trace);
+  if(trace.length()>0) {
+    log.printf("  writing timeline on file %s\n",trace.c_str());
+    plumed.startTrace(trace);
+  }
   checkRead();
 }
 
@@ -189,6 +189,9 @@ EffectiveEnergyDrift::EffectiveEnergyDrift(const ActionOptions&ao):
   indexR.resize(atoms.getNatoms());
   dataR.resize(atoms.getNatoms()*6);
   backmap.resize(atoms.getNatoms());
+
+  // forces of plumed are needed in the global array
+  atoms.forbidZeroCopy();
 }
 
 EffectiveEnergyDrift::~EffectiveEnergyDrift() {
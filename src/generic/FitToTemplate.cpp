@@ -242,6 +242,7 @@ FitToTemplate::FitToTemplate(const ActionOptions&ao):
   // this is required so as to allow modifyGlobalForce() to return correct
   // also for forces that are not owned (and thus not zeored) by all processors.
   allowToAccessGlobalForces();
+  allowToModifyGlobalPositions();
 }
 
 
@@ -120,6 +120,8 @@ ResetCell::ResetCell(const ActionOptions&ao):
   } else error("undefined type "+type);
 
   checkRead();
+
+  allowToModifyGlobalPositions();
 }
 
 
@@ -25,6 +25,7 @@
 #include "tools/Vector.h"
 #include "tools/AtomNumber.h"
 #include "tools/Tools.h"
+#include "tools/OpenMP.h"
 #include "core/Atoms.h"
 #include "core/PlumedMain.h"
 #include "core/ActionSet.h"
@@ -105,6 +106,14 @@ class WholeMolecules:
   public ActionAtomistic
 {
   vector<vector<AtomNumber> > groups;
+/// true if no atom belongs to more than one entity, so that entities can be rebuilt in parallel
+  bool disjointGroups;
+/// atoms of all the entities, one entity after the other
+  vector<AtomNumber> flat;
+/// index in flat of the first atom of each entity, plus the total number of atoms
+  vector<unsigned> start;
+/// bond between each atom in flat and the previous one
+  vector<Vector> bonds;
 public:
   explicit WholeMolecules(const ActionOptions&ao);
   static void registerKeywords( Keywords& keys );
@@ -131,7 +140,8 @@ void WholeMolecules::registerKeywords( Keywords& keys ) {
 WholeMolecules::WholeMolecules(const ActionOptions&ao):
   Action(ao),
   ActionPilot(ao),
-  ActionAtomistic(ao)
+  ActionAtomistic(ao),
+  disjointGroups(true)
 {
   vector<AtomNumber> merge;
   for(int i=0;; i++) {
@@ -169,18 +179,49 @@ WholeMolecules::WholeMolecules(const ActionOptions&ao):
   if(groups.size()==0) error("no atom found for WHOLEMOLECULES!");
 
   checkRead();
+  unsigned ntot=merge.size();
   Tools::removeDuplicates(merge);
+  disjointGroups=(merge.size()==ntot);
+  for(const auto & g : groups) {
+    start.push_back(flat.size());
+    flat.insert(flat.end(),g.begin(),g.end());
+  }
+  start.push_back(flat.size());
+  bonds.resize(flat.size());
   requestAtoms(merge);
   doNotRetrieve();
   doNotForce();
+  allowToModifyGlobalPositions();
 }
 
 void WholeMolecules::calculate() {
-  for(unsigned i=0; i<groups.size(); ++i) {
-    for(unsigned j=0; j<groups[i].size()-1; ++j) {
-      const Vector & first (getPosition(groups[i][j]));
-      Vector & second (modifyPosition(groups[i][j+1]));
-      second=first+pbcDistance(first,second);
+// entities sharing atoms must be rebuilt one after the other
+  if(!disjointGroups) {
+    for(unsigned i=0; i<groups.size(); ++i) {
+      for(unsigned j=0; j<groups[i].size()-1; ++j) {
+        const Vector & first (getPosition(groups[i][j]));
+        Vector & second (modifyPosition(groups[i][j+1]));
+        second=first+pbcDistance(first,second);
+      }
+    }
+    return;
+  }
+
+  const unsigned nn=flat.size();
+  unsigned nt=OpenMP::getNumThreads();
+  if(nt*10>nn) nt=nn/10;
+  if(nt==0)nt=1;
+
+  #pragma omp parallel num_threads(nt)
+  {
+// the periodic images do not change the bonds, so they can be unwrapped independently,
+// also within a single entity (the bond to the first atom of an entity is not used)
+    #pragma omp for
+    for(unsigned k=1; k<nn; ++k) bonds[k]=pbcDistance(getPosition(flat[k-1]),getPosition(flat[k]));
+// each entity is then rebuilt with a prefix sum of its bonds
+    #pragma omp for
+    for(unsigned i=0; i<groups.size(); ++i) {
+      for(unsigned k=start[i]+1; k<start[i+1]; ++k) modifyPosition(flat[k])=getPosition(flat[k-1])+bonds[k];
     }
   }
 }
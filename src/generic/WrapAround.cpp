@@ -205,6 +205,7 @@ WrapAround::WrapAround(const ActionOptions&ao):
   requestAtoms(merged);
   doNotRetrieve();
   doNotForce();
+  allowToModifyGlobalPositions();
 }
 
 void WrapAround::calculate() {
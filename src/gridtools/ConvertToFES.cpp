@@ -72,6 +72,7 @@ public:
   void compute( const unsigned& current, MultiValue& myvals ) const ;
   bool isPeriodic() { return false; }
   bool onStep() const { return activated; }
+  bool onStepIsPeriodic() const { return false; }
   void runFinalJobs();
 };
 
@@ -22,7 +22,8 @@
 #include "GridPrintingBase.h"
 #include "core/PlumedMain.h"
 #include "core/ActionSet.h"
-#include "vesselbase/ActionWithVessel.h"
+#include "vesselbase/ActionWithAveraging.h"
+#include "tools/Communicator.h"
 
 namespace PLMD {
 namespace gridtools {
@@ -39,7 +40,8 @@ void GridPrintingBase::registerKeywords( Keywords& keys ) {
 GridPrintingBase::GridPrintingBase(const ActionOptions&ao):
   Action(ao),
   ActionPilot(ao),
-  fmt("%f")
+  fmt("%f"),
+  walkers_mpi(false)
 {
   std::string mlab; parse("GRID",mlab);
   vesselbase::ActionWithVessel* mves= plumed.getActionSet().selectWithLabel<vesselbase::ActionWithVessel*>(mlab);
@@ -51,6 +53,8 @@ GridPrintingBase::GridPrintingBase(const ActionOptions&ao):
     if( ingrid ) break;
   }
   if( !ingrid ) error("input action does not calculate a grid");
+  vesselbase::ActionWithAveraging* myav=dynamic_cast<vesselbase::ActionWithAveraging*>( mves );
+  if( myav ) walkers_mpi=myav->sumsOverReplicas();
 
   parse("FILE",filename);
   if(filename.length()==0) error("name out output file was not specified");
@@ -74,6 +78,14 @@ void GridPrintingBase::runFinalJobs() {
   if( getStride()>0 ) return;
 
   OFile ofile; ofile.link(*this);
+  // When the grid is summed over the replicas only the first replica writes it
+  if( walkers_mpi ) {
+    int r=0;
+    if(comm.Get_rank()==0) r=multi_sim_comm.Get_rank();
+    comm.Bcast(r,0);
+    if(r>0) return;
+    ofile.enforceSuffix("");
+  }
   ofile.open( filename ); printGrid( ofile ); ofile.close();
 }
 
@@ -33,6 +33,8 @@ class GridPrintingBase : public ActionPilot {
 protected:
   GridVessel* ingrid;
   std::string fmt, filename;
+/// Is the grid summed over all the replicas at the end of the calculation
+  bool walkers_mpi;
 public:
   static void registerKeywords( Keywords& keys );
   explicit GridPrintingBase(const ActionOptions&ao);
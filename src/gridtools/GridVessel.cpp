@@ -178,6 +178,12 @@ std::string GridVessel::description() {
   return des;
 }
 
+std::size_t GridVessel::getMemoryUsage() const {
+  std::size_t m=AveragingVessel::getMemoryUsage()+(forces.capacity()+finalForces.capacity())*sizeof(double);
+  for(const auto & n : fib_nlist) m+=n.capacity()*sizeof(unsigned);
+  return m+active.capacity()/8;
+}
+
 void GridVessel::resize() {
   plumed_massert( nper>0, "Number of datapoints at each grid point has not been set");
   resizeBuffer( getNumberOfBufferPoints()*nper + 1 + 2*getAction()->getNumberOfDerivatives() );
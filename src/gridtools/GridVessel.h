@@ -33,6 +33,7 @@ namespace gridtools {
 class GridVessel : public vesselbase::AveragingVessel {
   friend class ActionWithInputGrid;
   friend class DumpGrid;
+  friend class HistogramOnGrid;
 private:
 /// The way that grid points are constructed
   enum {flat,fibonacci} gtype;
@@ -190,6 +191,8 @@ public:
   bool wasForced() const ;
 /// And retrieve the forces
   bool applyForce( std::vector<double>& fforces );
+/// Get the memory allocated for the grid (bytes)
+  std::size_t getMemoryUsage() const ;
 };
 
 inline
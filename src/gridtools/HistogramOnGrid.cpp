@@ -21,6 +21,7 @@
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 #include "HistogramOnGrid.h"
 #include "tools/KernelFunctions.h"
+#include "core/Value.h"
 
 namespace PLMD {
 namespace gridtools {
@@ -52,6 +53,9 @@ HistogramOnGrid::HistogramOnGrid( const vesselbase::VesselOptions& da ):
   }
 }
 
+HistogramOnGrid::~HistogramOnGrid() {
+}
+
 double HistogramOnGrid::getFibonacciCutoff() const {
   return std::log( epsilon / von_misses_norm ) / von_misses_concentration;
 }
@@ -71,6 +75,14 @@ void HistogramOnGrid::setBounds( const std::vector<std::string>& smin, const std
       if( pbc[i] && 2*support[i]>getGridExtent(i) ) error("bandwidth is too large for periodic grid");
       neigh_tot *= (2*nneigh[i]+1);
     }
+    // The normalization only depends on the bandwidths so it is done once here
+    if( getType()=="flat" ) {
+      std::vector<Value*> vv( getVectorOfValues() );
+      kernel_shape.reset( new KernelFunctions( point, bandwidths, kerneltype, "DIAGONAL", 1.0 ) );
+      kernel_shape->normalize( vv );
+      axis_values.resize( dimension );
+      for(unsigned i=0; i<dimension; ++i) axis_values[i].reset( vv[i] );
+    }
   }
 }
 
@@ -80,8 +92,8 @@ std::unique_ptr<KernelFunctions> HistogramOnGrid::getKernelAndNeighbors( std::ve
     num_neigh=1; for(unsigned i=0; i<dimension; ++i) point[i] += 0.5*dx[i];
     neighbors[0] = getIndex( point ); return NULL;
   } else if( getType()=="flat" ) {
-    std::unique_ptr<KernelFunctions> kernel(new KernelFunctions( point, bandwidths, kerneltype, "DIAGONAL", 1.0 ));
-    kernel->normalize( getVectorOfValues() ); getNeighbors( kernel->getCenter(), nneigh, num_neigh, neighbors );
+    std::unique_ptr<KernelFunctions> kernel(new KernelFunctions( point, bandwidths, kerneltype, "DIAGONAL", kernel_shape->getHeight() ));
+    getNeighbors( kernel->getCenter(), nneigh, num_neigh, neighbors );
     return kernel;
   } else if( getType()=="fibonacci" ) {
     getNeighbors( point, nneigh, num_neigh, neighbors );
@@ -113,64 +125,114 @@ void HistogramOnGrid::calculate( const unsigned& current, MultiValue& myvals, st
     std::vector<double> point( dimension ); double weight=myvals.get(0)*myvals.get( 1+dimension );
     for(unsigned i=0; i<dimension; ++i) point[i]=myvals.get( 1+i );
 
-    // Get the kernel
-    unsigned num_neigh; std::vector<unsigned> neighbors;
-    std::vector<double> der( dimension );
-    std::unique_ptr<KernelFunctions> kernel=getKernelAndNeighbors( point, num_neigh, neighbors );
-
-    if( !kernel && getType()=="flat" ) {
-      plumed_dbg_assert( num_neigh==1 ); der.resize(0);
+    if( discrete ) {
+      // Get the grid point
+      unsigned num_neigh; std::vector<unsigned> neighbors(1); std::vector<double> der;
+      getKernelAndNeighbors( point, num_neigh, neighbors );
+      plumed_dbg_assert( num_neigh==1 );
       accumulate( neighbors[0], weight, 1.0, der, buffer );
+    } else if( getType()=="flat" ) {
+      double totwforce=0.0;
+      std::vector<double> intforce( 2*dimension, 0.0 );
+      accumulateFlatKernel( point, weight, myvals.get( 1+dimension ), buffer, intforce, totwforce );
+      // Minus sign for kernel here as we are taking derivative with respect to position of center of
+      // kernel NOT derivative wrt to grid point
+      if( wasForced() ) accumulateKernelDerivatives( myvals, -1, intforce, totwforce, buffer );
     } else {
+      unsigned num_neigh; std::vector<unsigned> neighbors;
+      getKernelAndNeighbors( point, num_neigh, neighbors );
       double totwforce=0.0;
       std::vector<double> intforce( 2*dimension, 0.0 );
-      std::vector<Value*> vv( getVectorOfValues() );
+      std::vector<double> der( dimension );
 
       double newval; std::vector<unsigned> tindices( dimension ); std::vector<double> xx( dimension );
       for(unsigned i=0; i<num_neigh; ++i) {
         unsigned ineigh=neighbors[i];
         if( inactive( ineigh ) ) continue ;
         getGridPointCoordinates( ineigh, tindices, xx );
-        if( kernel ) {
-          for(unsigned j=0; j<dimension; ++j) vv[j]->set(xx[j]);
-          newval = kernel->evaluate( vv, der, true );
-        } else {
-          // Evalulate dot product
-          double dot=0; for(unsigned j=0; j<dimension; ++j) { dot+=xx[j]*point[j]; der[j]=xx[j]; }
-          // Von misses distribution for concentration parameter
-          newval = von_misses_norm*exp( von_misses_concentration*dot );
-          // And final derivatives
-          for(unsigned j=0; j<dimension; ++j) der[j] *= von_misses_concentration*newval;
-        }
+        // Evalulate dot product
+        double dot=0; for(unsigned j=0; j<dimension; ++j) { dot+=xx[j]*point[j]; der[j]=xx[j]; }
+        // Von misses distribution for concentration parameter
+        newval = von_misses_norm*exp( von_misses_concentration*dot );
+        // And final derivatives
+        for(unsigned j=0; j<dimension; ++j) der[j] *= von_misses_concentration*newval;
         accumulate( ineigh, weight, newval, der, buffer );
         if( wasForced() ) {
           accumulateForce( ineigh, weight, der, intforce );
           totwforce += myvals.get( 1+dimension )*newval*forces[ineigh];
         }
       }
-      if( wasForced() ) {
-        // Minus sign for kernel here as we are taking derivative with respect to position of center of
-        // kernel NOT derivative wrt to grid point
-        double pref = 1; if( kernel ) pref = -1;
-        unsigned nder = getAction()->getNumberOfDerivatives();
-        unsigned gridbuf = getNumberOfBufferPoints()*getNumberOfQuantities();
-        for(unsigned j=0; j<dimension; ++j) {
-          for(unsigned k=0; k<myvals.getNumberActive(); ++k) {
-            unsigned kder=myvals.getActiveIndex(k);
-            buffer[ bufstart + gridbuf + kder ] += pref*intforce[j]*myvals.getDerivative( j+1, kder );
-          }
-        }
-        // Accumulate the sum of all the weights
-        buffer[ bufstart + gridbuf + nder ] += myvals.get(0);
-        // Add the derivatives of the weights into the force -- this is separate loop as weights of all parts are considered together
-        for(unsigned k=0; k<myvals.getNumberActive(); ++k) {
-          unsigned kder=myvals.getActiveIndex(k);
-          buffer[ bufstart + gridbuf + kder ] += totwforce*myvals.getDerivative( 0, kder );
-          buffer[ bufstart + gridbuf + nder + 1 + kder ] += myvals.getDerivative( 0, kder );
-        }
+      if( wasForced() ) accumulateKernelDerivatives( myvals, 1, intforce, totwforce, buffer );
+    }
+  }
+}
+
+void HistogramOnGrid::accumulateFlatKernel( const std::vector<double>& point, const double& weight, const double& wforce,
+    std::vector<double>& buffer, std::vector<double>& intforce, double& totwforce ) const {
+  // The kernel is evaluated from the distance from its center in the metric of the kernel, which is a
+  // sum over the axes.  The distances and the indices of the grid points are thus tabulated for each
+  // axis first, rather than computed again for each of the points of the grid in the support
+  std::vector<unsigned> offset( dimension+1, 0 );
+  for(unsigned j=0; j<dimension; ++j) offset[j+1] = offset[j] + 2*nneigh[j] + 1;
+  std::vector<int> tindex( offset[dimension] );
+  std::vector<double> u( offset[dimension] ), uw( offset[dimension] );
+  for(unsigned j=0; j<dimension; ++j) {
+    int base = std::floor( (point[j]-min[j])/dx[j] );
+    for(unsigned s=0; s<2*nneigh[j]+1; ++s) {
+      int i0 = static_cast<int>(s) - static_cast<int>(nneigh[j]) + base;
+      if( pbc[j] && i0<0 ) i0=nbin[j]-(-i0)%nbin[j];
+      if( pbc[j] && i0>=static_cast<int>(nbin[j]) ) i0%=nbin[j];
+      if( !pbc[j] && (i0<0 || i0>=static_cast<int>(nbin[j])) ) { tindex[offset[j]+s]=-1; continue; }
+      tindex[offset[j]+s]=i0;
+      double xx = min[j] + dx[j]*i0;
+      u[offset[j]+s] = -axis_values[j]->difference( xx, point[j] ) / bandwidths[j];
+      uw[offset[j]+s] = u[offset[j]+s] / bandwidths[j];
+    }
+  }
+
+  // Loop over the points in the support, the first axis runs fastest as in getNeighbors
+  std::vector<unsigned> s_indices( dimension, 0 ); std::vector<double> der( dimension );
+  for(unsigned index=0; index<neigh_tot; ++index) {
+    if( index>0 ) {
+      for(unsigned j=0; j<dimension; ++j) {
+        if( ++s_indices[j]<2*nneigh[j]+1 ) break;
+        s_indices[j]=0;
       }
-      for(unsigned i=0; i<dimension; ++i) delete vv[i];
     }
+    bool found=true; unsigned ineigh=0;
+    for(unsigned j=0; j<dimension; ++j) {
+      int t=tindex[offset[j]+s_indices[j]];
+      if( t<0 ) { found=false; break; }
+      ineigh += t*stride[j];
+    }
+    if( !found || inactive( ineigh ) ) continue;
+    double r2=0;
+    for(unsigned j=0; j<dimension; ++j) r2 += u[offset[j]+s_indices[j]]*u[offset[j]+s_indices[j]];
+    double kderiv, newval = kernel_shape->evaluateRadial( r2, kderiv );
+    for(unsigned j=0; j<dimension; ++j) der[j] = uw[offset[j]+s_indices[j]]*kderiv;
+    accumulate( ineigh, weight, newval, der, buffer );
+    if( wasForced() ) {
+      accumulateForce( ineigh, weight, der, intforce );
+      totwforce += wforce*newval*forces[ineigh];
+    }
+  }
+}
+
+void HistogramOnGrid::accumulateKernelDerivatives( MultiValue& myvals, const double& pref, const std::vector<double>& intforce,
+    const double& totwforce, std::vector<double>& buffer ) const {
+  unsigned nder = getAction()->getNumberOfDerivatives();
+  unsigned gridbuf = getNumberOfBufferPoints()*getNumberOfQuantities();
+  // Accumulate the sum of all the weights
+  buffer[ bufstart + gridbuf + nder ] += myvals.get(0);
+  // The derivatives with respect to the position of the kernel and those of the weights
+  // are added in a single pass over the active derivatives
+  double* fbuf = buffer.data() + bufstart + gridbuf;
+  for(unsigned k=0; k<myvals.getNumberActive(); ++k) {
+    unsigned kder=myvals.getActiveIndex(k);
+    double& f( fbuf[kder] );
+    for(unsigned j=0; j<dimension; ++j) f += pref*intforce[j]*myvals.getDerivative( j+1, kder );
+    f += totwforce*myvals.getDerivative( 0, kder );
+    fbuf[ nder + 1 + kder ] += myvals.getDerivative( 0, kder );
   }
 }
 
@@ -28,6 +28,7 @@
 namespace PLMD {
 
 class KernelFunctions;
+class Value;
 
 namespace gridtools {
 
@@ -38,6 +39,16 @@ private:
   std::string kerneltype;
   std::vector<double> bandwidths;
   std::vector<unsigned> nneigh;
+/// The kernel centered in the origin, with the normalized height, that is deposited on flat grids
+  std::unique_ptr<KernelFunctions> kernel_shape;
+/// Used to compute the distances between the grid points and the centers of the kernels
+  std::vector<std::unique_ptr<Value> > axis_values;
+/// Deposit a kernel on a flat grid, tabulating the distances from the center along each axis
+  void accumulateFlatKernel( const std::vector<double>& point, const double& weight, const double& wforce,
+                             std::vector<double>& buffer, std::vector<double>& intforce, double& totwforce ) const ;
+/// Add the derivatives with respect to the position and the weight of the kernel to the buffer
+  void accumulateKernelDerivatives( MultiValue& myvals, const double& pref, const std::vector<double>& intforce,
+                                    const double& totwforce, std::vector<double>& buffer ) const ;
 protected:
   bool discrete;
 public:
@@ -45,6 +56,7 @@ public:
   double von_misses_concentration;
   static void registerKeywords( Keywords& keys );
   explicit HistogramOnGrid( const vesselbase::VesselOptions& da );
+  ~HistogramOnGrid();
   void setBounds( const std::vector<std::string>& smin, const std::vector<std::string>& smax,
                   const std::vector<unsigned>& nbins, const std::vector<double>& spacing );
   void calculate( const unsigned& current, MultiValue& myvals, std::vector<double>& buffer, std::vector<unsigned>& der_list ) const ;
@@ -1122,11 +1122,13 @@ double MetainferenceBase::getEnergyForceMIGEN(const vector<double> &mean, const
     }
   }
   if(master&&nrep_>1) {
-    multi_sim_comm.Sum(&dev[0],dev.size());
-    multi_sim_comm.Sum(&dev2[0],dev2.size());
+    multi_sim_comm.DeferSum(&dev[0],dev.size());
+    multi_sim_comm.DeferSum(&dev2[0],dev2.size());
+    multi_sim_comm.SumDeferred();
   }
-  comm.Sum(&dev[0],dev.size());
-  comm.Sum(&dev2[0],dev2.size());
+  comm.DeferSum(&dev[0],dev.size());
+  comm.DeferSum(&dev2[0],dev2.size());
+  comm.SumDeferred();
 
   double dene_b = 0.;
   double ene    = 0.;
@@ -134,6 +134,7 @@ NOE::NOE(const ActionOptions&ao):
   if(nga.size()!=ngb.size()) error("There should be the same number of GROUPA and GROUPB keywords");
   // Create neighbour lists
   nl.reset( new NeighborList(ga_lista,gb_lista,true,pbc,getPbc()) );
+  addMemoryUsage("neighbor list",[this]() { return nl->getMemoryUsage(); });
 
   bool addexp=false;
   parseFlag("ADDEXP",addexp);
@@ -187,6 +187,7 @@ PRE::PRE(const ActionOptions&ao):
 
   // Create neighbour lists
   nl.reset( new NeighborList(gb_lista,ga_lista,true,pbc,getPbc()) );
+  addMemoryUsage("neighbor list",[this]() { return nl->getMemoryUsage(); });
 
   // Ouput details of all contacts
   unsigned index=0;
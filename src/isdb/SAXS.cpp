@@ -29,6 +29,7 @@
 #include "core/ActionSet.h"
 #include "core/PlumedMain.h"
 #include "core/SetupMolInfo.h"
+#include "tools/Arena.h"
 #include "tools/Communicator.h"
 #include "tools/OpenMP.h"
 #include "tools/Pbc.h"
@@ -301,8 +302,10 @@ void SAXS::calculate() {
     rank   = 0;
   }
 
-  vector<Vector> deriv(numq*size);
-  vector<double> sum(numq,0);
+  Arena& arena(plumed.getArena());
+  ArenaScope scope(arena);
+  ArenaVector<Vector> deriv(numq*size,Vector(),ArenaAllocator<Vector>(arena));
+  ArenaVector<double> sum(numq,0,ArenaAllocator<double>(arena));
 
   #pragma omp parallel for num_threads(OpenMP::getNumThreads())
   for (unsigned k=0; k<numq; k++) {
@@ -32,6 +32,8 @@ void ManyRestraintsBase::registerKeywords( Keywords& keys ) {
   ActionWithInputVessel::registerKeywords( keys );
   ActionPilot::registerKeywords( keys );
   keys.add("hidden","STRIDE","the frequency with which the forces due to the bias should be calculated.  This can be used to correctly set up multistep algorithms");
+  keys.add("optional","MTS_STRIDE","apply the forces only every this number of steps, scaled by the same number, as in a multiple time step (impulse) integrator. "
+           "The arguments are then only computed on these steps, unless they are needed by other actions");
   keys.remove("TOL");
   keys.addOutputComponent("bias","default","the instantaneous value of the bias potentials");
 }
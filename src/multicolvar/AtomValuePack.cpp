@@ -21,6 +21,7 @@
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 #include "AtomValuePack.h"
 #include "CatomPack.h"
+#include "SharedNeighborList.h"
 #include "tools/LinkCells.h"
 
 namespace PLMD {
@@ -54,6 +55,14 @@ unsigned AtomValuePack::setupAtomsFromLinkCells( const std::vector<unsigned>& ci
   return natoms;
 }
 
+unsigned AtomValuePack::setupAtomsFromSharedNeighborList( const unsigned& cind, const SharedNeighborList& mynl ) {
+  unsigned nn=mynl.getNumberOfNeighbors( cind ); plumed_dbg_assert( nn<indices.size() );
+  const unsigned* nlist=mynl.getNeighbors( cind ); const Vector* nseps=mynl.getSeparations( cind );
+  natoms=1+nn; indices[0]=cind; myatoms[0].zero();
+  for(unsigned i=0; i<nn; ++i) { indices[1+i]=nlist[i]; myatoms[1+i]=nseps[i]; }
+  return natoms;
+}
+
 void AtomValuePack::updateUsingIndices() {
   if( myvals.updateComplete() ) return;
 
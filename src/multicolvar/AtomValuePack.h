@@ -32,6 +32,7 @@ class LinkCells;
 namespace multicolvar {
 
 class CatomPack;
+class SharedNeighborList;
 
 class AtomValuePack {
   friend class MultiColvarBase;
@@ -67,6 +68,8 @@ public:
   void setAtom( const unsigned& j, const unsigned& ind );
 ///
   unsigned setupAtomsFromLinkCells( const std::vector<unsigned>& cind, const Vector& cpos, const LinkCells& linkcells );
+/// Setup the atoms using a neighbor list that was built for the central atom
+  unsigned setupAtomsFromSharedNeighborList( const unsigned& cind, const SharedNeighborList& mynl );
 ///
   unsigned getIndex( const unsigned& j ) const ;
 ///
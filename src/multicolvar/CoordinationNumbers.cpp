@@ -26,6 +26,7 @@
 #include "tools/SwitchingFunction.h"
 
 #include <string>
+#include <vector>
 #include <cmath>
 
 using namespace std;
@@ -98,7 +99,7 @@ PLUMED_REGISTER_ACTION(CoordinationNumbers,"COORDINATIONNUMBER")
 
 void CoordinationNumbers::registerKeywords( Keywords& keys ) {
   MultiColvarBase::registerKeywords( keys );
-  keys.use("SPECIES"); keys.use("SPECIESA"); keys.use("SPECIESB");
+  keys.use("SPECIES"); keys.use("SPECIESA"); keys.use("SPECIESB"); keys.use("NL_SKIN");
   keys.add("compulsory","NN","6","The n parameter of the switching function ");
   keys.add("compulsory","MM","0","The m parameter of the switching function; 0 implies 2*NN");
   keys.add("compulsory","D_0","0.0","The d_0 parameter of the switching function");
@@ -156,25 +157,34 @@ CoordinationNumbers::CoordinationNumbers(const ActionOptions&ao):
 }
 
 double CoordinationNumbers::compute( const unsigned& tindex, AtomValuePack& myatoms ) const {
-  // Calculate the coordination number
-  double dfunc, d2, sw, d, raised;
-  for(unsigned i=1; i<myatoms.getNumberOfAtoms(); ++i) {
+  // Find the atoms that are within the cutoff
+  unsigned nat=myatoms.getNumberOfAtoms(), nn=0;
+  // Scratch arrays owned by the MultiValue of the thread, so that they are not allocated for every task
+  MultiValue& myvals=myatoms.getUnderlyingMultiValue();
+  unsigned* nind=myvals.getWorkIndices( nat );
+  double* d2=myvals.getWorkVector( 3*nat ); double* sw=d2+nat; double* dfunc=sw+nat;
+  for(unsigned i=1; i<nat; ++i) {
     Vector& distance=myatoms.getPosition(i);
-    if ( (d2=distance[0]*distance[0])<rcut2 &&
-         (d2+=distance[1]*distance[1])<rcut2 &&
-         (d2+=distance[2]*distance[2])<rcut2 &&
-         d2>epsilon ) {
-
-      sw = switchingFunction.calculateSqr( d2, dfunc );
-      if(r_power > 0) {
-        d = sqrt(d2); raised = pow( d, r_power - 1 );
-        accumulateSymmetryFunction( 1, i, sw * raised * d,
-                                    (dfunc * d * raised + sw * r_power) * distance,
-                                    (-dfunc * d * raised - sw * r_power) * Tensor(distance, distance),
-                                    myatoms );
-      } else {
-        accumulateSymmetryFunction( 1, i, sw, (dfunc)*distance, (-dfunc)*Tensor(distance,distance), myatoms );
-      }
+    if ( (d2[nn]=distance[0]*distance[0])<rcut2 &&
+         (d2[nn]+=distance[1]*distance[1])<rcut2 &&
+         (d2[nn]+=distance[2]*distance[2])<rcut2 &&
+         d2[nn]>epsilon ) { nind[nn]=i; nn++; }
+  }
+  // Compute the switching functions for all the neighbors at once
+  switchingFunction.calculateSqr( d2, nn, sw, dfunc );
+
+  // Calculate the coordination number
+  double d, raised;
+  for(unsigned k=0; k<nn; ++k) {
+    unsigned i=nind[k]; Vector& distance=myatoms.getPosition(i);
+    if(r_power > 0) {
+      d = sqrt(d2[k]); raised = pow( d, r_power - 1 );
+      accumulateSymmetryFunction( 1, i, sw[k] * raised * d,
+                                  (dfunc[k] * d * raised + sw[k] * r_power) * distance,
+                                  (-dfunc[k] * d * raised - sw[k] * r_power) * Tensor(distance, distance),
+                                  myatoms );
+    } else {
+      accumulateSymmetryFunction( 1, i, sw[k], (dfunc[k])*distance, (-dfunc[k])*Tensor(distance,distance), myatoms );
     }
   }
 
@@ -22,6 +22,7 @@
 #include "MultiColvarBase.h"
 #include "ActionVolume.h"
 #include "MultiColvarFilter.h"
+#include "SharedNeighborList.h"
 #include "vesselbase/Vessel.h"
 #include "vesselbase/BridgeVessel.h"
 #include "core/PlumedMain.h"
@@ -31,6 +32,7 @@
 #include <vector>
 #include <string>
 #include <limits>
+#include <cmath>
 
 using namespace std;
 
@@ -70,6 +72,9 @@ void MultiColvarBase::registerKeywords( Keywords& keys ) {
                "using the label of another multicolvar");
   keys.reserve("atoms-4","SPECIESB","this keyword is used for colvars such as the coordination number.  It must appear with SPECIESA.  For a full explanation see "
                "the documentation for that keyword");
+  keys.reserve("optional","NL_SKIN","the skin to add to the cutoff when building the neighbor list.  The list of neighbors is then only rebuilt "
+               "when one of the atoms has moved by more than half the skin since the last time the list was built. "
+               "This is useful for solids where the neighbors of each atom rarely change");
   keys.add("hidden","ALL_INPUT_SAME_TYPE","remove this keyword to remove certain checks in the input on the sanity of your input file.  See code for details");
 }
 
@@ -83,6 +88,8 @@ MultiColvarBase::MultiColvarBase(const ActionOptions&ao):
   uselinkforthree(false),
   linkcells(comm),
   threecells(comm),
+  nl_skin(0.0),
+  nl_rebuild(true),
   setup_completed(false),
   atomsWereRetrieved(false),
   matsums(false),
@@ -94,6 +101,11 @@ MultiColvarBase::MultiColvarBase(const ActionOptions&ao):
     usepbc=!nopbc;
   }
   if( keywords.exists("SPECIESA") ) { matsums=usespecies=true; }
+  if( keywords.exists("NL_SKIN") ) {
+    parse("NL_SKIN",nl_skin);
+    if( nl_skin<0 ) error("NL_SKIN should be positive");
+    if( nl_skin>0 ) log.printf("  neighbor list is rebuilt only when atoms have moved more than half of skin %f \n",nl_skin);
+  }
 }
 
 void MultiColvarBase::readAtomsLikeKeyword( const std::string & key, const int& natoms, std::vector<AtomNumber>& all_atoms ) {
@@ -476,6 +488,80 @@ void MultiColvarBase::setupMultiColvarBase( const std::vector<AtomNumber>& atoms
 
   // Setup underlying ActionWithVessel
   readVesselKeywords();
+  // Share the neighbor list with other multicolvars if we can
+  if( canShareNeighborList() ) setupSharedNeighborList();
+  // Check that the neighbor list can be reused
+  if( nl_skin>0 ) {
+    if( usespecies && !sharednl ) error("NL_SKIN can only be used if the atoms are specified directly using SPECIES or SPECIESA and SPECIESB");
+    if( uselinkforthree && !allthirdblockintasks ) error("NL_SKIN cannot be used with this input");
+    if( filtersUsedAsInput() ) error("NL_SKIN cannot be used if filters are used in the input");
+  }
+}
+
+bool MultiColvarBase::canShareNeighborList() const {
+  // Neighbor lists can only be shared if the atoms are read in directly using SPECIES.
+  // They cannot be shared if atoms are moved for numerical derivatives
+  return usespecies && mybasemulticolvars.size()==0 && linkcells.enabled() && !isDensity() && !checkNumericalDerivatives();
+}
+
+bool MultiColvarBase::hasSameNeighborsAs( const MultiColvarBase* mycolv ) const {
+  if( !mycolv->canShareNeighborList() ) return false;
+  if( usepbc!=mycolv->usepbc || serialCalculation()!=mycolv->serialCalculation() ) return false;
+  if( nl_skin!=mycolv->nl_skin ) return false;
+  if( getFullNumberOfTasks()!=mycolv->getFullNumberOfTasks() ) return false;
+  if( ablocks[0]!=mycolv->ablocks[0] ) return false;
+  return getAbsoluteIndexes()==mycolv->getAbsoluteIndexes();
+}
+
+void MultiColvarBase::setupSharedNeighborList() {
+  std::vector<MultiColvarBase*> all=plumed.getActionSet().select<MultiColvarBase*>();
+  for(unsigned i=0; i<all.size(); ++i) {
+    if( all[i]==this || !all[i]->sharednl || !hasSameNeighborsAs( all[i] ) ) continue;
+    log.printf("  sharing neighbor list with multicolvar labelled %s\n", all[i]->getLabel().c_str() );
+    sharednl=all[i]->sharednl; break;
+  }
+  if( !sharednl ) sharednl=std::make_shared<SharedNeighborList>( comm, serialCalculation(), nl_skin );
+  sharednl->addUser( getLinkCellCutoff() );
+}
+
+bool MultiColvarBase::usingSharedNeighborList() const {
+  // There is no point in storing the list if only one action is using it and it is rebuilt on every step
+  return sharednl && ( sharednl->getNumberOfUsers()>1 || sharednl->getSkin()>0 );
+}
+
+bool MultiColvarBase::skinExceeded( const std::vector<Vector>& refpos, const Tensor& refbox, const std::vector<Vector>& pos, const double& cutoff ) const {
+  if( refpos.size()!=pos.size() ) return true;
+  // When the box changes the separation d between two atoms changes by matmul(d,strain) with
+  // strain=matmul(inverse(refbox),box-refbox).  As the norm of d is less than the cutoff the norm
+  // of the strain times the cutoff bounds this change for all the pairs in the list
+  bool boxchanged=false; double strain=0; Tensor scale;
+  if( usepbc ) {
+    const Tensor& box=getPbc().getBox(); Tensor dbox=box-refbox;
+    for(unsigned i=0; i<3; ++i) {
+      for(unsigned j=0; j<3; ++j) if( dbox(i,j)!=0 ) boxchanged=true;
+    }
+    if( boxchanged ) {
+      if( refbox.determinant()==0 ) return true;
+      Tensor invref=inverse( refbox ), mstrain=matmul( invref, dbox );
+      for(unsigned i=0; i<3; ++i) {
+        for(unsigned j=0; j<3; ++j) strain+=mstrain(i,j)*mstrain(i,j);
+      }
+      strain=std::sqrt( strain ); scale=matmul( invref, box );
+    }
+  }
+  // Pairs of atoms can only come within the cutoff if the strain plus the displacements of the two
+  // atoms use up the skin.  The displacements are measured from the reference positions scaled with the box
+  double maxdisp=0.5*( nl_skin - strain*cutoff );
+  if( maxdisp<=0 ) return true;
+  double maxdisp2=maxdisp*maxdisp;
+  for(unsigned i=0; i<pos.size(); ++i) {
+    Vector ref=refpos[i], disp;
+    if( boxchanged ) ref=matmul( refpos[i], scale );
+    if( usepbc ) disp=getPbc().distance( ref, pos[i] );
+    else disp=delta( ref, pos[i] );
+    if( disp.modulo2()>maxdisp2 ) return true;
+  }
+  return false;
 }
 
 void MultiColvarBase::setAtomsForCentralAtom( const std::vector<bool>& catom_ind ) {
@@ -499,16 +585,16 @@ void MultiColvarBase::setLinkCellCutoff( const double& lcut, double tcut ) {
   if( tcut<0 ) tcut=lcut;
 
   if( !linkcells.enabled() ) {
-    linkcells.setCutoff( lcut );
-    threecells.setCutoff( tcut );
+    linkcells.setCutoff( lcut+nl_skin );
+    threecells.setCutoff( tcut+nl_skin );
   } else {
-    if( lcut>linkcells.getCutoff() ) linkcells.setCutoff( lcut );
-    if( tcut>threecells.getCutoff() ) threecells.setCutoff( tcut );
+    if( lcut+nl_skin>linkcells.getCutoff() ) linkcells.setCutoff( lcut+nl_skin );
+    if( tcut+nl_skin>threecells.getCutoff() ) threecells.setCutoff( tcut+nl_skin );
   }
 }
 
 double MultiColvarBase::getLinkCellCutoff()  const {
-  return linkcells.getCutoff();
+  return linkcells.getCutoff() - nl_skin;
 }
 
 void MultiColvarBase::setupLinkCells() {
@@ -519,6 +605,34 @@ void MultiColvarBase::setupLinkCells() {
   }
   retrieveAtoms();
 
+  // The shared neighbor list only needs to be built by the first action that uses it on each step
+  if( usingSharedNeighborList() ) {
+    // The lists are needed for the central atoms of the tasks that this process does in runAllTasks
+    std::vector<unsigned> rows; getTasksDoneByThisProcess( rows );
+    if( sharednl->isBuilt() && sharednl->isBuiltForAll( rows ) ) return;
+    std::vector<Vector> ltmp_pos( ablocks[0].size() );
+    for(unsigned i=0; i<ablocks[0].size(); ++i) ltmp_pos[i]=getPositionOfAtomForLinkCells( ablocks[0][i] );
+    // If the atoms have not moved too far we only need to update the separations.  The link cells are
+    // updated too as they are used to find the neighbors of the central atoms that are not in the list
+    if( !sharednl->isBuilt() && sharednl->getSkin()>0 && sharednl->isBuiltForAll( rows ) &&
+        !skinExceeded( sharednl->getReferencePositions(), sharednl->getReferenceBox(), getPositions(), sharednl->getCutoff() ) ) {
+      sharednl->updateCells( ltmp_pos, ablocks[0], getPbc() );
+      sharednl->updateSeparations( getPositions(), getPbc(), usepbc ); return;
+    }
+    sharednl->build( ltmp_pos, ablocks[0], getFullNumberOfTasks(), getPositions(), getPbc(), usepbc, rows );
+    return;
+  }
+
+  // Check if the tasks that were found when the neighbor list was last rebuilt can be reused
+  if( !usespecies && nl_skin>0 ) {
+    std::vector<Vector> pos( ablocks[0].size() + ablocks[1].size() );
+    for(unsigned i=0; i<ablocks[0].size(); ++i) pos[i]=getPositionOfAtomForLinkCells( ablocks[0][i] );
+    for(unsigned i=0; i<ablocks[1].size(); ++i) pos[ablocks[0].size()+i]=getPositionOfAtomForLinkCells( ablocks[1][i] );
+    nl_rebuild=skinExceeded( nl_refpos, nl_refbox, pos, linkcells.getCutoff() );
+    if( !nl_rebuild ) return;
+    nl_refpos=pos; nl_refbox=getPbc().getBox();
+  }
+
   unsigned iblock;
   if( usespecies ) {
     iblock=0;
@@ -528,10 +642,12 @@ void MultiColvarBase::setupLinkCells() {
     plumed_error();
   }
 
-  // Count number of currently active atoms
+  // Count number of currently active atoms.  When the tasks are stored all the atoms are put in the
+  // link cells as atoms that are not active now may become active before the tasks are found again
+  bool allatoms=( !usespecies && nl_skin>0 );
   nactive_atoms=0;
   for(unsigned i=0; i<ablocks[iblock].size(); ++i) {
-    if( isCurrentlyActive( ablocks[iblock][i] ) ) nactive_atoms++;
+    if( allatoms || isCurrentlyActive( ablocks[iblock][i] ) ) nactive_atoms++;
   }
 
   if( nactive_atoms>0 ) {
@@ -548,7 +664,7 @@ void MultiColvarBase::setupLinkCells() {
       }
     } else {
       for(unsigned i=0; i<ablocks[1].size(); ++i) {
-        if( !isCurrentlyActive( ablocks[1][i] ) ) continue;
+        if( !allatoms && !isCurrentlyActive( ablocks[1][i] ) ) continue;
         ltmp_ind[nactive_atoms]=i;
         ltmp_pos[nactive_atoms]=getPositionOfAtomForLinkCells( ablocks[1][i] );
         nactive_atoms++;
@@ -566,6 +682,12 @@ void MultiColvarBase::setupNonUseSpeciesLinkCells( const unsigned& my_always_act
   deactivateAllTasks();
   std::vector<unsigned> requiredlinkcells;
 
+  // Reuse the tasks that were found when the neighbor list was last rebuilt
+  if( nl_skin>0 && !nl_rebuild ) {
+    if( allthirdblockintasks && nactive_atoms>0 ) { std::vector<unsigned> lttmp_ind; setupThreeCells( lttmp_ind ); }
+    activateNeighborListTasks(); return;
+  }
+
   if( !uselinkforthree && nactive_atoms>0 ) {
     // Get some parallel info
     unsigned stride=comm.Get_size();
@@ -575,7 +697,8 @@ void MultiColvarBase::setupNonUseSpeciesLinkCells( const unsigned& my_always_act
     // Ensure we only do tasks where atoms are in appropriate link cells
     std::vector<unsigned> linked_atoms( 1+ablocks[1].size() );
     for(unsigned i=rank; i<ablocks[0].size(); i+=stride) {
-      if( !isCurrentlyActive( ablocks[0][i] ) ) continue;
+      // When the list is reused inactive atoms are removed in activateNeighborListTasks
+      if( nl_skin==0 && !isCurrentlyActive( ablocks[0][i] ) ) continue;
       unsigned natomsper=1; linked_atoms[0]=my_always_active;  // Note we always check atom 0 because it is simpler than changing LinkCells.cpp
       linkcells.retrieveNeighboringAtoms( getPositionOfAtomForLinkCells( ablocks[0][i] ), requiredlinkcells, natomsper, linked_atoms );
       for(unsigned j=0; j<natomsper; ++j) {
@@ -588,38 +711,14 @@ void MultiColvarBase::setupNonUseSpeciesLinkCells( const unsigned& my_always_act
     unsigned rank=comm.Get_rank();
     if( serialCalculation() ) { stride=1; rank=0; }
 
-    unsigned nactive_three=0;
-    for(unsigned i=0; i<ablocks[2].size(); ++i) {
-      if( isCurrentlyActive( ablocks[2][i] ) ) nactive_three++;
-    }
-
-    std::vector<Vector> lttmp_pos( nactive_three );
-    std::vector<unsigned> lttmp_ind( nactive_three );
-
-    nactive_three=0;
-    if( allthirdblockintasks ) {
-      for(unsigned i=0; i<ablocks[2].size(); ++i) {
-        if( !isCurrentlyActive( ablocks[2][i] ) ) continue;
-        lttmp_ind[nactive_three]=ablocks[2][i];
-        lttmp_pos[nactive_three]=getPositionOfAtomForLinkCells( ablocks[2][i] );
-        nactive_three++;
-      }
-    } else {
-      for(unsigned i=0; i<ablocks[2].size(); ++i) {
-        if( !isCurrentlyActive( ablocks[2][i] ) ) continue;
-        lttmp_ind[nactive_three]=i;
-        lttmp_pos[nactive_three]=getPositionOfAtomForLinkCells( ablocks[2][i] );
-        nactive_three++;
-      }
-    }
     // Build the list of the link cells
-    threecells.buildCellLists( lttmp_pos, lttmp_ind, getPbc() );
+    std::vector<unsigned> lttmp_ind; setupThreeCells( lttmp_ind );
 
     // Ensure we only do tasks where atoms are in appropriate link cells
     std::vector<unsigned> linked_atoms( 1+ablocks[1].size() );
     std::vector<unsigned> tlinked_atoms( 1+ablocks[2].size() );
     for(unsigned i=rank; i<ablocks[0].size(); i+=stride) {
-      if( !isCurrentlyActive( ablocks[0][i] ) ) continue;
+      if( nl_skin==0 && !isCurrentlyActive( ablocks[0][i] ) ) continue;
       unsigned natomsper=1; linked_atoms[0]=my_always_active;  // Note we always check atom 0 because it is simpler than changing LinkCells.cpp
       linkcells.retrieveNeighboringAtoms( getPositionOfAtomForLinkCells( ablocks[0][i] ), requiredlinkcells, natomsper, linked_atoms );
       if( allthirdblockintasks ) {
@@ -636,6 +735,56 @@ void MultiColvarBase::setupNonUseSpeciesLinkCells( const unsigned& my_always_act
     }
   }
   if( !serialCalculation() ) comm.Sum( taskFlags );
+  if( nl_skin>0 ) {
+    // Store the tasks so that they can be reused until the skin is exceeded
+    nl_tasks.resize(0);
+    for(unsigned i=0; i<taskFlags.size(); ++i) {
+      if( taskFlags[i]>0 ) nl_tasks.push_back(i);
+    }
+    deactivateAllTasks(); activateNeighborListTasks(); return;
+  }
+  lockContributors();
+}
+
+void MultiColvarBase::setupThreeCells( std::vector<unsigned>& lttmp_ind ) {
+  unsigned nactive_three=0;
+  for(unsigned i=0; i<ablocks[2].size(); ++i) {
+    if( isCurrentlyActive( ablocks[2][i] ) ) nactive_three++;
+  }
+
+  std::vector<Vector> lttmp_pos( nactive_three );
+  lttmp_ind.resize( nactive_three );
+
+  nactive_three=0;
+  if( allthirdblockintasks ) {
+    for(unsigned i=0; i<ablocks[2].size(); ++i) {
+      if( !isCurrentlyActive( ablocks[2][i] ) ) continue;
+      lttmp_ind[nactive_three]=ablocks[2][i];
+      lttmp_pos[nactive_three]=getPositionOfAtomForLinkCells( ablocks[2][i] );
+      nactive_three++;
+    }
+  } else {
+    for(unsigned i=0; i<ablocks[2].size(); ++i) {
+      if( !isCurrentlyActive( ablocks[2][i] ) ) continue;
+      lttmp_ind[nactive_three]=i;
+      lttmp_pos[nactive_three]=getPositionOfAtomForLinkCells( ablocks[2][i] );
+      nactive_three++;
+    }
+  }
+  threecells.buildCellLists( lttmp_pos, lttmp_ind, getPbc() );
+}
+
+void MultiColvarBase::activateNeighborListTasks() {
+  // Only do the tasks for which all the atoms are currently active
+  std::vector<unsigned> atoms( decoder.size() );
+  for(unsigned i=0; i<nl_tasks.size(); ++i) {
+    decodeIndexToAtoms( getTaskCode(nl_tasks[i]), atoms );
+    bool allactive=true;
+    for(unsigned j=0; j<atoms.size(); ++j) {
+      if( !isCurrentlyActive( atoms[j] ) ) { allactive=false; break; }
+    }
+    if( allactive ) taskFlags[nl_tasks[i]]=1;
+  }
   lockContributors();
 }
 
@@ -654,6 +803,14 @@ void MultiColvarBase::decodeIndexToAtoms( const unsigned& taskCode, std::vector<
 bool MultiColvarBase::setupCurrentAtomList( const unsigned& taskCode, AtomValuePack& myatoms ) const {
   if( isDensity() ) {
     myatoms.setNumberOfAtoms( 1 ); myatoms.setAtom( 0, taskCode ); return true;
+  } else if( usespecies && usingSharedNeighborList() ) {
+    if( sharednl->isBuiltFor( taskCode ) ) {
+      myatoms.setupAtomsFromSharedNeighborList( taskCode, *sharednl );
+      return sharednl->hasAtomsInCells( taskCode );
+    }
+    std::vector<unsigned> task_atoms(1); task_atoms[0]=taskCode;
+    unsigned natomsper=myatoms.setupAtomsFromLinkCells( task_atoms, getPositionOfAtomForLinkCells( taskCode ), sharednl->getLinkCells() );
+    return natomsper>1;
   } else if( usespecies ) {
     std::vector<unsigned> task_atoms(1); task_atoms[0]=taskCode;
     unsigned natomsper=myatoms.setupAtomsFromLinkCells( task_atoms, getPositionOfAtomForLinkCells( taskCode ), linkcells );
@@ -786,6 +943,7 @@ void MultiColvarBase::calculateNumericalDerivatives( ActionWithValue* a ) {
 
 void MultiColvarBase::prepare() {
   setup_completed=false; atomsWereRetrieved=false;
+  if( sharednl ) sharednl->invalidate();
 }
 
 void MultiColvarBase::retrieveAtoms() {
@@ -29,6 +29,7 @@
 #include "vesselbase/StoreDataVessel.h"
 #include "vesselbase/ActionWithVessel.h"
 #include "CatomPack.h"
+#include <memory>
 #include <vector>
 
 namespace PLMD {
@@ -37,6 +38,7 @@ namespace multicolvar {
 class AtomValuePack;
 class BridgedMultiColvarFunction;
 class ActionVolume;
+class SharedNeighborList;
 
 class MultiColvarBase :
   public ActionAtomistic,
@@ -62,6 +64,18 @@ private:
   LinkCells linkcells;
 /// Link cells for third block of atoms
   LinkCells threecells;
+/// Neighbor list shared with other multicolvars that use the same species
+  std::shared_ptr<SharedNeighborList> sharednl;
+/// The skin that is added to the link cell cutoff so that neighbor lists can be reused
+  double nl_skin;
+/// Should the neighbor list be rebuilt on this step
+  bool nl_rebuild;
+/// The positions of the atoms in the link cells when the neighbor list was last rebuilt
+  std::vector<Vector> nl_refpos;
+/// The box when the neighbor list was last rebuilt
+  Tensor nl_refbox;
+/// The tasks that were found when the neighbor list was last rebuilt
+  std::vector<unsigned> nl_tasks;
 /// Number of atoms that are being used for central atom position
   unsigned ncentral;
 /// Bool vector telling us which atoms are required to calculate central atom position
@@ -74,6 +88,21 @@ private:
   bool setup_completed;
 /// Ensures that retrieving of atoms is only done once per calculation loop
   bool atomsWereRetrieved;
+/// Check if this multicolvar can share its neighbor list with other multicolvars
+  bool canShareNeighborList() const ;
+/// Check if this multicolvar would build the same neighbor list as another multicolvar
+  bool hasSameNeighborsAs( const MultiColvarBase* mycolv ) const ;
+/// Find a multicolvar with the same species and share the neighbor list with it
+  void setupSharedNeighborList();
+/// Are we using a neighbor list that is stored in a SharedNeighborList
+  bool usingSharedNeighborList() const ;
+/// Check if the changes in the box and the positions since the reference positions were stored
+/// could have brought pairs of atoms that were further apart than the cutoff within the cutoff minus the skin
+  bool skinExceeded( const std::vector<Vector>& refpos, const Tensor& refbox, const std::vector<Vector>& pos, const double& cutoff ) const ;
+/// Build the link cells for the third block of atoms
+  void setupThreeCells( std::vector<unsigned>& lttmp_ind );
+/// Activate the tasks that were found when the neighbor list was last rebuilt
+  void activateNeighborListTasks();
 /// Add derivatives of center of mass position
   void addComDerivatives( const int& ival, const unsigned& iatom, const Vector& der, multicolvar::AtomValuePack& myatoms ) const ;
 protected:
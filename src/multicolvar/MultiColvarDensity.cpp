@@ -110,7 +110,7 @@ public:
 PLUMED_REGISTER_ACTION(MultiColvarDensity,"MULTICOLVARDENS")
 
 void MultiColvarDensity::registerKeywords( Keywords& keys ) {
-  gridtools::ActionWithGrid::registerKeywords( keys );
+  gridtools::ActionWithGrid::registerKeywords( keys ); keys.use("WALKERS_MPI");
   keys.add("atoms","ORIGIN","we will use the position of this atom as the origin");
   keys.add("compulsory","DATA","the multicolvar which you would like to calculate the density profile for");
   keys.add("compulsory","DIR","the direction in which to calculate the density profile");
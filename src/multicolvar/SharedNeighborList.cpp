@@ -0,0 +1,132 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2018 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "SharedNeighborList.h"
+#include "tools/Communicator.h"
+#include "tools/OpenMP.h"
+#include "tools/Pbc.h"
+
+namespace PLMD {
+namespace multicolvar {
+
+SharedNeighborList::SharedNeighborList( Communicator& comm, const bool& ser, const double& sk ):
+  serial(ser),
+  skin(sk),
+  linkcells(comm),
+  built(false),
+  nusers(0)
+{
+}
+
+void SharedNeighborList::addUser( const double& lcut ) {
+  if( !linkcells.enabled() || lcut+skin>linkcells.getCutoff() ) linkcells.setCutoff( lcut+skin );
+  nusers++; built=false;
+}
+
+double SharedNeighborList::getCutoff() const {
+  return linkcells.getCutoff();
+}
+
+void SharedNeighborList::build( const std::vector<Vector>& npos, const std::vector<unsigned>& nind, const unsigned& ncentral,
+                                const std::vector<Vector>& allpos, const Pbc& pbc, const bool& usepbc, const std::vector<unsigned>& rows ) {
+  plumed_assert( linkcells.enabled() && npos.size()==nind.size() );
+  // Store the positions so we can check how far atoms have moved on later steps
+  if( skin>0 ) { refpos=allpos; refbox=pbc.getBox(); }
+  // Build the link cells
+  updateCells( npos, nind, pbc );
+
+  // Another action that uses the list may have needed lists for other central atoms earlier in this step
+  if( !built || nl_built.size()!=ncentral ) nl_built.assign( ncentral, 0 );
+  for(unsigned i=0; i<rows.size(); ++i) { plumed_dbg_assert( rows[i]<ncentral ); nl_built[rows[i]]=1; }
+  std::vector<unsigned> myrows;
+  for(unsigned i=0; i<ncentral; ++i) {
+    if( nl_built[i] ) myrows.push_back(i);
+  }
+  nl_start.assign( ncentral+1, 0 ); nl_hascells.assign( ncentral, 0 );
+  if( npos.size()==0 ) { nl_atoms.resize(0); nl_seps.resize(0); built=true; return; }
+
+  // Each thread stores the neighbors of the central atoms it does in a private buffer
+  // the buffers are then copied into the final list in order
+  double cut2=linkcells.getCutoff()*linkcells.getCutoff();
+  unsigned nt=OpenMP::getNumThreads();
+  if( nt*10>myrows.size() ) nt=myrows.size()/10;
+  if( nt==0 ) nt=1;
+
+  #pragma omp parallel num_threads(nt)
+  {
+    std::vector<unsigned> t_centers, t_atoms, cells_required, linked_atoms( 1+nind.size() );
+    std::vector<Vector> t_seps, tmp_seps( 1+nind.size() );
+
+    #pragma omp for schedule(static)
+    for(unsigned k=0; k<myrows.size(); ++k) {
+      unsigned i=myrows[k], natomsper=1; linked_atoms[0]=i;
+      linkcells.retrieveNeighboringAtoms( allpos[i], cells_required, natomsper, linked_atoms );
+      if( natomsper>1 ) nl_hascells[i]=1;
+      for(unsigned j=1; j<natomsper; ++j) tmp_seps[j]=allpos[linked_atoms[j]] - allpos[i];
+      if( usepbc ) pbc.apply( tmp_seps, natomsper );
+      // Only keep the atoms that are within the cutoff
+      unsigned nn=0;
+      for(unsigned j=1; j<natomsper; ++j) {
+        if( tmp_seps[j].modulo2()<=cut2 ) { t_atoms.push_back( linked_atoms[j] ); t_seps.push_back( tmp_seps[j] ); nn++; }
+      }
+      t_centers.push_back( i ); nl_start[i+1]=nn;
+    }
+    #pragma omp single
+    {
+      for(unsigned i=0; i<ncentral; ++i) nl_start[i+1]+=nl_start[i];
+      nl_atoms.resize( nl_start[ncentral] ); nl_seps.resize( nl_start[ncentral] );
+    }
+    unsigned k=0;
+    for(unsigned i=0; i<t_centers.size(); ++i) {
+      unsigned c=t_centers[i];
+      for(unsigned j=nl_start[c]; j<nl_start[c+1]; ++j) { nl_atoms[j]=t_atoms[k]; nl_seps[j]=t_seps[k]; k++; }
+    }
+  }
+  built=true;
+}
+
+void SharedNeighborList::updateCells( const std::vector<Vector>& npos, const std::vector<unsigned>& nind, const Pbc& pbc ) {
+  if( npos.size()>0 ) linkcells.buildCellLists( npos, nind, pbc );
+}
+
+bool SharedNeighborList::isBuiltForAll( const std::vector<unsigned>& rows ) const {
+  for(unsigned i=0; i<rows.size(); ++i) {
+    if( rows[i]>=nl_built.size() || !nl_built[rows[i]] ) return false;
+  }
+  return true;
+}
+
+void SharedNeighborList::updateSeparations( const std::vector<Vector>& allpos, const Pbc& pbc, const bool& usepbc ) {
+  unsigned ncentral=nl_built.size();
+  #pragma omp parallel for schedule(static)
+  for(unsigned i=0; i<ncentral; ++i) {
+    if( !nl_built[i] ) continue;
+    if( usepbc ) {
+      for(unsigned j=nl_start[i]; j<nl_start[i+1]; ++j) nl_seps[j]=pbc.distance( allpos[i], allpos[nl_atoms[j]] );
+    } else {
+      for(unsigned j=nl_start[i]; j<nl_start[i+1]; ++j) nl_seps[j]=delta( allpos[i], allpos[nl_atoms[j]] );
+    }
+  }
+  built=true;
+}
+
+}
+}
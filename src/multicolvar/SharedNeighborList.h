@@ -0,0 +1,191 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2018 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_multicolvar_SharedNeighborList_h
+#define __PLUMED_multicolvar_SharedNeighborList_h
+
+#include "tools/Exception.h"
+#include "tools/LinkCells.h"
+#include "tools/Tensor.h"
+#include "tools/Vector.h"
+#include <vector>
+
+namespace PLMD {
+
+class Communicator;
+class Pbc;
+
+namespace multicolvar {
+
+/// \ingroup TOOLBOX
+/// A neighbor list that can be shared by several multicolvars that use the
+/// SPECIES keyword with the same atoms.  The link cells are built once per step and
+/// the list of neighbors within the cutoff of each central atom is stored together
+/// with the separation vectors in compressed sparse row format.  If a skin is used
+/// the list contains all the atoms within the cutoff plus the skin and is reused until
+/// the atoms and the box have moved so much that pairs that were not in the list might be
+/// within the cutoff.
+class SharedNeighborList {
+private:
+/// Are we running the calculation in serial
+  bool serial;
+/// The skin that is added to the cutoff
+  double skin;
+/// The link cells used to build the list
+  LinkCells linkcells;
+/// Has the list been built during this step
+  bool built;
+/// Number of actions that are using this list
+  unsigned nusers;
+/// Position of the first neighbor of each central atom in the lists below
+  std::vector<unsigned> nl_start;
+/// Does this central atom have atoms in the surrounding link cells
+  std::vector<unsigned> nl_hascells;
+/// Was the list for this central atom built on this node
+  std::vector<unsigned> nl_built;
+/// The indices of the neighbors
+  std::vector<unsigned> nl_atoms;
+/// The separations between the central atom and its neighbors
+  std::vector<Vector> nl_seps;
+/// The positions of the atoms when the list was last rebuilt
+  std::vector<Vector> refpos;
+/// The box when the list was last rebuilt
+  Tensor refbox;
+public:
+  SharedNeighborList( Communicator& comm, const bool& serial, const double& skin );
+/// Add an action to the list of users.  The cutoff is the largest of the cutoffs requested
+  void addUser( const double& lcut );
+/// Get the number of actions using the list
+  unsigned getNumberOfUsers() const ;
+/// Are we running in serial
+  bool isSerial() const ;
+/// Get the cutoff that is used to build the list.  This includes the skin
+  double getCutoff() const ;
+/// Get the skin
+  double getSkin() const ;
+/// Make sure that the list is rebuilt the next time it is needed
+  void invalidate();
+/// Has the list been built during this step
+  bool isBuilt() const ;
+/// Build the list.  Neighbors are taken from the atoms in nind (with positions npos) and
+/// lists are built for the central atoms in rows, which are numbers between 0 and ncentral-1.
+/// If the list was already built during this step the lists that were built are kept.
+/// All positions are in allpos.
+  void build( const std::vector<Vector>& npos, const std::vector<unsigned>& nind, const unsigned& ncentral,
+              const std::vector<Vector>& allpos, const Pbc& pbc, const bool& usepbc, const std::vector<unsigned>& rows );
+/// Rebuild the link cells without rebuilding the list
+  void updateCells( const std::vector<Vector>& npos, const std::vector<unsigned>& nind, const Pbc& pbc );
+/// Get the positions of the atoms when the list was last rebuilt
+  const std::vector<Vector>& getReferencePositions() const ;
+/// Get the box when the list was last rebuilt
+  const Tensor& getReferenceBox() const ;
+/// Recompute the separations between the atoms in the list without rebuilding it
+  void updateSeparations( const std::vector<Vector>& allpos, const Pbc& pbc, const bool& usepbc );
+/// Was the list for this central atom built on this node
+  bool isBuiltFor( const unsigned& iatom ) const ;
+/// Were the lists for all these central atoms built on this node
+  bool isBuiltForAll( const std::vector<unsigned>& rows ) const ;
+/// Are there any atoms in the link cells that surround this central atom
+  bool hasAtomsInCells( const unsigned& iatom ) const ;
+/// The number of neighbors of this central atom that are within the cutoff
+  unsigned getNumberOfNeighbors( const unsigned& iatom ) const ;
+/// Get the indices of the neighbors of the central atom
+  const unsigned* getNeighbors( const unsigned& iatom ) const ;
+/// Get the separations between the central atom and its neighbors
+  const Vector* getSeparations( const unsigned& iatom ) const ;
+/// Get the underlying link cells
+  const LinkCells& getLinkCells() const ;
+};
+
+inline
+unsigned SharedNeighborList::getNumberOfUsers() const {
+  return nusers;
+}
+
+inline
+double SharedNeighborList::getSkin() const {
+  return skin;
+}
+
+inline
+bool SharedNeighborList::isSerial() const {
+  return serial;
+}
+
+inline
+void SharedNeighborList::invalidate() {
+  built=false;
+}
+
+inline
+bool SharedNeighborList::isBuilt() const {
+  return built;
+}
+
+inline
+bool SharedNeighborList::isBuiltFor( const unsigned& iatom ) const {
+  plumed_dbg_assert( iatom<nl_built.size() );
+  return nl_built[iatom]>0;
+}
+
+inline
+bool SharedNeighborList::hasAtomsInCells( const unsigned& iatom ) const {
+  plumed_dbg_assert( iatom<nl_hascells.size() );
+  return nl_hascells[iatom]>0;
+}
+
+inline
+unsigned SharedNeighborList::getNumberOfNeighbors( const unsigned& iatom ) const {
+  plumed_dbg_assert( iatom+1<nl_start.size() );
+  return nl_start[iatom+1] - nl_start[iatom];
+}
+
+inline
+const unsigned* SharedNeighborList::getNeighbors( const unsigned& iatom ) const {
+  plumed_dbg_assert( iatom+1<nl_start.size() );
+  return nl_atoms.data() + nl_start[iatom];
+}
+
+inline
+const Vector* SharedNeighborList::getSeparations( const unsigned& iatom ) const {
+  plumed_dbg_assert( iatom+1<nl_start.size() );
+  return nl_seps.data() + nl_start[iatom];
+}
+
+inline
+const std::vector<Vector>& SharedNeighborList::getReferencePositions() const {
+  return refpos;
+}
+
+inline
+const Tensor& SharedNeighborList::getReferenceBox() const {
+  return refbox;
+}
+
+inline
+const LinkCells& SharedNeighborList::getLinkCells() const {
+  return linkcells;
+}
+
+}
+}
+
+#endif
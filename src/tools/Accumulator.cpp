@@ -0,0 +1,157 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2018 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "Accumulator.h"
+#include "Communicator.h"
+#include "Exception.h"
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace PLMD {
+
+namespace {
+/// log(exp(a)+exp(b)) without overflow
+inline double logAddExp(double a,double b) {
+  if(a<b) std::swap(a,b);
+  if(b==-std::numeric_limits<double>::infinity()) return a;
+  return a+std::log1p(std::exp(b-a));
+}
+}
+
+Accumulator::Accumulator(unsigned ncomp):
+  ncomp(ncomp),
+  mean(ncomp),
+  meanComp(ncomp),
+  var(ncomp)
+{
+  clear();
+}
+
+void Accumulator::clear() {
+  nsamples=0;
+  logSumWeights=-std::numeric_limits<double>::infinity();
+  logSumWeights2=-std::numeric_limits<double>::infinity();
+  mean.assign(ncomp,0.0);
+  meanComp.assign(ncomp,0.0);
+  var.assign(ncomp,0.0);
+}
+
+void Accumulator::add(const double*x,double logweight) {
+  plumed_dbg_massert(!std::isnan(logweight),"log-weight is not a number");
+  if(nsamples==0) {
+    nsamples=1;
+    logSumWeights=logweight;
+    logSumWeights2=2*logweight;
+    for(unsigned i=0; i<ncomp; i++) {
+      mean[i]=x[i]; meanComp[i]=0.0; var[i]=0.0;
+    }
+    return;
+  }
+  nsamples++;
+  double newLog=logAddExp(logSumWeights,logweight);
+// fraction of the total weight carried by the new sample and by the old ones
+  double r=std::exp(logweight-newLog);
+  double q=std::exp(logSumWeights-newLog);
+  logSumWeights=newLog;
+  logSumWeights2=logAddExp(logSumWeights2,2*logweight);
+  for(unsigned i=0; i<ncomp; i++) {
+    double d=x[i]-getMean(i);
+    double y=r*d-meanComp[i];
+    double t=mean[i]+y;
+    meanComp[i]=(t-mean[i])-y;
+    mean[i]=t;
+    var[i]=q*(var[i]+r*d*d);
+  }
+}
+
+void Accumulator::merge(const Accumulator&a) {
+  plumed_massert(a.ncomp==ncomp,"merging accumulators with a different number of components");
+  if(a.nsamples==0) return;
+  if(nsamples==0) {
+    *this=a;
+    return;
+  }
+  nsamples+=a.nsamples;
+  double newLog=logAddExp(logSumWeights,a.logSumWeights);
+  double q=std::exp(logSumWeights-newLog);
+  double r=std::exp(a.logSumWeights-newLog);
+  logSumWeights=newLog;
+  logSumWeights2=logAddExp(logSumWeights2,a.logSumWeights2);
+  for(unsigned i=0; i<ncomp; i++) {
+    double m=getMean(i);
+    double d=a.getMean(i)-m;
+    mean[i]=m+r*d;
+    meanComp[i]=0.0;
+    var[i]=q*var[i]+r*a.var[i]+q*r*d*d;
+  }
+}
+
+void Accumulator::mergeOverComm(Communicator&comm) {
+  int size=comm.Get_size();
+  if(size==1) return;
+  std::vector<double> state;
+  getState(state);
+  std::vector<double> all(size*state.size());
+  comm.Allgather(state,all);
+  Accumulator tmp(ncomp);
+  clear();
+  for(int i=0; i<size; i++) {
+    for(unsigned j=0; j<state.size(); j++) state[j]=all[i*state.size()+j];
+    tmp.setState(state);
+    merge(tmp);
+  }
+}
+
+double Accumulator::getSumWeights()const {
+  return std::exp(logSumWeights);
+}
+
+double Accumulator::getEffectiveSampleSize()const {
+  if(nsamples==0) return 0.0;
+  return std::exp(2*logSumWeights-logSumWeights2);
+}
+
+void Accumulator::getState(std::vector<double>&state)const {
+  state.resize(getStateSize());
+  state[0]=nsamples;
+  state[1]=logSumWeights;
+  state[2]=logSumWeights2;
+  for(unsigned i=0; i<ncomp; i++) {
+    state[3+3*i]=mean[i];
+    state[4+3*i]=meanComp[i];
+    state[5+3*i]=var[i];
+  }
+}
+
+void Accumulator::setState(const std::vector<double>&state) {
+  plumed_massert(state.size()==getStateSize(),"wrong size of accumulator state");
+  nsamples=static_cast<unsigned long long>(state[0]);
+  logSumWeights=state[1];
+  logSumWeights2=state[2];
+  for(unsigned i=0; i<ncomp; i++) {
+    mean[i]=state[3+3*i];
+    meanComp[i]=state[4+3*i];
+    var[i]=state[5+3*i];
+  }
+}
+
+}
@@ -0,0 +1,106 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2018 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_tools_Accumulator_h
+#define __PLUMED_tools_Accumulator_h
+
+#include <vector>
+
+namespace PLMD {
+
+class Communicator;
+
+/**
+\ingroup TOOLBOX
+Streaming accumulator for weighted averages and variances.
+
+Samples are added one at a time together with the logarithm of their weight,
+as computed for instance by the reweighting actions.
+The sum of the weights is accumulated as a logarithm (log-sum-exp), and the mean
+and the variance are updated with Welford's recurrence using only ratios of weights.
+Large log-weights thus never overflow, and the mean is updated with
+Kahan compensation so that long runs do not lose precision.
+
+Two accumulators can be merged, so that samples can be distributed over
+threads or MPI processes and combined at the end. The state of an accumulator
+is a short vector of doubles that can be written to a checkpoint or
+communicated and then restored with setState().
+
+\verbatim
+Accumulator acc(2);
+for(...) acc.add(x,logweight);
+double av=acc.getMean(0);
+\endverbatim
+*/
+class Accumulator {
+/// Number of quantities that are averaged
+  unsigned ncomp;
+/// Number of samples
+  unsigned long long nsamples;
+/// Logarithm of the sum of the weights
+  double logSumWeights;
+/// Logarithm of the sum of the squared weights
+  double logSumWeights2;
+/// Weighted means
+  std::vector<double> mean;
+/// Kahan compensation of the means
+  std::vector<double> meanComp;
+/// Weighted variances (second central moments divided by the sum of the weights)
+  std::vector<double> var;
+public:
+/// Create an accumulator for a given number of quantities
+  explicit Accumulator(unsigned ncomp=1);
+/// Remove all the samples
+  void clear();
+/// Add a sample with a given log-weight. x should contain getNumberOfComponents() values.
+  void add(const double*x,double logweight=0.0);
+/// Add a sample of a single quantity with a given log-weight
+  void add(double x,double logweight=0.0) {add(&x,logweight);}
+/// Add all the samples accumulated in another accumulator
+  void merge(const Accumulator&);
+/// Merge the accumulators of all the processes in a communicator.
+/// The merge is done in the order of the ranks, so that all processes obtain the same result.
+  void mergeOverComm(Communicator&);
+/// Get the number of quantities that are averaged
+  unsigned getNumberOfComponents()const {return ncomp;}
+/// Get the number of samples
+  unsigned long long getNumberOfSamples()const {return nsamples;}
+/// Get the logarithm of the sum of the weights
+  double getLogSumWeights()const {return logSumWeights;}
+/// Get the sum of the weights
+  double getSumWeights()const;
+/// Get the effective sample size, (sum w)^2/(sum w^2)
+  double getEffectiveSampleSize()const;
+/// Get the weighted mean of a quantity
+  double getMean(unsigned i)const {return mean[i]-meanComp[i];}
+/// Get the weighted variance of a quantity
+  double getVariance(unsigned i)const {return var[i];}
+/// Get the size of the vector returned by getState()
+  unsigned getStateSize()const {return 3+3*ncomp;}
+/// Copy the state of the accumulator to a vector
+  void getState(std::vector<double>&)const;
+/// Restore the state of the accumulator from a vector obtained with getState()
+  void setState(const std::vector<double>&);
+};
+
+}
+
+#endif
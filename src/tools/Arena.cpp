@@ -0,0 +1,56 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2018 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "Arena.h"
+
+namespace PLMD {
+
+Arena::Arena(std::size_t size):
+  capacity(0),
+  blockSize(0),
+  used(0),
+  heapAllocations(0)
+{
+  newBlock(size);
+}
+
+void Arena::newBlock(std::size_t size) {
+// blocks grow geometrically so that a step needs few of them
+  if(size<2*blockSize) size=2*blockSize;
+  blocks.emplace_back(new char[size]);
+  heapAllocations++;
+  capacity+=size;
+  blockSize=size;
+  used=0;
+}
+
+void Arena::reset() {
+  if(blocks.size()>1) {
+    std::size_t size=capacity;
+    blocks.clear();
+    capacity=0;
+    blockSize=0;
+    newBlock(size);
+  }
+  used=0;
+}
+
+}
@@ -0,0 +1,147 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2018 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_tools_Arena_h
+#define __PLUMED_tools_Arena_h
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace PLMD {
+
+/**
+\ingroup TOOLBOX
+A bump allocator for temporary storage.
+
+Memory is taken from a large block by just moving a pointer, and it is
+never released individually. All the memory is released at once with reset(),
+which makes it available again. When a block is exhausted a new one is allocated;
+at the following reset() all the blocks are merged in a single one large enough to
+contain all of them, so that after a few steps no further heap allocation is done.
+
+PlumedMain owns one arena per OpenMP thread and resets all of them at the beginning
+of every calculation. Actions can thus use the arena returned by PlumedMain::getArena()
+for the temporaries of calculate(), which should not survive the step.
+The easiest way is to use an ArenaVector:
+
+\verbatim
+ArenaScope scope(plumed.getArena());
+ArenaVector<Vector> deriv(getNumberOfAtoms(),Vector(),ArenaAllocator<Vector>(plumed.getArena()));
+\endverbatim
+
+The ArenaScope releases the memory taken after its construction when it goes
+out of scope, so that calculate() can be called many times within the same step
+(e.g. with NUMERICAL_DERIVATIVES) without making the arena grow.
+
+Notice that PlumedMain::getArena() returns the arena of the calling thread, so that
+it can be safely used inside OpenMP parallel regions.
+*/
+class Arena {
+/// Blocks that have been allocated
+  std::vector<std::unique_ptr<char[]>> blocks;
+/// Total size of the blocks
+  std::size_t capacity;
+/// Size of the block currently in use
+  std::size_t blockSize;
+/// Number of bytes used in the block currently in use
+  std::size_t used;
+/// Number of heap allocations done since the arena was created
+  unsigned long long heapAllocations;
+/// Allocate a new block of at least the given size
+  void newBlock(std::size_t size);
+public:
+/// Position in the arena, see getMark() and release()
+  struct Mark {
+    std::size_t block;
+    std::size_t used;
+  };
+/// Create an arena with a first block of the given size (bytes)
+  explicit Arena(std::size_t size=65536);
+/// Get a chunk of memory of the given size and alignment
+  void* allocate(std::size_t bytes,std::size_t alignment);
+/// Release all the memory at once, merging the blocks if more than one was needed
+  void reset();
+/// Get the current position in the arena
+  Mark getMark()const {Mark m; m.block=blocks.size(); m.used=used; return m;}
+/// Release the memory taken after the mark was obtained.
+/// Memory obtained before the mark is untouched.
+  void release(const Mark& mark) {used=(blocks.size()==mark.block?mark.used:0);}
+/// Get the total size of the blocks (bytes)
+  std::size_t getCapacity()const {return capacity;}
+/// Get the number of heap allocations done by the arena.
+/// If this number does not change between two resets, the temporary
+/// storage of the step has been obtained without touching the heap.
+  unsigned long long getHeapAllocations()const {return heapAllocations;}
+};
+
+/// Releases the memory taken from an Arena during its lifetime
+class ArenaScope {
+  Arena& arena;
+  Arena::Mark mark;
+public:
+  explicit ArenaScope(Arena& a): arena(a), mark(a.getMark()) {}
+  ArenaScope(const ArenaScope&) = delete;
+  ArenaScope& operator=(const ArenaScope&) = delete;
+  ~ArenaScope() {arena.release(mark);}
+};
+
+/// Allocator that takes memory from an Arena, to be used with standard containers.
+template <class T>
+class ArenaAllocator {
+  template <class U> friend class ArenaAllocator;
+  Arena* arena;
+public:
+  typedef T value_type;
+  explicit ArenaAllocator(Arena& a): arena(&a) {}
+  template <class U>
+  ArenaAllocator(const ArenaAllocator<U>& other): arena(other.arena) {}
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(arena->allocate(n*sizeof(T),alignof(T)));
+  }
+/// Memory is only released when the arena is reset
+  void deallocate(T*,std::size_t) {}
+  template <class U>
+  bool operator==(const ArenaAllocator<U>& other)const {return arena==other.arena;}
+  template <class U>
+  bool operator!=(const ArenaAllocator<U>& other)const {return arena!=other.arena;}
+};
+
+/// Vector whose storage is taken from an Arena
+template <class T>
+using ArenaVector=std::vector<T,ArenaAllocator<T>>;
+
+inline
+void* Arena::allocate(std::size_t bytes,std::size_t alignment) {
+  std::size_t start=(reinterpret_cast<std::size_t>(blocks.back().get())+used+alignment-1)/alignment*alignment
+                    -reinterpret_cast<std::size_t>(blocks.back().get());
+  if(start+bytes>blockSize) {
+    newBlock(bytes+alignment);
+    start=(reinterpret_cast<std::size_t>(blocks.back().get())+alignment-1)/alignment*alignment
+          -reinterpret_cast<std::size_t>(blocks.back().get());
+  }
+  used=start+bytes;
+  return blocks.back().get()+start;
+}
+
+}
+
+#endif
@@ -22,6 +22,7 @@
 #include "Communicator.h"
 #include "Exception.h"
 #include <cstdlib>
+#include <cstring>
 
 using namespace std;
 
@@ -131,6 +132,106 @@ void Communicator::Abort(int errorcode) {
 #endif
 }
 
+void Communicator::DeferSum(Data data) {
+  plumed_massert(deferredRequests.empty(),"cannot register a buffer while deferred sums are in progress");
+  if(data.size>0) deferred.push_back(data);
+}
+
+void Communicator::packDeferred() {
+  deferredGroups.clear();
+#if defined(__PLUMED_HAS_MPI)
+  std::size_t bytes=0;
+  for(unsigned i=0; i<deferred.size(); i++) {
+    bool found=false;
+    for(const auto & g : deferredGroups) if(g.type==deferred[i].type) found=true;
+    if(found) continue;
+// a new type: all the buffers with this type are packed together
+    int typesize;
+    MPI_Type_size(deferred[i].type,&typesize);
+    DeferredGroup g;
+    g.type=deferred[i].type;
+    g.offset=bytes;
+    g.count=0;
+    for(unsigned j=i; j<deferred.size(); j++) if(deferred[j].type==g.type) g.count+=deferred[j].size;
+    bytes+=std::size_t(g.count)*typesize;
+    deferredGroups.push_back(g);
+  }
+  deferredBuffer.resize(bytes);
+  for(const auto & g : deferredGroups) {
+    int typesize;
+    MPI_Type_size(g.type,&typesize);
+    char* p=deferredBuffer.data()+g.offset;
+    for(const auto & d : deferred) if(d.type==g.type) {
+        std::memcpy(p,d.pointer,std::size_t(d.size)*typesize);
+        p+=std::size_t(d.size)*typesize;
+      }
+  }
+#endif
+}
+
+void Communicator::unpackDeferred() {
+#if defined(__PLUMED_HAS_MPI)
+  for(const auto & g : deferredGroups) {
+    int typesize;
+    MPI_Type_size(g.type,&typesize);
+    const char* p=deferredBuffer.data()+g.offset;
+    for(const auto & d : deferred) if(d.type==g.type) {
+        std::memcpy(d.pointer,p,std::size_t(d.size)*typesize);
+        p+=std::size_t(d.size)*typesize;
+      }
+  }
+#endif
+  deferred.clear();
+  deferredGroups.clear();
+}
+
+void Communicator::SumDeferred() {
+  plumed_massert(deferredRequests.empty(),"deferred sums are already in progress, use WaitDeferred()");
+#if defined(__PLUMED_HAS_MPI)
+  if(initialized() && Get_size()>1) {
+    packDeferred();
+    for(const auto & g : deferredGroups)
+      MPI_Allreduce(MPI_IN_PLACE,deferredBuffer.data()+g.offset,g.count,g.type,MPI_SUM,communicator);
+    unpackDeferred();
+  }
+#endif
+// with a single process the sums are already done
+  deferred.clear();
+}
+
+void Communicator::IsumDeferred() {
+  plumed_massert(deferredRequests.empty(),"deferred sums are already in progress, use WaitDeferred()");
+#if defined(__PLUMED_HAS_MPI)
+  if(initialized() && Get_size()>1) {
+    packDeferred();
+    deferredRequests.resize(deferredGroups.size());
+    for(unsigned i=0; i<deferredGroups.size(); i++) {
+      const DeferredGroup & g(deferredGroups[i]);
+#if MPI_VERSION >= 3
+      MPI_Iallreduce(MPI_IN_PLACE,deferredBuffer.data()+g.offset,g.count,g.type,MPI_SUM,communicator,&deferredRequests[i]);
+#else
+// MPI_Iallreduce is not available before MPI 3, the sum is done here
+      MPI_Allreduce(MPI_IN_PLACE,deferredBuffer.data()+g.offset,g.count,g.type,MPI_SUM,communicator);
+      deferredRequests[i]=MPI_REQUEST_NULL;
+#endif
+    }
+    return;
+  }
+#endif
+  deferred.clear();
+}
+
+void Communicator::WaitDeferred() {
+#if defined(__PLUMED_HAS_MPI)
+  if(!deferredRequests.empty()) {
+    MPI_Waitall(deferredRequests.size(),deferredRequests.data(),MPI_STATUSES_IGNORE);
+    deferredRequests.clear();
+    unpackDeferred();
+  }
+#endif
+  deferred.clear();
+}
+
 void Communicator::Bcast(Data data,int root) {
 #if defined(__PLUMED_HAS_MPI)
   if(initialized()) MPI_Bcast(data.pointer,data.size,data.type,root,communicator);
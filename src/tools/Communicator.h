@@ -119,6 +119,23 @@ class Communicator {
       else { pointer=NULL; size=0; }
     }
   };
+/// Elements of the same type packed in deferredBuffer
+  struct DeferredGroup {
+    MPI_Datatype type;
+    std::size_t offset;
+    int count;
+  };
+/// Buffers registered with DeferSum() and not summed yet
+  std::vector<Data> deferred;
+/// Contiguous copy of the deferred buffers, grouped by type
+  std::vector<char> deferredBuffer;
+  std::vector<DeferredGroup> deferredGroups;
+/// Requests of the sums started by IsumDeferred()
+  std::vector<MPI_Request> deferredRequests;
+/// Copy the deferred buffers in deferredBuffer
+  void packDeferred();
+/// Copy the sums back in the deferred buffers and forget them
+  void unpackDeferred();
 public:
 /// Wrapper class for MPI_Status
   class Status {
@@ -182,6 +199,25 @@ public:
 /// Wrapper for MPI_Allreduce with MPI_SUM (reference)
   template <class T> void Sum(T&buf) {Sum(Data(buf));}
 
+/// Register a buffer to be summed later (data struct).
+/// The buffer is not modified until SumDeferred() (or WaitDeferred()) is called,
+/// and it should not be used, resized or destroyed before. All the buffers registered
+/// in the meanwhile are summed together, with a single MPI_Allreduce for each data type.
+  void DeferSum(Data);
+/// Register a buffer to be summed later (pointer)
+  template <class T> void DeferSum(T*buf,int count) {DeferSum(Data(buf,count));}
+/// Register a buffer to be summed later (reference)
+  template <class T> void DeferSum(T&buf) {DeferSum(Data(buf));}
+/// Sum all the buffers registered with DeferSum()
+  void SumDeferred();
+/// Start the sum of all the buffers registered with DeferSum() with MPI_Iallreduce.
+/// Results are only available in the buffers after WaitDeferred().
+  void IsumDeferred();
+/// Wait for the sums started with IsumDeferred()
+  void WaitDeferred();
+/// Number of buffers registered with DeferSum() and not summed yet
+  unsigned getNumberOfDeferred()const {return deferred.size();}
+
 /// Wrapper for MPI_Bcast (data struct)
   void Bcast(Data,int);
 /// Wrapper for MPI_Bcast (pointer)
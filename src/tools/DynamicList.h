@@ -170,6 +170,10 @@ public:
   unsigned fullSize() const;
 /// Return the number of elements that are currently active
   unsigned getNumberActive() const;
+/// Return the memory allocated for the list (bytes), not counting the object itself
+  std::size_t getMemoryUsage() const {
+    return all.capacity()*sizeof(T)+(onoff.capacity()+active.capacity())*sizeof(unsigned);
+  }
 /// Find out if a member is active
   bool isActive(const unsigned& ) const;
 /// Setup MPI communication if things are activated/deactivated on different nodes
@@ -35,6 +35,17 @@
 #include <sstream>
 #include <cstdio>
 #include <cfloat>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 namespace PLMD {
@@ -163,6 +174,12 @@ Grid::index_t Grid::getSize() const {
   return maxsize_;
 }
 
+std::size_t Grid::getMemoryUsage() const {
+  std::size_t m=sizeof(Grid)+grid_.capacity()*sizeof(double)+der_.capacity()*sizeof(std::vector<double>);
+  for(const auto & d : der_) m+=d.capacity()*sizeof(double);
+  return m;
+}
+
 unsigned Grid::getDimension() const {
   return dimension_;
 }
@@ -696,19 +713,344 @@ std::unique_ptr<Grid> Grid::create(const std::string& funcl, const std::vector<V
   return grid;
 }
 
-// Sparse version of grid with map
+void Grid::getSetPoints(std::vector<index_t> & points) const {
+  plumed_merror("getSetPoints() is only available for sparse grids");
+}
+
+namespace {
+
+/// Identifies binary grid files
+const char binaryGridMagic[8]= {'P','L','M','D','G','R','I','D'};
+/// Version of the binary grid format
+const std::uint64_t binaryGridVersion=1;
+/// Written in the header to detect files written on machines with a different byte order
+const std::uint64_t binaryGridEndian=0x0102030405060708ULL;
+
+/// Buffered writer of binary grid files
+class BinaryGridWriter {
+  FILE* fp;
+  std::string path;
+  std::size_t written;
+public:
+  explicit BinaryGridWriter(const std::string& path):
+    fp(std::fopen(path.c_str(),"wb")),
+    path(path),
+    written(0)
+  {
+    plumed_massert(fp,"cannot open binary grid file "+path+" for writing");
+  }
+  ~BinaryGridWriter() {if(fp) std::fclose(fp);}
+  void write(const void* ptr,std::size_t n) {
+    if(n==0) return;
+    plumed_massert(std::fwrite(ptr,1,n,fp)==n,"error writing binary grid file "+path);
+    written+=n;
+  }
+  void write(std::uint64_t i) {write(&i,sizeof(i));}
+  void write(const std::string& s) {write(std::uint64_t(s.length())); write(s.c_str(),s.length());}
+/// pad with zeros so that the next data is aligned to 8 bytes
+  void align() {
+    const char zeros[8]= {0,0,0,0,0,0,0,0};
+    write(zeros,(8-written%8)%8);
+  }
+/// flush the data to the disk and close the file
+  void close() {
+    plumed_massert(std::fflush(fp)==0,"error writing binary grid file "+path);
+#if defined(__unix__) || defined(__APPLE__)
+    fsync(fileno(fp));
+#endif
+    plumed_massert(std::fclose(fp)==0,"error closing binary grid file "+path);
+    fp=NULL;
+  }
+};
+
+/// Read-only view of a binary grid file.
+/// The file is mapped in memory when possible, otherwise it is read in a buffer.
+class BinaryGridReader {
+  std::string path;
+  std::vector<char> buffer;
+  const char* data;
+  std::size_t size;
+  std::size_t pos;
+#if defined(__unix__) || defined(__APPLE__)
+  void* map;
+#endif
+public:
+  explicit BinaryGridReader(const std::string& path):
+    path(path),
+    data(NULL),
+    size(0),
+    pos(0)
+  {
+#if defined(__unix__) || defined(__APPLE__)
+    map=NULL;
+    int fd=open(path.c_str(),O_RDONLY);
+    plumed_massert(fd>=0,"cannot open binary grid file "+path);
+    struct stat st;
+    if(fstat(fd,&st)==0 && st.st_size>0) {
+      size=st.st_size;
+      map=mmap(NULL,size,PROT_READ,MAP_PRIVATE,fd,0);
+      if(map==MAP_FAILED) map=NULL;
+      else {
+        data=static_cast<const char*>(map);
+        madvise(map,size,MADV_SEQUENTIAL);
+      }
+    }
+    ::close(fd);
+    if(data) return;
+#endif
+    FILE* fp=std::fopen(path.c_str(),"rb");
+    plumed_massert(fp,"cannot open binary grid file "+path);
+    char chunk[65536];
+    std::size_t n;
+    while((n=std::fread(chunk,1,sizeof(chunk),fp))>0) buffer.insert(buffer.end(),chunk,chunk+n);
+    std::fclose(fp);
+    data=buffer.data();
+    size=buffer.size();
+  }
+  ~BinaryGridReader() {
+#if defined(__unix__) || defined(__APPLE__)
+    if(map) munmap(map,size);
+#endif
+  }
+  void read(void* ptr,std::size_t n) {
+    plumed_massert(pos+n<=size,"binary grid file "+path+" is truncated");
+    std::memcpy(ptr,data+pos,n);
+    pos+=n;
+  }
+  std::uint64_t readInt() {std::uint64_t i; read(&i,sizeof(i)); return i;}
+  std::string readString() {
+    std::uint64_t n=readInt();
+    plumed_massert(pos+n<=size,"binary grid file "+path+" is truncated");
+    std::string s(data+pos,n);
+    pos+=n;
+    return s;
+  }
+  void align() {pos+=(8-pos%8)%8;}
+};
+
+}
+
+bool Grid::isBinaryFile(const std::string& path) {
+  char magic[sizeof(binaryGridMagic)];
+  FILE* fp=std::fopen(path.c_str(),"rb");
+  if(!fp) return false;
+  bool ok=(std::fread(magic,1,sizeof(magic),fp)==sizeof(magic)) && std::memcmp(magic,binaryGridMagic,sizeof(magic))==0;
+  std::fclose(fp);
+  return ok;
+}
+
+void Grid::writeBinary(const std::string& path) {
+  bool sparse=isSparse();
+  std::vector<index_t> points;
+  if(sparse) getSetPoints(points);
+  index_t npoints=(sparse?points.size():maxsize_);
+  std::string tmppath=path+".tmp";
+  {
+    BinaryGridWriter w(tmppath);
+    w.write(binaryGridMagic,sizeof(binaryGridMagic));
+    w.write(binaryGridVersion);
+    w.write(binaryGridEndian);
+    w.write(std::uint64_t(dimension_));
+    w.write(std::uint64_t(usederiv_));
+    w.write(std::uint64_t(sparse));
+    w.write(std::uint64_t(npoints));
+    w.write(funcname);
+    for(unsigned j=0; j<dimension_; ++j) {
+      w.write(argnames[j]);
+      w.write(str_min_[j]);
+      w.write(str_max_[j]);
+      w.write(std::uint64_t(nbin_[j]));
+      w.write(std::uint64_t(pbc_[j]));
+    }
+    w.align();
+    if(!sparse) {
+// dense grids are written directly from their storage
+      w.write(grid_.data(),npoints*sizeof(double));
+      if(usederiv_) for(index_t i=0; i<npoints; ++i) w.write(der_[i].data(),dimension_*sizeof(double));
+    } else {
+      std::vector<std::uint64_t> indices(points.begin(),points.end());
+      std::vector<double> values(npoints);
+      std::vector<double> ders(usederiv_?npoints*dimension_:0);
+      std::vector<double> der(dimension_);
+      for(index_t i=0; i<npoints; ++i) {
+        if(usederiv_) {
+          values[i]=getValueAndDerivatives(points[i],der);
+          for(unsigned j=0; j<dimension_; ++j) ders[i*dimension_+j]=der[j];
+        } else values[i]=getValue(points[i]);
+      }
+      w.write(indices.data(),npoints*sizeof(std::uint64_t));
+      w.write(values.data(),npoints*sizeof(double));
+      w.write(ders.data(),ders.size()*sizeof(double));
+    }
+    w.close();
+  }
+  int check=std::rename(tmppath.c_str(),path.c_str());
+  plumed_massert(check==0,"renaming "+tmppath+" into "+path+" failed for reason: "+strerror(errno));
+}
+
+std::unique_ptr<Grid> Grid::createFromBinary(const std::string& funcl, const std::vector<Value*> & args, const std::string& path,
+    const vector<std::string> & gmin,const vector<std::string> & gmax,
+    const vector<unsigned> & nbin,bool dosparse, bool dospline, bool doder) {
+  BinaryGridReader r(path);
+  char magic[sizeof(binaryGridMagic)];
+  r.read(magic,sizeof(magic));
+  plumed_massert(std::memcmp(magic,binaryGridMagic,sizeof(magic))==0,"file "+path+" is not a binary grid file");
+  plumed_massert(r.readInt()==binaryGridVersion,"unsupported version of binary grid file "+path);
+  plumed_massert(r.readInt()==binaryGridEndian,"binary grid file "+path+" was written on a machine with a different byte order");
+  unsigned nvar=args.size();
+  plumed_massert(r.readInt()==nvar,"mismatch between dimensionality of binary grid file and number of arguments");
+  bool hasder=r.readInt();
+  bool filesparse=r.readInt();
+  index_t npoints=r.readInt();
+  if( doder && !hasder ) plumed_merror("missing derivatives from grid file");
+  plumed_massert( r.readString()==funcl, "binary grid file does not contain " + funcl );
+  std::vector<std::string> cmin(nvar),cmax(nvar);
+  std::vector<unsigned> cbin(nvar);
+  for(unsigned i=0; i<nvar; ++i) {
+    if( r.readString()!=args[i]->getName() ) plumed_merror("arguments in input are not in same order as in grid file");
+    cmin[i]=r.readString();
+    cmax[i]=r.readString();
+    cbin[i]=r.readInt();
+    bool periodic=r.readInt();
+    if( args[i]->isPeriodic() ) {
+      plumed_massert( periodic, "input value is periodic but grid is not");
+      std::string pmin, pmax;
+      args[i]->getDomain( pmin, pmax );
+      if( pmin!=cmin[i] || pmax!=cmax[i] ) plumed_merror("mismatch between grid boundaries and periods of values");
+    } else {
+      plumed_massert( !periodic, "input value is not periodic but grid is");
+      cbin[i]--;  // as in text files, the number of points is one more than the number of bins when data is not periodic
+    }
+    plumed_massert( cmin[i]==gmin[i], "mismatched grid min" );
+    plumed_massert( cmax[i]==gmax[i], "mismatched grid max" );
+    plumed_massert( cbin[i]==nbin[i], "mismatched grid nbins" );
+  }
+  r.align();
+
+  std::unique_ptr<Grid> grid;
+  if(!dosparse) {grid.reset(new Grid(funcl,args,gmin,gmax,cbin,dospline,doder));}
+  else {grid.reset(new SparseGrid(funcl,args,gmin,gmax,cbin,dospline,doder));}
+  if(!filesparse) plumed_massert(npoints==grid->maxsize_,"wrong number of points in binary grid file");
+
+  if(!filesparse && !dosparse && (doder || !hasder)) {
+// same layout as the storage of a dense grid
+    r.read(grid->grid_.data(),npoints*sizeof(double));
+    if(doder) for(index_t i=0; i<npoints; ++i) r.read(grid->der_[i].data(),nvar*sizeof(double));
+    return grid;
+  }
+
+  std::vector<std::uint64_t> indices(filesparse?npoints:0);
+  std::vector<double> values(npoints);
+  std::vector<double> ders(hasder?npoints*nvar:0);
+  r.read(indices.data(),indices.size()*sizeof(std::uint64_t));
+  r.read(values.data(),npoints*sizeof(double));
+  r.read(ders.data(),ders.size()*sizeof(double));
+  std::vector<double> der(nvar);
+  for(index_t i=0; i<npoints; ++i) {
+    index_t index=(filesparse?indices[i]:i);
+    plumed_massert(index<grid->maxsize_,"index out of range in binary grid file");
+    if(doder) {
+      for(unsigned j=0; j<nvar; ++j) der[j]=ders[i*nvar+j];
+      grid->setValueAndDerivatives(index,values[i],der);
+    } else grid->setValue(index,values[i]);
+  }
+  return grid;
+}
+
+// Sparse version of grid with tiles
+SparseGrid::SparseGrid(const std::string& funcl, const std::vector<Value*> & args, const std::vector<std::string> & gmin,
+                       const std::vector<std::string> & gmax,
+                       const std::vector<unsigned> & nbin, bool dospline, bool usederiv):
+  Grid(funcl,args,gmin,gmax,nbin,dospline,usederiv,false),
+  tileSize_(1),
+  pointSize_(usederiv?1+dimension_:1),
+  npoints_(0)
+{
+  setupTiles();
+}
+
+void SparseGrid::setupTiles() {
+// tiles of at most 256 points, with the same number of points along each dimension
+// (e.g. 16x16 in 2D, 6x6x6 in 3D, 4x4x4x4 in 4D), so that partially filled tiles
+// do not waste much memory when the visited region is small
+  const unsigned target=256;
+  unsigned edge=2;
+  for(;;) {
+    unsigned long long n=1;
+    for(unsigned i=0; i<dimension_; ++i) n*=edge+1;
+    if(n>target) break;
+    edge++;
+  }
+  tileBin_.resize(dimension_);
+  ntiles_.resize(dimension_);
+  tileSize_=1;
+  for(unsigned i=0; i<dimension_; ++i) {
+    tileBin_[i]=std::min(edge,nbin_[i]);
+    ntiles_[i]=(nbin_[i]+tileBin_[i]-1)/tileBin_[i];
+    tileSize_*=tileBin_[i];
+  }
+}
+
+void SparseGrid::getTileIndex(index_t index, index_t & tile, unsigned & local) const {
+  index_t kk=index;
+  index_t tstride=1;
+  unsigned lstride=1;
+  tile=0;
+  local=0;
+  for(unsigned i=0; i<dimension_; ++i) {
+    const unsigned ind=kk%nbin_[i];
+    kk/=nbin_[i];
+    tile+=(ind/tileBin_[i])*tstride;
+    local+=(ind%tileBin_[i])*lstride;
+    tstride*=ntiles_[i];
+    lstride*=tileBin_[i];
+  }
+}
+
+double* SparseGrid::modifyPoint(index_t index) {
+  index_t tile; unsigned local;
+  getTileIndex(index,tile,local);
+  Tile & t(tiles_[tile]);
+  if(t.data.empty()) {
+    t.data.assign(tileSize_*pointSize_,0.0);
+    t.isSet.assign(tileSize_,false);
+  }
+  if(!t.isSet[local]) {
+    t.isSet[local]=true;
+    npoints_++;
+  }
+  return &t.data[local*pointSize_];
+}
+
+const double* SparseGrid::findPoint(index_t index) const {
+  index_t tile; unsigned local;
+  getTileIndex(index,tile,local);
+  const auto it=tiles_.find(tile);
+  if(it==tiles_.end() || !it->second.isSet[local]) return NULL;
+  return &it->second.data[local*pointSize_];
+}
+
 void SparseGrid::clear() {
-  map_.clear();
+  tiles_.clear();
+  npoints_=0;
 }
 
 Grid::index_t SparseGrid::getSize() const {
-  return map_.size();
+  return npoints_;
 }
 
 Grid::index_t SparseGrid::getMaxSize() const {
   return maxsize_;
 }
 
+std::size_t SparseGrid::getMemoryUsage() const {
+// a node of the hash table stores the pair, the hash and a pointer, and each bucket is a pointer
+  const std::size_t node=2*sizeof(void*)+sizeof(std::pair<index_t,Tile>);
+  std::size_t m=sizeof(SparseGrid)+tiles_.bucket_count()*sizeof(void*);
+  m+=tiles_.size()*(node+tileSize_*pointSize_*sizeof(double)+tileSize_/8);
+  return m;
+}
+
 double Grid::getDifferenceFromContour( const std::vector<double>& x, std::vector<double>& der ) const {
   return getValueAndDerivatives( x, der ) - contour_location;
 }
@@ -758,57 +1100,83 @@ void Grid::findSetOfPointsOnContour(const double& target, const std::vector<bool
 
 double SparseGrid::getValue(index_t index)const {
   plumed_assert(index<maxsize_);
-  double value=0.0;
-  const auto it=map_.find(index);
-  if(it!=map_.end()) value=it->second;
-  return value;
+  const double* p=findPoint(index);
+  if(p) return p[0];
+  return 0.0;
 }
 
 double SparseGrid::getValueAndDerivatives
 (index_t index, vector<double>& der)const {
   plumed_assert(index<maxsize_ && usederiv_ && der.size()==dimension_);
-  double value=0.0;
-  for(unsigned int i=0; i<dimension_; ++i) der[i]=0.0;
-  const auto it=map_.find(index);
-  if(it!=map_.end()) value=it->second;
-  const auto itder=der_.find(index);
-  if(itder!=der_.end()) der=itder->second;
-  return value;
+  const double* p=findPoint(index);
+  if(!p) {
+    for(unsigned int i=0; i<dimension_; ++i) der[i]=0.0;
+    return 0.0;
+  }
+  for(unsigned int i=0; i<dimension_; ++i) der[i]=p[1+i];
+  return p[0];
 }
 
 void SparseGrid::setValue(index_t index, double value) {
   plumed_assert(index<maxsize_ && !usederiv_);
-  map_[index]=value;
+  modifyPoint(index)[0]=value;
 }
 
 void SparseGrid::setValueAndDerivatives
 (index_t index, double value, vector<double>& der) {
   plumed_assert(index<maxsize_ && usederiv_ && der.size()==dimension_);
-  map_[index]=value;
-  der_[index]=der;
+  double* p=modifyPoint(index);
+  p[0]=value;
+  for(unsigned int i=0; i<dimension_; ++i) p[1+i]=der[i];
 }
 
 void SparseGrid::addValue(index_t index, double value) {
   plumed_assert(index<maxsize_ && !usederiv_);
-  map_[index]+=value;
+  modifyPoint(index)[0]+=value;
 }
 
 void SparseGrid::addValueAndDerivatives
 (index_t index, double value, vector<double>& der) {
   plumed_assert(index<maxsize_ && usederiv_ && der.size()==dimension_);
-  map_[index]+=value;
-  der_[index].resize(dimension_);
-  for(unsigned int i=0; i<dimension_; ++i) der_[index][i]+=der[i];
+  double* p=modifyPoint(index);
+  p[0]+=value;
+  for(unsigned int i=0; i<dimension_; ++i) p[1+i]+=der[i];
+}
+
+void SparseGrid::getSetPoints(vector<index_t> & points) const {
+  points.clear();
+  points.reserve(npoints_);
+  vector<unsigned> corner(dimension_);
+  for(const auto & t : tiles_) {
+    index_t tt=t.first;
+    for(unsigned j=0; j<dimension_; ++j) {
+      corner[j]=(tt%ntiles_[j])*tileBin_[j];
+      tt/=ntiles_[j];
+    }
+    for(unsigned l=0; l<tileSize_; ++l) if(t.second.isSet[l]) {
+        unsigned ll=l;
+        index_t index=0, stride=1;
+        for(unsigned j=0; j<dimension_; ++j) {
+          index+=(corner[j]+ll%tileBin_[j])*stride;
+          ll/=tileBin_[j];
+          stride*=nbin_[j];
+        }
+        points.push_back(index);
+      }
+  }
+  std::sort(points.begin(),points.end());
 }
 
 void SparseGrid::writeToFile(OFile& ofile) {
   vector<double> xx(dimension_);
   vector<double> der(dimension_);
   double f;
+// points are written in the order of their index, as for a dense grid
+  vector<index_t> points;
+  getSetPoints(points);
   writeHeader(ofile);
   ofile.fmtField(" "+fmt_);
-  for(const auto & it : map_) {
-    index_t i=it.first;
+  for(const auto & i : points) {
     xx=getPoint(i);
     if(usederiv_) {f=getValueAndDerivatives(i,der);}
     else {f=getValue(i);}
@@ -25,6 +25,7 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <cmath>
 #include <memory>
 
@@ -94,6 +95,10 @@ protected:
   std::string fmt_; // format for output
 /// get "neighbors" for spline
   std::vector<index_t> getSplineNeighbors(const std::vector<unsigned> & indices)const;
+/// is only a subset of the points stored
+  virtual bool isSparse() const {return false;}
+/// get the indices of the points that have been set, in increasing order (only for sparse grids)
+  virtual void getSetPoints(std::vector<index_t> & points) const;
 
 
 public:
@@ -161,8 +166,16 @@ public:
   static std::unique_ptr<Grid> create(const std::string&,const std::vector<Value*>&, IFile&,
                                       const std::vector<std::string>&,const std::vector<std::string>&,
                                       const std::vector<unsigned>&,bool,bool,bool);
+/// check if a file contains a grid written with writeBinary()
+  static bool isBinaryFile(const std::string& path);
+/// read grid from a binary file written with writeBinary() and check boundaries are what is expected from input
+  static std::unique_ptr<Grid> createFromBinary(const std::string&,const std::vector<Value*>&,const std::string& path,
+      const std::vector<std::string>&,const std::vector<std::string>&,
+      const std::vector<unsigned>&,bool,bool,bool);
 /// get grid size
   virtual index_t getSize() const;
+/// get the memory allocated for the grid (bytes)
+  virtual std::size_t getMemoryUsage() const;
 /// get grid value
   virtual double getValue(index_t index) const;
   virtual double getValue(const std::vector<unsigned> & indices) const;
@@ -205,6 +218,9 @@ public:
 
 /// dump grid on file
   virtual void writeToFile(OFile&);
+/// dump grid on a binary file (header followed by the raw arrays of values and derivatives).
+/// The file is first written with a temporary name and then renamed, so that it is replaced atomically.
+  void writeBinary(const std::string& path);
 /// dump grid to gaussian cube file
   void writeCubeFile(OFile&, const double& lunit);
 
@@ -228,23 +244,52 @@ public:
 };
 
 
+/// \ingroup TOOLBOX
+/// Grid where only the points that have been set are stored.
+/// Points are grouped in tiles (blocks of neighboring points along all the dimensions)
+/// that are allocated the first time one of their points is set. Each tile stores
+/// the values and the derivatives of its points contiguously, and tiles are found
+/// with a hash table, so that high-dimensional grids only take memory for the visited region.
 class SparseGrid : public Grid
 {
-
-  std::map<index_t,double> map_;
-  std::map< index_t,std::vector<double> > der_;
+/// A block of points, with value and derivatives stored contiguously for each point
+  struct Tile {
+    std::vector<double> data;
+    std::vector<bool> isSet;
+  };
+/// number of points of a tile along each dimension
+  std::vector<unsigned> tileBin_;
+/// number of tiles along each dimension
+  std::vector<unsigned> ntiles_;
+/// number of points in a tile
+  unsigned tileSize_;
+/// number of doubles stored for each point (value and derivatives)
+  unsigned pointSize_;
+/// number of points that have been set
+  index_t npoints_;
+  std::unordered_map<index_t,Tile> tiles_;
+/// set up the shape of the tiles
+  void setupTiles();
+/// get the tile containing a point and the position of the point in the tile
+  void getTileIndex(index_t index, index_t & tile, unsigned & local) const;
+/// get the storage of a point, allocating its tile if needed
+  double* modifyPoint(index_t index);
+/// get the storage of a point, or NULL if it has not been set
+  const double* findPoint(index_t index) const;
 
 protected:
   void clear();
+  bool isSparse() const {return true;}
+  void getSetPoints(std::vector<index_t> & points) const;
 
 public:
   SparseGrid(const std::string& funcl, const std::vector<Value*> & args, const std::vector<std::string> & gmin,
              const std::vector<std::string> & gmax,
-             const std::vector<unsigned> & nbin, bool dospline, bool usederiv):
-    Grid(funcl,args,gmin,gmax,nbin,dospline,usederiv,false) {}
+             const std::vector<unsigned> & nbin, bool dospline, bool usederiv);
 
   index_t getSize() const;
   index_t getMaxSize() const;
+  std::size_t getMemoryUsage() const;
 
 /// this is to access to Grid:: version of these methods (allowing overloading of virtual methods)
   using Grid::getValue;
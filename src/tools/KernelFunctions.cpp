@@ -355,7 +355,16 @@ double KernelFunctions::evaluate( const std::vector<Value*>& pos, std::vector<do
     }
     for(unsigned i=0; i<sinout.size(); ++i) r2+=sintmp[i]*sinout[i];
   }
-  double kderiv, kval;
+  double kderiv, kval=evaluateRadial( r2, kderiv );
+  for(unsigned i=0; i<ndim(); ++i) derivatives[i]*=kderiv;
+  if(doInt) {
+    if((pos[0]->get() <= lowI_ || pos[0]->get() >= uppI_) && usederiv ) for(unsigned i=0; i<ndim(); ++i)derivatives[i]=0;
+  }
+  return kval;
+}
+
+double KernelFunctions::evaluateRadial( const double& r2, double& kderiv ) const {
+  double kval;
   if(ktype==gaussian) {
     kval=height*std::exp(-0.5*r2); kderiv=-kval;
   } else {
@@ -376,10 +385,6 @@ double KernelFunctions::evaluate( const std::vector<Value*>& pos, std::vector<do
     }
     kderiv*=height / r ;
   }
-  for(unsigned i=0; i<ndim(); ++i) derivatives[i]*=kderiv;
-  if(doInt) {
-    if((pos[0]->get() <= lowI_ || pos[0]->get() >= uppI_) && usederiv ) for(unsigned i=0; i<ndim(); ++i)derivatives[i]=0;
-  }
   return kval;
 }
 
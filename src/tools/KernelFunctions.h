@@ -58,12 +58,17 @@ public:
   double getCutoff( const double& width ) const ;
 /// Get the position of the center
   std::vector<double> getCenter() const;
+/// Get the height of the kernel
+  double getHeight() const;
 /// Get the support
   std::vector<unsigned> getSupport( const std::vector<double>& dx ) const;
 /// get it in continuous form
   std::vector<double> getContinuousSupport( ) const;
 /// Evaluate the kernel function with constant intervals
   double evaluate( const std::vector<Value*>& pos, std::vector<double>& derivatives, bool usederiv=true, bool doInt=false, double lowI_=-1, double uppI_=-1 ) const;
+/// Evaluate the kernel function from the squared distance from its center in the metric of the kernel.
+/// The derivatives are kderiv times the metric applied to the displacement from the center.
+  double evaluateRadial( const double& r2, double& kderiv ) const;
 /// Read a kernel function from a file
   static std::unique_ptr<KernelFunctions> read( IFile* ifile, const bool& cholesky, const std::vector<std::string>& valnames );
 };
@@ -90,5 +95,10 @@ std::vector<double> KernelFunctions::getCenter() const {
   return center;
 }
 
+inline
+double KernelFunctions::getHeight() const {
+  return height;
+}
+
 }
 #endif
@@ -23,6 +23,13 @@
 
 namespace PLMD {
 
+std::size_t MultiValue::getMemoryUsage() const {
+  return sizeof(MultiValue)+hasDerivatives.getMemoryUsage()
+         +(values.capacity()+derivatives.capacity()+tmpder.capacity()+tmp_work.capacity())*sizeof(double)
+         +(indices.capacity()+sort_indices.capacity()+tmp_work_indices.capacity())*sizeof(unsigned)
+         +tmp_atoms.capacity()*sizeof(Vector);
+}
+
 MultiValue::MultiValue( const unsigned& nvals, const unsigned& nder ):
   values(nvals),
   nderivatives(nder),
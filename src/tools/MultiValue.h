@@ -47,6 +47,9 @@ private:
 /// This is a fudge to save on vector resizing in MultiColvar
   std::vector<unsigned> indices, sort_indices;
   std::vector<Vector> tmp_atoms;
+/// Scratch storage for the calculation of a task, kept to avoid allocations in every task
+  std::vector<double> tmp_work;
+  std::vector<unsigned> tmp_work_indices;
 public:
   MultiValue( const unsigned&, const unsigned& );
   void resize( const unsigned&, const unsigned& );
@@ -54,10 +57,15 @@ public:
   std::vector<unsigned>& getIndices();
   std::vector<unsigned>& getSortIndices();
   std::vector<Vector>& getAtomVector();
+/// Get scratch storage of at least the given size. The content is not preserved between tasks.
+  double* getWorkVector( const unsigned& n );
+  unsigned* getWorkIndices( const unsigned& n );
 /// Get the number of values in the stash
   unsigned getNumberOfValues() const ;
 /// Get the number of derivatives in the stash
   unsigned getNumberOfDerivatives() const ;
+/// Get the memory allocated for the stash (bytes)
+  std::size_t getMemoryUsage() const ;
 /// Set value numbered
   void setValue( const unsigned&,  const double& );
 /// Add value numbered
@@ -231,6 +239,18 @@ std::vector<Vector>& MultiValue::getAtomVector() {
   return tmp_atoms;
 }
 
+inline
+double* MultiValue::getWorkVector( const unsigned& n ) {
+  if( tmp_work.size()<n ) tmp_work.resize( n );
+  return tmp_work.data();
+}
+
+inline
+unsigned* MultiValue::getWorkIndices( const unsigned& n ) {
+  if( tmp_work_indices.size()<n ) tmp_work_indices.resize( n );
+  return tmp_work_indices.data();
+}
+
 inline
 bool MultiValue::isActive( const unsigned& ind ) const {
   return hasDerivatives.isActive( ind );
@@ -152,6 +152,11 @@ unsigned NeighborList::size() const {
   return neighbors_.size();
 }
 
+std::size_t NeighborList::getMemoryUsage() const {
+  return sizeof(NeighborList)+(fullatomlist_.capacity()+requestlist_.capacity())*sizeof(AtomNumber)
+         +neighbors_.capacity()*sizeof(std::pair<unsigned,unsigned>);
+}
+
 pair<unsigned,unsigned> NeighborList::getClosePair(unsigned i) const {
   return neighbors_[i];
 }
@@ -74,6 +74,8 @@ public:
   void setLastUpdate(unsigned step);
 /// Get the size of the neighbor list
   unsigned size() const;
+/// Get the memory allocated for the neighbor list (bytes)
+  std::size_t getMemoryUsage() const;
 /// Get the i-th pair of the neighbor list
   std::pair<unsigned,unsigned> getClosePair(unsigned i) const;
 /// Get the list of neighbors of the i-th atom
@@ -22,6 +22,8 @@
 
 #include "Stopwatch.h"
 #include "Exception.h"
+#include "OFile.h"
+#include "OpenMP.h"
 
 #include <cstdio>
 #include <iostream>
@@ -37,17 +39,23 @@ std::ostream& operator<<(std::ostream&os,const Stopwatch&sw) {
   return sw.log(os);
 }
 
+Stopwatch::Stopwatch():
+  origin(std::chrono::high_resolution_clock::now())
+{
+}
+
 void Stopwatch::Watch::start() {
   running++;
   lastStart=std::chrono::high_resolution_clock::now();
 }
 
-void Stopwatch::Watch::stop() {
+void Stopwatch::Watch::stop(bool keepLap) {
   pause();
   cycles++;
   total+=lap;
   if(lap>max)max=lap;
   if(min>lap || cycles==1)min=lap;
+  if(keepLap) laps.push_back(lap);
   lap=0;
 }
 
@@ -55,22 +63,96 @@ void Stopwatch::Watch::pause() {
   plumed_assert(running>0);
   running--;
   if(running!=0) return;
-  auto t=std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now()-lastStart);
+  lastStop=std::chrono::high_resolution_clock::now();
+  auto t=std::chrono::duration_cast<std::chrono::nanoseconds>(lastStop-lastStart);
   lap+=t.count();
 }
 
+unsigned Stopwatch::getTimerId(const std::string & name) {
+  auto it=ids.find(name);
+  if(it!=ids.end()) return it->second;
+  unsigned id=watches.size();
+  watches.emplace_back();
+  names.push_back(name);
+  ids[name]=id;
+  return id;
+}
+
+void Stopwatch::record(unsigned id) {
+// the unnamed timer is not included in the timeline
+  if(!trace || watches[id].running>0 || names[id].length()==0) return;
+  unsigned thread=OpenMP::getThreadNum();
+  plumed_dbg_assert(thread<traceEvents.size());
+  TraceEvent e;
+  e.id=id;
+  e.start=std::chrono::duration_cast<std::chrono::nanoseconds>(watches[id].lastStart-origin).count();
+  e.end=std::chrono::duration_cast<std::chrono::nanoseconds>(watches[id].lastStop-origin).count();
+  traceEvents[thread].push_back(e);
+}
+
+void Stopwatch::start(unsigned id) {
+  watches[id].start();
+}
+
+void Stopwatch::stop(unsigned id) {
+  watches[id].stop(keepLaps);
+  record(id);
+}
+
+void Stopwatch::pause(unsigned id) {
+  watches[id].pause();
+  record(id);
+}
+
 void Stopwatch::start(const std::string & name) {
-  watches[name].start();
+  start(getTimerId(name));
 }
 
 void Stopwatch::stop(const std::string & name) {
-  watches[name].stop();
+  stop(getTimerId(name));
 }
 
 void Stopwatch::pause(const std::string & name) {
-  watches[name].pause();
+  pause(getTimerId(name));
 }
 
+void Stopwatch::clearLaps() {
+  for(auto & w : watches) w.laps.clear();
+}
+
+std::vector<std::string> Stopwatch::getNames()const {
+  std::vector<std::string> sorted(names);
+  std::sort(sorted.begin(),sorted.end());
+  return sorted;
+}
+
+const std::vector<long long int> & Stopwatch::getLaps(const std::string&name)const {
+  auto it=ids.find(name);
+  plumed_massert(it!=ids.end(),"timer " + name + " not found");
+  return watches[it->second].laps;
+}
+
+void Stopwatch::setTrace(bool t) {
+  trace=t;
+  if(trace) traceEvents.resize(OpenMP::getNumThreads());
+}
+
+void Stopwatch::writeTrace(OFile&ofile,int pid) {
+  for(unsigned thread=0; thread<traceEvents.size(); thread++) {
+    for(const auto & e : traceEvents[thread]) {
+      std::string name;
+// escape characters that are not allowed in json strings
+      for(const auto c : names[e.id]) {
+        if(c=='"' || c=='\\') name+='\\';
+        name+=c;
+      }
+      ofile.printf("%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                   (traceFirst?"":",\n"),name.c_str(),pid,thread,1e-3*e.start,1e-3*(e.end-e.start));
+      traceFirst=false;
+    }
+    traceEvents[thread].clear();
+  }
+}
 
 std::ostream& Stopwatch::log(std::ostream&os)const {
   char buffer[1000];
@@ -78,14 +160,12 @@ std::ostream& Stopwatch::log(std::ostream&os)const {
   for(unsigned i=0; i<40; i++) os<<" ";
   os<<"      Cycles        Total      Average      Minumum      Maximum\n";
 
-  std::vector<std::string> names;
-  for(const auto & it : watches) names.push_back(it.first);
-  std::sort(names.begin(),names.end());
-
   const double frac=1.0/1000000000.0;
 
-  for(const auto & name : names) {
-    const Watch&t(watches.find(name)->second);
+  for(const auto & name : getNames()) {
+    const Watch&t(watches[ids.find(name)->second]);
+// timers that have been created with getTimerId() but never used are skipped
+    if(t.cycles==0) continue;
     os<<name;
     for(unsigned i=name.length(); i<40; i++) os<<" ";
     std::sprintf(buffer,"%12u %12.6f %12.6f %12.6f %12.6f\n", t.cycles, frac*t.total, frac*t.total/t.cycles, frac*t.min,frac*t.max);
@@ -24,11 +24,14 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <iosfwd>
 #include <chrono>
 
 namespace PLMD {
 
+class OFile;
+
 /**
 \ingroup TOOLBOX
 Class implementing stopwatch to time execution.
@@ -93,6 +96,28 @@ int main(){
 }
 
 \endverbatim
+When a timer is started and stopped very often, its ID can be obtained
+once with getTimerId() and used in place of its name, so as to avoid
+looking up the name at every call:
+\verbatim
+#include "Stopwatch.h"
+int main(){
+  Stopwatch sw;
+  unsigned loop=sw.getTimerId("loop");
+  for(int i=0;i<100;i++){
+    sw.start(loop);
+// do calculation
+    sw.stop(loop);
+  }
+  return 0;
+}
+\endverbatim
+Timers with different IDs can be used at the same time by different OpenMP
+threads, provided they have been created beforehand with getTimerId().
+The intervals during which named timers run can also be recorded with setTrace()
+and written with writeTrace() in the Chrome trace event format, so that they can be
+viewed as a timeline with chrome://tracing or Perfetto. Intervals are stored in
+a separate buffer for each thread, so that no lock is needed.
 
 */
 
@@ -102,28 +127,73 @@ class Stopwatch {
   class Watch {
   public:
     std::chrono::time_point<std::chrono::high_resolution_clock> lastStart;
+    std::chrono::time_point<std::chrono::high_resolution_clock> lastStop;
     long long int total = 0;
     long long int lap = 0;
     long long int max = 0;
     long long int min = 0;
     unsigned cycles = 0;
     unsigned running = 0;
+/// Duration of each cycle, only stored if requested
+    std::vector<long long int> laps;
     void start();
-    void stop();
+    void stop(bool keepLap);
     void pause();
   };
-  std::unordered_map<std::string,Watch> watches;
+/// Interval during which a timer was running, stored for the timeline
+  struct TraceEvent {
+    unsigned id;
+    long long int start;
+    long long int end;
+  };
+/// Timers, indexed by their ID
+  std::vector<Watch> watches;
+/// Names of the timers, indexed by their ID
+  std::vector<std::string> names;
+/// Map from names to IDs
+  std::unordered_map<std::string,unsigned> ids;
+  bool keepLaps=false;
+  bool trace=false;
+/// Origin of the times in the timeline
+  std::chrono::time_point<std::chrono::high_resolution_clock> origin;
+/// Intervals recorded for the timeline, one buffer per OpenMP thread
+  std::vector<std::vector<TraceEvent> > traceEvents;
+/// True if no event has been written yet by writeTrace()
+  bool traceFirst=true;
+/// Store an event in the timeline if needed
+  void record(unsigned id);
   std::ostream& log(std::ostream&)const;
 public:
+  Stopwatch();
+/// Get the ID of timer "name", creating it if it does not exist.
+/// Starting and stopping a timer using its ID avoids a lookup by name
+  unsigned getTimerId(const std::string&name);
 /// Start timer named "name"
   void start(const std::string&name);
+  void start(unsigned id);
   void start();
 /// Stop timer named "name"
   void stop(const std::string&name);
+  void stop(unsigned id);
   void stop();
 /// Pause timer named "name"
   void pause(const std::string&name);
+  void pause(unsigned id);
   void pause();
+/// Store the duration of each cycle, so that distributions can be computed
+  void setKeepLaps(bool keep) {keepLaps=keep;}
+/// Forget the durations stored so far (e.g. at the end of a warm-up)
+  void clearLaps();
+/// Get the names of all the timers, sorted
+  std::vector<std::string> getNames()const;
+/// Get the durations (in nanoseconds) of the cycles of timer "name" stored with setKeepLaps()
+  const std::vector<long long int> & getLaps(const std::string&name)const;
+/// Record the intervals during which the named timers run, so that they can be written with writeTrace()
+  void setTrace(bool);
+/// Write the intervals recorded since the last call in the Chrome trace event format
+/// and forget them. pid is used to identify the process in the timeline.
+/// Events are separated by commas, the enclosing brackets should be written by the caller.
+  void writeTrace(OFile&,int pid);
 /// Dump all timers on an ostream
   friend std::ostream& operator<<(std::ostream&,const Stopwatch&);
 };
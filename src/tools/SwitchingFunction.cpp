@@ -356,6 +356,84 @@ double SwitchingFunction::calculateSqr(double distance2,double&dfunc)const {
   }
 }
 
+template <class F>
+void SwitchingFunction::calculateBlock(const double* distance2,unsigned n,double* result,double* dfunc,F func)const {
+  for(unsigned i=0; i<n; ++i) {
+    const double distance=std::sqrt(distance2[i]);
+    const double rdist=(distance-d0)*invr0;
+    double res,df;
+    func(rdist,res,df);
+// chain rule and division by the distance as in calculate()
+    df*=invr0;
+    df/=distance;
+// the function is one below d0 and zero beyond dmax
+    const bool one=(rdist<=0.), zero=(distance>dmax);
+    res=(one ? 1. : res);
+    df=(one ? 0.0 : df);
+    result[i]=(zero ? 0.0 : res*stretch+shift);
+    dfunc[i]=(zero ? 0.0 : df*stretch);
+  }
+}
+
+void SwitchingFunction::calculateSqr(const double* distance2,unsigned n,double* result,double* dfunc)const {
+  plumed_massert(init,"you are trying to use an unset SwitchingFunction");
+  if(type==rational && nn%2==0 && mm%2==0 && d0==0.0) {
+    const int nn2=nn/2, mm2=mm/2;
+    if(2*nn2==mm2) {
+// this is the default rational function, which does not need any square root
+      for(unsigned i=0; i<n; ++i) {
+        const double rdist_2=distance2[i]*invr0_2;
+        const double rNdist=Tools::fastpow(rdist_2,nn2-1);
+        const double iden=1.0/(1+rNdist*rdist_2);
+        double df=-nn2*rNdist*iden*iden;
+        df*=2*invr0_2;
+        const bool zero=(distance2[i]>dmax_2);
+        result[i]=(zero ? 0.0 : iden*stretch+shift);
+        dfunc[i]=(zero ? 0.0 : df*stretch);
+      }
+    } else {
+      for(unsigned i=0; i<n; ++i) {
+        double df;
+        const double res=do_rational(distance2[i]*invr0_2,df,nn2,mm2);
+        df*=2*invr0_2;
+        const bool zero=(distance2[i]>dmax_2);
+        result[i]=(zero ? 0.0 : res*stretch+shift);
+        dfunc[i]=(zero ? 0.0 : df*stretch);
+      }
+    }
+  } else if(type==rational) {
+    const int rn=nn, rm=mm;
+    calculateBlock(distance2,n,result,dfunc,[this,rn,rm](double rdist,double& res,double& df) {
+      res=do_rational(rdist,df,rn,rm);
+    });
+  } else if(type==exponential) {
+    calculateBlock(distance2,n,result,dfunc,[](double rdist,double& res,double& df) {
+      res=exp(-rdist);
+      df=-res;
+    });
+  } else if(type==gaussian) {
+    calculateBlock(distance2,n,result,dfunc,[](double rdist,double& res,double& df) {
+      res=exp(-0.5*rdist*rdist);
+      df=-rdist*res;
+    });
+  } else if(type==smap) {
+    const double sa=a, sb=b, sc=c, sd=d;
+    calculateBlock(distance2,n,result,dfunc,[sa,sb,sc,sd](double rdist,double& res,double& df) {
+      double sx=sc*pow( rdist, sa );
+      res=pow( 1.0 + sx, sd );
+      df=-sb*sx/rdist*res/(1.0+sx);
+    });
+  } else if(type==cubic) {
+    calculateBlock(distance2,n,result,dfunc,[](double rdist,double& res,double& df) {
+      double tmp1=rdist-1, tmp2=(1+2*rdist);
+      res=tmp1*tmp1*tmp2;
+      df=2*tmp1*tmp2 + 2*tmp1*tmp1;
+    });
+  } else {
+    for(unsigned i=0; i<n; ++i) result[i]=calculateSqr(distance2[i],dfunc[i]);
+  }
+}
+
 double SwitchingFunction::calculate(double distance,double&dfunc)const {
   plumed_massert(init,"you are trying to use an unset SwitchingFunction");
   if(distance>dmax) {
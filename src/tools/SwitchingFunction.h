@@ -73,6 +73,10 @@ class SwitchingFunction {
 /// Low-level tool to compute rational functions.
 /// It is separated since it is called both by calculate() and calculateSqr()
   double do_rational(double rdist,double&dfunc,int nn,int mm)const;
+/// Low-level tool to compute the switching function on a block of squared distances.
+/// func computes the function and its derivative for a value of the scaled distance larger than zero
+  template <class F>
+  void calculateBlock(const double* distance2,unsigned n,double* result,double* dfunc,F func)const;
 /// Function for lepton;
   std::string lepton_func;
 /// Lepton expression.
@@ -104,6 +108,11 @@ public:
 /// The advantage is that in some case the expensive square root can be avoided
 /// (namely for rational functions, if nn and mm are even and d0 is zero)
   double calculateSqr(double distance2,double&dfunc)const;
+/// Compute the switching function for a block of n squared distances.
+/// The results and the derivatives are stored in result and dfunc.
+/// This gives the same result as calling calculateSqr() on each distance
+/// but the type of the switching function is only checked once per block.
+  void calculateSqr(const double* distance2,unsigned n,double* result,double* dfunc)const;
 /// Returns d0
   double get_d0() const;
 /// Returns r0
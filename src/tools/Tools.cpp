@@ -24,9 +24,12 @@
 #include "Exception.h"
 #include "IFile.h"
 #include "lepton/Lepton.h"
+#include <cerrno>
+#include <cstdlib>
 #include <cstring>
 #include <dirent.h>
 #include <iostream>
+#include <limits>
 #include <map>
 
 using namespace std;
@@ -48,8 +51,109 @@ static std::map<string, double> leptonConstants= {
   {"sqrt1_2", std::sqrt(0.5)}
 };
 
+// Fast numeric parsing.
+// The functions below only accept the plain forms that are by far the most
+// common in input and restart files ([+-]digits[.digits][(e|E)[+-]digits]
+// for reals, [+-]digits for integers, possibly surrounded by blanks) and
+// convert them with the strto* family, which is what the C++ streams use
+// internally, so that the result is bit-for-bit identical.
+// Anything else (including overflows and locales with a different decimal
+// point) makes them return false, and the caller falls back to the
+// original istringstream-based conversion.
+
+static inline bool isBlank(char c) {
+  return c==' ' || c=='\t' || c=='\n' || c=='\v' || c=='\f' || c=='\r';
+}
+
+static inline bool isDigit(char c) {
+  return c>='0' && c<='9';
+}
+
+/// Strip surrounding blanks. Returns false for an empty string.
+static inline bool trimBlanks(const string & str,const char* & b,const char* & e) {
+  b=str.c_str(); e=b+str.length();
+  while(b<e && isBlank(*b)) b++;
+  while(e>b && isBlank(*(e-1))) e--;
+  return b<e;
+}
+
+/// Check that [b,e) is [+-]digits, optionally refusing the minus sign
+static inline bool isPlainInteger(const char* b,const char* e,bool allowMinus) {
+  if(*b=='+' || (allowMinus && *b=='-')) b++;
+  if(b==e) return false;
+  for(; b<e; b++) if(!isDigit(*b)) return false;
+  return true;
+}
+
+/// Check that [b,e) is [+-]digits[.digits][(e|E)[+-]digits] with at least a digit in the mantissa
+static inline bool isPlainReal(const char* b,const char* e) {
+  if(*b=='+' || *b=='-') b++;
+  unsigned ndigits=0;
+  for(; b<e && isDigit(*b); b++) ndigits++;
+  if(b<e && *b=='.') for(b++; b<e && isDigit(*b); b++) ndigits++;
+  if(ndigits==0) return false;
+  if(b<e && (*b=='e' || *b=='E')) {
+    b++;
+    if(b<e && (*b=='+' || *b=='-')) b++;
+    if(b==e) return false;
+    for(; b<e; b++) if(!isDigit(*b)) return false;
+  }
+  return b==e;
+}
+
+static inline long strtoAny(const char*b,char**end,long*) {return std::strtol(b,end,10);}
+static inline unsigned long strtoAny(const char*b,char**end,unsigned long*) {return std::strtoul(b,end,10);}
+static inline float strtoAny(const char*b,char**end,float*) {return std::strtof(b,end);}
+static inline double strtoAny(const char*b,char**end,double*) {return std::strtod(b,end);}
+static inline long double strtoAny(const char*b,char**end,long double*) {return std::strtold(b,end);}
+
+/// Convert [b,e) with the strto* function for type S, requiring it to be fully consumed
+template<class S>
+static inline bool strtoRange(const char* b,const char* e,S & s) {
+  char* end;
+  int olderrno=errno;
+  errno=0;
+  s=strtoAny(b,&end,static_cast<S*>(NULL));
+  bool ok=(errno==0 && end==e);
+  errno=olderrno;
+  return ok;
+}
+
+template<class T>
+static bool fastConvertReal(const string & str,T & t) {
+  const char *b,*e;
+  if(!trimBlanks(str,b,e) || !isPlainReal(b,e)) return false;
+  return strtoRange(b,e,t);
+}
+
+static bool fastConvert(const string & str,float & t) {return fastConvertReal(str,t);}
+static bool fastConvert(const string & str,double & t) {return fastConvertReal(str,t);}
+static bool fastConvert(const string & str,long double & t) {return fastConvertReal(str,t);}
+
+static bool fastConvert(const string & str,long & t) {
+  const char *b,*e;
+  if(!trimBlanks(str,b,e) || !isPlainInteger(b,e,true)) return false;
+  return strtoRange(b,e,t);
+}
+
+static bool fastConvert(const string & str,int & t) {
+  long l;
+  if(!fastConvert(str,l) || l<std::numeric_limits<int>::min() || l>std::numeric_limits<int>::max()) return false;
+  t=l; return true;
+}
+
+static bool fastConvert(const string & str,unsigned & t) {
+  const char *b,*e;
+// a minus sign is left to the stream, which wraps it around
+  if(!trimBlanks(str,b,e) || !isPlainInteger(b,e,false)) return false;
+  unsigned long l;
+  if(!strtoRange(b,e,l) || l>std::numeric_limits<unsigned>::max()) return false;
+  t=l; return true;
+}
+
 template<class T>
 bool Tools::convertToAny(const string & str,T & t) {
+  if(fastConvert(str,t)) return true;
   istringstream istr(str.c_str());
   bool ok=static_cast<bool>(istr>>t);
   if(!ok) return false;
@@ -84,34 +188,25 @@ bool Tools::convertToReal(const string & str,T & t) {
     t=pi; return true;
   } else if(str=="-PI" || str=="-pi") {
     t=-pi; return true;
+  } else if(str=="NAN") {
+    t=NAN; return true;
+  }
+// numbers followed by PI or pi are checked before lepton, which is only used as a last resort
+  const char* pistr=NULL;
+  if(str.find("PI")!=std::string::npos) pistr="PI";
+  else if(str.find("pi")!=std::string::npos) pistr="pi";
+  if(pistr) {
+    std::size_t pi_start=str.find_first_of(pistr);
+    T ff=0.0;
+    if(str.substr(pi_start)==pistr && convertToAny(str.substr(0,pi_start),ff)) {
+      t=ff*pi; return true;
+    }
   }
   try {
     t=lepton::Parser::parse(str).evaluate(leptonConstants);
     return true;
   } catch(PLMD::lepton::Exception& exc) {
   }
-  if( str.find("PI")!=std::string::npos ) {
-    std::size_t pi_start=str.find_first_of("PI");
-    if(str.substr(pi_start)!="PI") return false;
-    istringstream nstr(str.substr(0,pi_start));
-    T ff=0.0; bool ok=static_cast<bool>(nstr>>ff);
-    if(!ok) return false;
-    t=ff*pi;
-    std::string remains; nstr>>remains;
-    return remains.length()==0;
-  } else if( str.find("pi")!=std::string::npos ) {
-    std::size_t pi_start=str.find_first_of("pi");
-    if(str.substr(pi_start)!="pi") return false;
-    istringstream nstr(str.substr(0,pi_start));
-    T ff=0.0; bool ok=static_cast<bool>(nstr>>ff);
-    if(!ok) return false;
-    t=ff*pi;
-    std::string remains; nstr>>remains;
-    return remains.length()==0;
-  } else if(str=="NAN") {
-    t=NAN;
-    return true;
-  }
   return false;
 }
 
@@ -141,6 +141,8 @@ public:
   //
   size_t getIndex(const std::vector<unsigned int>&) const;
   std::vector<unsigned int> getIndices(const size_t) const;
+  // faster version relying on a preallocated vector
+  void getIndices(const size_t, std::vector<unsigned int>&) const;
   bool indicesExist(const std::vector<unsigned int>&) const;
   //
   std::string getCoeffDescription(const size_t index) const {return coeffs_descriptions_[index];}
@@ -237,6 +239,12 @@ size_t CoeffsBase::getIndex(const std::vector<unsigned int>& indices) const {
 inline
 std::vector<unsigned int> CoeffsBase::getIndices(const size_t index) const {
   std::vector<unsigned int> indices(ndimensions_);
+  getIndices(index,indices);
+  return indices;
+}
+
+inline
+void CoeffsBase::getIndices(const size_t index, std::vector<unsigned int>& indices) const {
   size_t kk=index;
   indices[0]=(index%indices_shape_[0]);
   for(unsigned int i=1; i<ndimensions_-1; ++i) {
@@ -246,7 +254,6 @@ std::vector<unsigned int> CoeffsBase::getIndices(const size_t index) const {
   if(ndimensions_>=2) {
     indices[ndimensions_-1]=((kk-indices[ndimensions_-2])/indices_shape_[ndimensions_-2]);
   }
-  return indices;
 }
 
 
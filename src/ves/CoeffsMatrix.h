@@ -99,6 +99,8 @@ public:
   ~CoeffsMatrix();
   //
   size_t getSize() const;
+  // memory allocated for the matrix (bytes)
+  size_t getMemoryUsage() const {return sizeof(CoeffsMatrix)+data.capacity()*sizeof(double);}
   //
   bool isSymmetric() const;
   bool isDiagonal() const;
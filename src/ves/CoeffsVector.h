@@ -87,6 +87,8 @@ public:
   ~CoeffsVector();
   //
   size_t getSize() const {return numberOfCoeffs();}
+  // memory allocated for the coefficients (bytes)
+  size_t getMemoryUsage() const {return sizeof(CoeffsVector)+data.capacity()*sizeof(double);}
   // clear coeffs
   void clear();
   void setAllValuesToZero();
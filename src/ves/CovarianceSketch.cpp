@@ -0,0 +1,198 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2016-2017 The VES code team
+   (see the PEOPLE-VES file at the root of this folder for a list of names)
+
+   See http://www.ves-code.org for more information.
+
+   This file is part of VES code module.
+
+   The VES code module is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   The VES code module is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with the VES code module.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+
+#include "CovarianceSketch.h"
+
+#include "tools/Communicator.h"
+#include "tools/Exception.h"
+#include "tools/Matrix.h"
+
+#include <cmath>
+#include <algorithm>
+
+
+namespace PLMD {
+namespace ves {
+
+CovarianceSketch::CovarianceSketch(const size_t ncoeffs, const unsigned int rank, Communicator& cc):
+  ncoeffs_(ncoeffs),
+  rank_(rank),
+  mycomm(cc),
+  nlocal_(0),
+  nrows_(0),
+  norm_(0.0),
+  factor_active_(false)
+{
+  plumed_massert(rank_>0,"the rank of the covariance sketch should be larger than zero");
+  size_t stride=mycomm.Get_size();
+  size_t myrank=mycomm.Get_rank();
+  for(size_t i=myrank; i<ncoeffs_; i+=stride) nlocal_++;
+  rows_.assign(2*rank_*nlocal_,0.0);
+}
+
+
+void CovarianceSketch::shrinkRows(std::vector<double>& rows, unsigned int& nrows, const size_t ncols, const unsigned int target, Communicator* comm) {
+  if(nrows==0) return;
+  std::vector<double> g(nrows*nrows,0.0);
+  for(unsigned int a=0; a<nrows; a++) {
+    const double* ra=rows.data()+a*ncols;
+    for(unsigned int b=0; b<=a; b++) {
+      const double* rb=rows.data()+b*ncols;
+      double s=0.0;
+      for(size_t i=0; i<ncols; i++) s+=ra[i]*rb[i];
+      g[a*nrows+b]=s;
+    }
+  }
+  if(comm) comm->Sum(g);
+  Matrix<double> gram(nrows,nrows);
+  for(unsigned int a=0; a<nrows; a++) for(unsigned int b=0; b<=a; b++) {
+      gram(a,b)=g[a*nrows+b];
+      gram(b,a)=g[a*nrows+b];
+    }
+  // eigenvalues are in ascending order, eigenvectors are stored row-wise
+  std::vector<double> eigvals;
+  Matrix<double> eigvecs;
+  int info=diagMat(gram,eigvals,eigvecs);
+  plumed_massert(info==0,"diagonalization of the Gram matrix of the covariance sketch failed");
+  const unsigned int nkeep=std::min(target,nrows);
+  const double delta=(nrows>target ? std::max(eigvals[nrows-1-target],0.0) : 0.0);
+  std::vector<double> newrows(target*ncols,0.0);
+  for(unsigned int r=0; r<nkeep; r++) {
+    const unsigned int e=nrows-1-r;
+    if(eigvals[e]<=delta) continue;
+    // B' = sqrt(S^2-delta) V^T = sqrt(S^2-delta)/S U^T B
+    const double f=std::sqrt((eigvals[e]-delta)/eigvals[e]);
+    double* nr=newrows.data()+r*ncols;
+    for(unsigned int j=0; j<nrows; j++) {
+      const double u=f*eigvecs(e,j);
+      const double* rj=rows.data()+j*ncols;
+      for(size_t i=0; i<ncols; i++) nr[i]+=u*rj[i];
+    }
+  }
+  std::copy(newrows.begin(),newrows.end(),rows.begin());
+  std::fill(rows.begin()+target*ncols,rows.end(),0.0);
+  nrows=nkeep;
+}
+
+
+void CovarianceSketch::addSample(const std::vector<double>& values) {
+  plumed_dbg_assert(values.size()==ncoeffs_);
+  if(nrows_==2*rank_) shrinkRows(rows_,nrows_,nlocal_,rank_,&mycomm);
+  size_t stride=mycomm.Get_size();
+  size_t myrank=mycomm.Get_rank();
+  double* row=rows_.data()+nrows_*nlocal_;
+  for(size_t i=myrank, l=0; i<ncoeffs_; i+=stride, l++) row[l]=values[i];
+  nrows_++;
+  norm_+=1.0;
+}
+
+
+void CovarianceSketch::finalize(const std::vector<double>& averages, const double scale, Communicator* multi_sim_comm, const double walker_weight) {
+  plumed_massert(averages.size()==ncoeffs_,"wrong size of the averages passed to the covariance sketch");
+  plumed_massert(scale>=0.0,"the covariance sketch can only be scaled by a positive number");
+  if(nrows_>rank_) shrinkRows(rows_,nrows_,nlocal_,rank_,&mycomm);
+  // collect all the columns of the sketch, normalized
+  factor_.assign(rank_*ncoeffs_,0.0);
+  if(norm_>0.0) {
+    const double f=1.0/std::sqrt(norm_);
+    size_t stride=mycomm.Get_size();
+    size_t myrank=mycomm.Get_rank();
+    for(unsigned int r=0; r<nrows_; r++) {
+      for(size_t i=myrank, l=0; i<ncoeffs_; i+=stride, l++) factor_[r*ncoeffs_+i]=f*rows_[r*nlocal_+l];
+    }
+  }
+  mycomm.Sum(factor_);
+  // walkers are combined with the same weights used for the averages
+  if(multi_sim_comm) {
+    plumed_massert(walker_weight>=0.0,"the weight of the walker cannot be negative!");
+    if(mycomm.Get_rank()==0) {
+      double norm_weights=walker_weight;
+      multi_sim_comm->Sum(norm_weights);
+      const double f=(norm_weights>0.0 ? std::sqrt(walker_weight/norm_weights) : 0.0);
+      for(auto & v : factor_) v*=f;
+      unsigned int nwalkers=multi_sim_comm->Get_size();
+      std::vector<double> stacked(nwalkers*factor_.size());
+      multi_sim_comm->Allgather(factor_.data(),factor_.size(),stacked.data(),factor_.size());
+      unsigned int nstacked=nwalkers*rank_;
+      shrinkRows(stacked,nstacked,ncoeffs_,rank_,NULL);
+      std::copy(stacked.begin(),stacked.begin()+factor_.size(),factor_.begin());
+    }
+    mycomm.Bcast(factor_,0);
+  }
+  const double sqrt_scale=std::sqrt(scale);
+  for(auto & v : factor_) v*=sqrt_scale;
+  factor_mean_.resize(ncoeffs_);
+  for(size_t i=0; i<ncoeffs_; i++) factor_mean_[i]=sqrt_scale*averages[i];
+  // the diagonal of the factor, which is removed in addOffDiagonalProduct
+  factor_diagonal_.assign(ncoeffs_,0.0);
+  for(unsigned int r=0; r<rank_; r++) {
+    const double* fr=factor_.data()+r*ncoeffs_;
+    for(size_t i=0; i<ncoeffs_; i++) factor_diagonal_[i]+=fr[i]*fr[i];
+  }
+  for(size_t i=0; i<ncoeffs_; i++) factor_diagonal_[i]-=factor_mean_[i]*factor_mean_[i];
+  factor_active_=true;
+  // restart sampling
+  std::fill(rows_.begin(),rows_.end(),0.0);
+  nrows_=0;
+  norm_=0.0;
+}
+
+
+void CovarianceSketch::clear() {
+  std::fill(rows_.begin(),rows_.end(),0.0);
+  nrows_=0;
+  norm_=0.0;
+  factor_.clear();
+  factor_mean_.clear();
+  factor_diagonal_.clear();
+  factor_active_=false;
+}
+
+
+void CovarianceSketch::addOffDiagonalProduct(const std::vector<double>& x, std::vector<double>& y) const {
+  plumed_massert(x.size()==ncoeffs_ && y.size()==ncoeffs_,"wrong size of the vectors multiplied by the covariance sketch");
+  if(!factor_active_) return;
+  // y += F^T F x - m m^T x - diag(F^T F - m m^T) x
+  std::vector<double> fx(rank_,0.0);
+  for(unsigned int r=0; r<rank_; r++) {
+    const double* fr=factor_.data()+r*ncoeffs_;
+    double s=0.0;
+    for(size_t i=0; i<ncoeffs_; i++) s+=fr[i]*x[i];
+    fx[r]=s;
+  }
+  double mx=0.0;
+  for(size_t i=0; i<ncoeffs_; i++) mx+=factor_mean_[i]*x[i];
+  for(size_t i=0; i<ncoeffs_; i++) y[i]+=-factor_mean_[i]*mx-factor_diagonal_[i]*x[i];
+  for(unsigned int r=0; r<rank_; r++) {
+    const double* fr=factor_.data()+r*ncoeffs_;
+    const double s=fx[r];
+    for(size_t i=0; i<ncoeffs_; i++) y[i]+=s*fr[i];
+  }
+}
+
+
+size_t CovarianceSketch::getMemoryUsage() const {
+  return sizeof(CovarianceSketch)+(rows_.capacity()+factor_.capacity()+factor_mean_.capacity()+factor_diagonal_.capacity())*sizeof(double);
+}
+
+}
+}
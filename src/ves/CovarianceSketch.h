@@ -0,0 +1,89 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2016-2017 The VES code team
+   (see the PEOPLE-VES file at the root of this folder for a list of names)
+
+   See http://www.ves-code.org for more information.
+
+   This file is part of VES code module.
+
+   The VES code module is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   The VES code module is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with the VES code module.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_ves_CovarianceSketch_h
+#define __PLUMED_ves_CovarianceSketch_h
+
+#include <vector>
+#include <cstddef>
+
+
+namespace PLMD {
+
+class Communicator;
+
+namespace ves {
+
+/*
+Streaming low-rank estimate of the covariance of a set of coefficient derivatives.
+
+The second moment of the samples is approximated by \f$B^T B\f$, where the sketch
+\f$B\f$ has twice the requested rank rows and is updated with the frequent directions
+algorithm (Liberty, KDD 2013): samples are appended as new rows and, when all rows
+are used, the sketch is rotated onto its principal directions and shrunk to the
+requested rank. Memory and cost per sample are thus linear in the number of coefficients.
+The columns of the sketch are split among the processes of the communicator, and only
+the small Gram matrix of the sketch is summed over them.
+*/
+
+class CovarianceSketch {
+private:
+  size_t ncoeffs_;
+  unsigned int rank_;
+  Communicator& mycomm;
+/// Number of columns stored by this process (columns mycomm.Get_rank()+i*mycomm.Get_size())
+  size_t nlocal_;
+/// Rows of the sketch, nlocal_ columns each
+  std::vector<double> rows_;
+  unsigned int nrows_;
+/// Normalization of the second moment (number of samples)
+  double norm_;
+/// Low-rank factor of the last covariance, as computed by finalize()
+  std::vector<double> factor_;
+  std::vector<double> factor_mean_;
+  std::vector<double> factor_diagonal_;
+  bool factor_active_;
+/// Rotate the first nrows rows of a block with ncols columns onto their principal directions and keep the first target ones.
+/// If comm is not NULL, the columns of the block are distributed over its processes.
+  static void shrinkRows(std::vector<double>& rows, unsigned int& nrows, const size_t ncols, const unsigned int target, Communicator* comm);
+public:
+  CovarianceSketch(const size_t ncoeffs, const unsigned int rank, Communicator& cc);
+  unsigned int getRank() const {return rank_;}
+  size_t numberOfCoeffs() const {return ncoeffs_;}
+/// Add a sample, values contains all the coefficients derivatives
+  void addSample(const std::vector<double>& values);
+/// Number of samples added since the last call to finalize()
+  double getNorm() const {return norm_;}
+/// Compute the low-rank factor of scale*(<x x^T>-<x><x>^T) from the samples and the averages of x, and restart sampling.
+/// If multi_sim_comm is not NULL, the sketches of the walkers are combined with the given weight.
+  void finalize(const std::vector<double>& averages, const double scale, Communicator* multi_sim_comm=NULL, const double walker_weight=1.0);
+/// Forget the samples and the factor
+  void clear();
+/// Add to y the product of the off-diagonal part of the last covariance with x
+  void addOffDiagonalProduct(const std::vector<double>& x, std::vector<double>& y) const;
+/// Memory allocated by the sketch (bytes)
+  size_t getMemoryUsage() const;
+};
+
+}
+}
+
+#endif
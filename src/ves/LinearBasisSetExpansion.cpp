@@ -32,6 +32,7 @@
 #include "tools/Keywords.h"
 #include "tools/Grid.h"
 #include "tools/Communicator.h"
+#include "tools/OpenMP.h"
 
 #include "GridProjWeights.h"
 
@@ -119,6 +120,16 @@ LinearBasisSetExpansion::~LinearBasisSetExpansion() {
 }
 
 
+size_t LinearBasisSetExpansion::getMemoryUsage() const {
+  size_t m=0;
+  if(targetdist_averages_pntr_!=NULL) {m+=targetdist_averages_pntr_->getMemoryUsage();}
+  if(bias_grid_pntr_!=NULL) {m+=bias_grid_pntr_->getMemoryUsage();}
+  if(bias_withoutcutoff_grid_pntr_!=NULL) {m+=bias_withoutcutoff_grid_pntr_->getMemoryUsage();}
+  if(fes_grid_pntr_!=NULL) {m+=fes_grid_pntr_->getMemoryUsage();}
+  return m;
+}
+
+
 bool LinearBasisSetExpansion::isStaticTargetDistFileOutputActive() const {
   bool output_static_targetdist_files=true;
   if(vesbias_pntr_!=NULL) {
@@ -186,16 +197,108 @@ void LinearBasisSetExpansion::setupFesProjGrid() {
 }
 
 
+// Contract the axis k of a tensor (flattened in column-major order, with shape dims)
+// with a matrix of size rows x dims[k] (row-major). On exit dims[k] is equal to rows.
+static void contractTensorAxis(const std::vector<double>& in, std::vector<unsigned int>& dims, const unsigned int k, const std::vector<double>& matrix, const unsigned int rows, std::vector<double>& out) {
+  size_t inner=1;
+  for(unsigned int i=0; i<k; i++) {inner*=dims[i];}
+  size_t outer=1;
+  for(unsigned int i=k+1; i<dims.size(); i++) {outer*=dims[i];}
+  const unsigned int n=dims[k];
+  out.assign(inner*rows*outer,0.0);
+  #pragma omp parallel for num_threads(OpenMP::getGoodNumThreads(out))
+  for(size_t l=0; l<outer*rows; l++) {
+    const size_t o=l/rows;
+    const size_t r=l%rows;
+    double* dst=&out[l*inner];
+    for(unsigned int j=0; j<n; j++) {
+      const double w=matrix[r*n+j];
+      const double* src=&in[(o*n+j)*inner];
+      for(size_t i=0; i<inner; i++) {dst[i]+=w*src[i];}
+    }
+  }
+  dims[k]=rows;
+}
+
+
+void LinearBasisSetExpansion::getBasisFunctionTablesOnGrid(const Grid* grid_pntr, std::vector<std::vector<double> >& bf_values, std::vector<std::vector<double> >& bf_derivs) const {
+  // the table of dimension k has size gridbins[k] x nbasisf[k]
+  plumed_massert(grid_pntr->getDimension()==nargs_,"the grid should have one dimension for each argument");
+  std::vector<unsigned int> grid_nbins = grid_pntr->getNbin();
+  bf_values.resize(nargs_);
+  bf_derivs.resize(nargs_);
+  for(unsigned int k=0; k<nargs_; k++) {
+    const unsigned int nbf=nbasisf_[k];
+    bf_values[k].resize(grid_nbins[k]*nbf);
+    bf_derivs[k].resize(grid_nbins[k]*nbf);
+    std::vector<unsigned int> indices(nargs_,0);
+    std::vector<double> tmp_val(nbf);
+    std::vector<double> tmp_der(nbf);
+    for(unsigned int i=0; i<grid_nbins[k]; i++) {
+      indices[k]=i;
+      double arg=grid_pntr->getPoint(indices)[k];
+      double arg_trsfrm;
+      bool inside=true;
+      basisf_pntrs_[k]->getAllValues(arg,arg_trsfrm,inside,tmp_val,tmp_der);
+      for(unsigned int j=0; j<nbf; j++) {
+        bf_values[k][i*nbf+j]=tmp_val[j];
+        bf_derivs[k][i*nbf+j]=tmp_der[j];
+      }
+    }
+  }
+}
+
+
+void LinearBasisSetExpansion::getBiasAndForcesOnGrid(const Grid* grid_pntr, std::vector<double>& bias_values, std::vector<std::vector<double> >& forces_values, const bool useforces) const {
+  // As the expansion is a sum of products of one-dimensional basis functions,
+  // the basis functions are tabulated along each axis of the grid and the
+  // coefficients are contracted one dimension at a time. This costs
+  // O(gridpoints x nbasisf) instead of O(gridpoints x ncoeffs).
+  std::vector<unsigned int> grid_nbins = grid_pntr->getNbin();
+  std::vector<std::vector<double> > bf_values;
+  std::vector<std::vector<double> > bf_derivs;
+  getBasisFunctionTablesOnGrid(grid_pntr,bf_values,bf_derivs);
+  //
+  std::vector<double> coeffs=bias_coeffs_pntr_->getDataAsVector();
+  std::vector<double> tmp1;
+  std::vector<double> tmp2;
+  // derivative_dim=nargs_ gives the bias, otherwise the derivative along that dimension
+  for(unsigned int derivative_dim=0; derivative_dim<=nargs_; derivative_dim++) {
+    if(derivative_dim<nargs_ && !useforces) {continue;}
+    std::vector<unsigned int> dims=nbasisf_;
+    tmp1=coeffs;
+    for(unsigned int k=0; k<nargs_; k++) {
+      const std::vector<double>& matrix = (k==derivative_dim ? bf_derivs[k] : bf_values[k]);
+      contractTensorAxis(tmp1,dims,k,matrix,grid_nbins[k],tmp2);
+      tmp1.swap(tmp2);
+    }
+    if(derivative_dim==nargs_) {
+      bias_values.swap(tmp1);
+    }
+    else {
+      forces_values[derivative_dim].swap(tmp1);
+      for(size_t l=0; l<forces_values[derivative_dim].size(); l++) {
+        forces_values[derivative_dim][l]=-forces_values[derivative_dim][l];
+      }
+    }
+  }
+}
+
+
 void LinearBasisSetExpansion::updateBiasGrid() {
   plumed_massert(bias_grid_pntr_!=NULL,"the bias grid is not defined");
   if(action_pntr_!=NULL &&  getStepOfLastBiasGridUpdate()==action_pntr_->getStep()) {
     return;
   }
+  std::vector<double> bias_values;
+  std::vector<std::vector<double> > forces_values(nargs_);
+  getBiasAndForcesOnGrid(bias_grid_pntr_,bias_values,forces_values,bias_grid_pntr_->hasDerivatives() || biasCutoffActive());
   for(Grid::index_t l=0; l<bias_grid_pntr_->getSize(); l++) {
-    std::vector<double> forces(nargs_);
-    std::vector<double> args = bias_grid_pntr_->getPoint(l);
-    bool all_inside=true;
-    double bias=getBiasAndForces(args,all_inside,forces);
+    std::vector<double> forces(nargs_,0.0);
+    double bias=bias_values[l];
+    if(!forces_values[0].empty()) {
+      for(unsigned int k=0; k<nargs_; k++) {forces[k]=forces_values[k][l];}
+    }
     //
     if(biasCutoffActive()) {
       vesbias_pntr_->applyBiasCutoff(bias,forces);
@@ -226,12 +329,14 @@ void LinearBasisSetExpansion::updateBiasWithoutCutoffGrid() {
     return;
   }
   //
+  std::vector<double> bias_values;
+  std::vector<std::vector<double> > forces_values(nargs_);
+  getBiasAndForcesOnGrid(bias_withoutcutoff_grid_pntr_,bias_values,forces_values,bias_withoutcutoff_grid_pntr_->hasDerivatives());
   for(Grid::index_t l=0; l<bias_withoutcutoff_grid_pntr_->getSize(); l++) {
-    std::vector<double> forces(nargs_);
-    std::vector<double> args = bias_withoutcutoff_grid_pntr_->getPoint(l);
-    bool all_inside=true;
-    double bias=getBiasAndForces(args,all_inside,forces);
+    std::vector<double> forces(nargs_,0.0);
+    double bias=bias_values[l];
     if(bias_withoutcutoff_grid_pntr_->hasDerivatives()) {
+      for(unsigned int k=0; k<nargs_; k++) {forces[k]=forces_values[k][l];}
       bias_withoutcutoff_grid_pntr_->setValueAndDerivatives(l,bias,forces);
     }
     else {
@@ -400,8 +505,9 @@ double LinearBasisSetExpansion::getBiasAndForces(const std::vector<double>& args
   }
   // loop over coeffs
   double bias=0.0;
+  std::vector<unsigned int> indices(nargs);
   for(size_t i=rank; i<coeffs_pntr_in->numberOfCoeffs(); i+=stride) {
-    std::vector<unsigned int> indices=coeffs_pntr_in->getIndices(i);
+    coeffs_pntr_in->getIndices(i,indices);
     double coeff = coeffs_pntr_in->getValue(i);
     double bf_curr=1.0;
     for(unsigned int k=0; k<nargs; k++) {
@@ -453,8 +559,9 @@ void LinearBasisSetExpansion::getBasisSetValues(const std::vector<double>& args_
     rank=comm_in->Get_rank();
   }
   // loop over basis set
+  std::vector<unsigned int> indices(nargs);
   for(size_t i=rank; i<coeffs_pntr_in->numberOfCoeffs(); i+=stride) {
-    std::vector<unsigned int> indices=coeffs_pntr_in->getIndices(i);
+    coeffs_pntr_in->getIndices(i,indices);
     double bf_curr=1.0;
     for(unsigned int k=0; k<nargs; k++) {
       bf_curr*=bf_values[k][indices[k]];
@@ -544,20 +651,28 @@ void LinearBasisSetExpansion::restartTargetDistribution() {
 
 void LinearBasisSetExpansion::calculateTargetDistAveragesFromGrid(const Grid* targetdist_grid_pntr) {
   plumed_assert(targetdist_grid_pntr!=NULL);
-  std::vector<double> targetdist_averages(ncoeffs_,0.0);
   std::vector<double> integration_weights = GridIntegrationWeights::getIntegrationWeights(targetdist_grid_pntr);
-  Grid::index_t stride=mycomm_.Get_size();
-  Grid::index_t rank=mycomm_.Get_rank();
-  for(Grid::index_t l=rank; l<targetdist_grid_pntr->getSize(); l+=stride) {
-    std::vector<double> args_values = targetdist_grid_pntr->getPoint(l);
-    std::vector<double> basisset_values(ncoeffs_);
-    getBasisSetValues(args_values,basisset_values,false);
-    double weight = integration_weights[l]*targetdist_grid_pntr->getValue(l);
-    for(unsigned int i=0; i<ncoeffs_; i++) {
-      targetdist_averages[i] += weight*basisset_values[i];
+  std::vector<double> targetdist_averages(targetdist_grid_pntr->getSize());
+  for(Grid::index_t l=0; l<targetdist_grid_pntr->getSize(); l++) {
+    targetdist_averages[l] = integration_weights[l]*targetdist_grid_pntr->getValue(l);
+  }
+  // the weighted grid is contracted with the transposed tables of the basis functions,
+  // one dimension at a time (see getBiasAndForcesOnGrid)
+  std::vector<std::vector<double> > bf_values;
+  std::vector<std::vector<double> > bf_derivs;
+  getBasisFunctionTablesOnGrid(targetdist_grid_pntr,bf_values,bf_derivs);
+  std::vector<unsigned int> dims = targetdist_grid_pntr->getNbin();
+  std::vector<double> matrix;
+  std::vector<double> tmp;
+  for(unsigned int k=0; k<nargs_; k++) {
+    const unsigned int nbf=nbasisf_[k];
+    matrix.resize(nbf*dims[k]);
+    for(unsigned int i=0; i<dims[k]; i++) {
+      for(unsigned int j=0; j<nbf; j++) {matrix[j*dims[k]+i]=bf_values[k][i*nbf+j];}
     }
+    contractTensorAxis(targetdist_averages,dims,k,matrix,nbf,tmp);
+    targetdist_averages.swap(tmp);
   }
-  mycomm_.Sum(targetdist_averages);
   // the overall constant;
   targetdist_averages[0] = 1.0;
   TargetDistAverages() = targetdist_averages;
@@ -99,6 +99,8 @@ private:
   explicit LinearBasisSetExpansion(const LinearBasisSetExpansion&);
 public:
   ~LinearBasisSetExpansion();
+  // memory allocated for the grids owned by the expansion (bytes)
+  size_t getMemoryUsage() const;
   //
   std::vector<Value*> getPntrsToArguments() const {return args_pntrs_;}
   std::vector<BasisFunctions*> getPntrsToBasisFunctions() const {return basisf_pntrs_;}
@@ -180,6 +182,10 @@ public:
 private:
   //
   Grid* setupGeneralGrid(const std::string&, const bool usederiv=false);
+  // values and derivatives of the basis functions along each axis of a grid
+  void getBasisFunctionTablesOnGrid(const Grid*, std::vector<std::vector<double> >&, std::vector<std::vector<double> >&) const;
+  // bias and forces on all the points of a grid, computed with a separable contraction
+  void getBiasAndForcesOnGrid(const Grid*, std::vector<double>&, std::vector<std::vector<double> >&, const bool useforces=true) const;
   //
   void calculateTargetDistAveragesFromGrid(const Grid*);
   //
@@ -53,7 +53,10 @@ where \f$\mu\f$ is a fixed step size and the gradient \f$ \nabla\Omega(\bar{\bol
 \f]
 This means that the bias acting on the system depends on the averaged coefficients \f$\bar{\boldsymbol{\alpha}}^{(n)}\f$ which leads to a smooth convergence of the bias and the estimated free energy surface. Furthermore, this allows for a rather short sampling time for each iteration, for classical MD simulations typical sampling times are on the order of few ps (around 1000-4000 MD steps).
 
-Currently it is only supported to employ the diagonal part of the Hessian which is generally sufficient. Support for employing the full Hessian will be added later on.
+By default only the diagonal part of the Hessian is employed, which is generally sufficient. The off-diagonal part can be included with the HESSIAN_RANK keyword:
+it is then approximated by a low-rank estimate of the given rank, obtained with the frequent directions algorithm \cite Liberty-KDD-2013
+applied to the sampled coefficient derivatives. As memory and cost per step scale as the rank times the number of coefficients,
+this can also be used for expansions with many thousands of coefficients, where the full Hessian would be too expensive.
 
 The VES bias that is to be optimized should be specified using the
 BIAS keyword.
@@ -288,13 +291,13 @@ Opt_BachAveragedSGD::Opt_BachAveragedSGD(const ActionOptions&ao):
 void Opt_BachAveragedSGD::coeffsUpdate(const unsigned int c_id) {
   //
   if(combinedgradientOFiles_.size()>0 && (getIterationCounter()+1)%combinedgradient_wstride_==0) {
-    CombinedGradient(c_id).setValues( ( Gradient(c_id) + Hessian(c_id)*(AuxCoeffs(c_id)-Coeffs(c_id)) ) );
+    CombinedGradient(c_id).setValues( ( Gradient(c_id) + HessianTimes(AuxCoeffs(c_id)-Coeffs(c_id),c_id) ) );
     combinedgradient_pntrs_[c_id]->setIterationCounterAndTime(getIterationCounter()+1,getTime());
     combinedgradient_pntrs_[c_id]->writeToFile(*combinedgradientOFiles_[c_id]);
   }
   //
   double aver_decay = getAverDecay();
-  AuxCoeffs(c_id) += - StepSize(c_id)*CoeffsMask(c_id) * ( Gradient(c_id) + Hessian(c_id)*(AuxCoeffs(c_id)-Coeffs(c_id)) );
+  AuxCoeffs(c_id) += - StepSize(c_id)*CoeffsMask(c_id) * ( Gradient(c_id) + HessianTimes(AuxCoeffs(c_id)-Coeffs(c_id),c_id) );
   //AuxCoeffs() = AuxCoeffs() - StepSize() * ( Gradient() + Hessian()*(AuxCoeffs()-Coeffs()) );
   Coeffs(c_id) += aver_decay * ( AuxCoeffs(c_id)-Coeffs(c_id) );
 }
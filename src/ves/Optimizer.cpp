@@ -23,6 +23,7 @@
 #include "Optimizer.h"
 #include "CoeffsVector.h"
 #include "CoeffsMatrix.h"
+#include "CovarianceSketch.h"
 #include "VesBias.h"
 #include "VesTools.h"
 
@@ -48,6 +49,7 @@ Optimizer::Optimizer(const ActionOptions&ao):
   iter_counter(0),
   use_hessian_(false),
   diagonal_hessian_(true),
+  hessian_rank_(0),
   use_mwalkers_mpi_(false),
   mwalkers_mpi_single_files_(true),
   dynamic_targetdists_(0),
@@ -94,6 +96,14 @@ Optimizer::Optimizer(const ActionOptions&ao):
   plumed_massert(bias_labels.size()>0,"problem with BIAS keyword");
   nbiases_ = bias_labels.size();
   //
+  addMemoryUsage("coefficients",[this]() {
+    size_t m=0;
+    for(const auto & c : aux_coeffs_pntrs_) m+=c->getMemoryUsage();
+    for(const auto & c : aver_gradient_pntrs_) m+=c->getMemoryUsage();
+    for(const auto & c : coeffs_mask_pntrs_) m+=c->getMemoryUsage();
+    return m;
+  });
+  //
   std::string error_msg = "";
   bias_pntrs_ = VesTools::getPointersFromLabels<VesBias*>(bias_labels,plumed.getActionSet(),error_msg);
   if(error_msg.size()>0) {plumed_merror("Error in keyword BIAS of "+getName()+": "+error_msg);}
@@ -198,6 +208,12 @@ Optimizer::Optimizer(const ActionOptions&ao):
     parseFlag("FULL_HESSIAN",full_hessian);
     diagonal_hessian_ = !full_hessian;
   }
+  if(keywords.exists("HESSIAN_RANK")) {
+    parse("HESSIAN_RANK",hessian_rank_);
+    if(hessian_rank_>0 && !diagonal_hessian_) {
+      plumed_merror(getName()+": HESSIAN_RANK cannot be used together with FULL_HESSIAN");
+    }
+  }
   //
   bool mw_single_files = false;
   if(keywords.exists("MULTIPLE_WALKERS")) {
@@ -826,6 +842,7 @@ void Optimizer::registerKeywords( Keywords& keys ) {
   keys.reserve("compulsory","INITIAL_STEPSIZE","the initial step size used for the optimization");
   // Keywords related to the Hessian, actived with the useHessianKeywords function
   keys.reserveFlag("FULL_HESSIAN",false,"if the full Hessian matrix should be used for the optimization, otherwise only the diagonal part of the Hessian is used");
+  keys.reserve("optional","HESSIAN_RANK","approximate the off-diagonal part of the Hessian with a low-rank estimate of the given rank, obtained with a streaming sketch of the sampled coefficient derivatives. Memory and cost per step scale as the rank times the number of coefficients. By default only the diagonal part of the Hessian is used");
   keys.reserve("hidden","HESSIAN_FILE","the name of output file for the Hessian");
   keys.reserve("hidden","HESSIAN_OUTPUT","how often the Hessian should be written to file. This parameter is given as the number of bias iterations. It is by default 100 if HESSIAN_FILE is specficed");
   keys.reserve("hidden","HESSIAN_FMT","specify format for hessian file(s) (useful for decrease the number of digits in regtests)");
@@ -869,6 +886,7 @@ void Optimizer::registerKeywords( Keywords& keys ) {
 
 void Optimizer::useHessianKeywords(Keywords& keys) {
   // keys.use("FULL_HESSIAN");
+  keys.use("HESSIAN_RANK");
   keys.use("HESSIAN_FILE");
   keys.use("HESSIAN_OUTPUT");
   keys.use("HESSIAN_FMT");
@@ -924,16 +942,23 @@ void Optimizer::turnOnHessian() {
   plumed_massert(hessian_pntrs_.size()==0,"turnOnHessian() should only be run during initialization");
   use_hessian_=true;
   hessian_pntrs_.clear();
+  hessian_sketch_pntrs_.clear();
   for(unsigned int i=0; i<nbiases_; i++) {
-    std::vector<CoeffsMatrix*> pntrs_hessian = enableHessian(bias_pntrs_[i],diagonal_hessian_);
+    std::vector<CoeffsMatrix*> pntrs_hessian = enableHessian(bias_pntrs_[i],diagonal_hessian_,hessian_rank_);
     for(unsigned int k=0; k<pntrs_hessian.size(); k++) {
       pntrs_hessian[k]->turnOnIterationCounter();
       pntrs_hessian[k]->setIterationCounterAndTime(getIterationCounter(),getTime());
       hessian_pntrs_.push_back(pntrs_hessian[k]);
+      hessian_sketch_pntrs_.push_back(bias_pntrs_[i]->getHessianSketchPntr(k));
     }
   }
   plumed_massert(hessian_pntrs_.size()==ncoeffssets_,"problems in linking Hessians");
-  if(diagonal_hessian_) {
+  if(hessian_rank_>0) {
+    log.printf("  Optimization performed using diagonal Hessian matrix with a rank %u estimate of the off-diagonal part, see and cite ",hessian_rank_);
+    log << plumed.cite("Liberty, Proceedings of the 19th ACM SIGKDD, 581-588 (2013)");
+    log.printf("\n");
+  }
+  else if(diagonal_hessian_) {
     log.printf("  Optimization performed using diagonal Hessian matrix\n");
   }
   else {
@@ -951,6 +976,8 @@ void Optimizer::turnOnHessian() {
 
 void Optimizer::turnOffHessian() {
   use_hessian_=false;
+  hessian_rank_=0;
+  hessian_sketch_pntrs_.clear();
   for(unsigned int i=0; i<nbiases_; i++) {
     bias_pntrs_[i]->disableHessian();
   }
@@ -963,9 +990,9 @@ void Optimizer::turnOffHessian() {
 }
 
 
-std::vector<CoeffsMatrix*> Optimizer::enableHessian(VesBias* bias_pntr_in, const bool diagonal_hessian) {
+std::vector<CoeffsMatrix*> Optimizer::enableHessian(VesBias* bias_pntr_in, const bool diagonal_hessian, const unsigned int hessian_rank) {
   plumed_massert(use_hessian_,"the Hessian should not be used");
-  bias_pntr_in->enableHessian(diagonal_hessian);
+  bias_pntr_in->enableHessian(diagonal_hessian,hessian_rank);
   std::vector<CoeffsMatrix*> hessian_pntrs_out = bias_pntr_in->getHessianPntrs();
   for(unsigned int k=0; k<hessian_pntrs_out.size(); k++) {
     plumed_massert(hessian_pntrs_out[k] != NULL,"Hessian is needed but not linked correctly");
@@ -974,6 +1001,17 @@ std::vector<CoeffsMatrix*> Optimizer::enableHessian(VesBias* bias_pntr_in, const
 }
 
 
+CoeffsVector Optimizer::HessianTimes(const CoeffsVector& coeffsvector, const unsigned int coeffs_id) const {
+  CoeffsVector product = Hessian(coeffs_id)*coeffsvector;
+  if(hessian_rank_>0) {
+    std::vector<double> values = product.getDataAsVector();
+    hessian_sketch_pntrs_[coeffs_id]->addOffDiagonalProduct(coeffsvector.getDataAsVector(),values);
+    product.setValues(values);
+  }
+  return product;
+}
+
+
 // CoeffsMatrix* Optimizer::switchToDiagonalHessian(VesBias* bias_pntr_in) {
 //   plumed_massert(use_hessian_,"it does not make sense to switch to diagonal Hessian if it Hessian is not used");
 //   diagonal_hessian_=true;
@@ -65,6 +65,7 @@ private:
   //
   bool use_hessian_;
   bool diagonal_hessian_;
+  unsigned int hessian_rank_;
   bool hessian_covariance_from_averages_;
   //
   bool use_mwalkers_mpi_;
@@ -102,6 +103,7 @@ private:
   std::vector<CoeffsVector*> gradient_pntrs_;
   std::vector<CoeffsVector*> aver_gradient_pntrs_;
   std::vector<CoeffsMatrix*> hessian_pntrs_;
+  std::vector<CovarianceSketch*> hessian_sketch_pntrs_;
   std::vector<CoeffsVector*> coeffs_mask_pntrs_;
   std::vector<CoeffsVector*> targetdist_averages_pntrs_;
   //
@@ -128,7 +130,7 @@ private:
 protected:
   void turnOnHessian();
   void turnOffHessian();
-  std::vector<CoeffsMatrix*> enableHessian(VesBias*, const bool diagonal_hessian=false);
+  std::vector<CoeffsMatrix*> enableHessian(VesBias*, const bool diagonal_hessian=false, const unsigned int hessian_rank=0);
   // CoeffsMatrix* switchToDiagonalHessian(VesBias*);
   // CoeffsMatrix* switchToFullHessian(VesBias*);
   //
@@ -136,6 +138,8 @@ protected:
   CoeffsVector& AuxCoeffs(const unsigned int coeffs_id = 0) const;
   CoeffsVector& Gradient(const unsigned int coeffs_id = 0) const;
   CoeffsMatrix& Hessian(const unsigned int coeffs_id = 0) const;
+  // product of the Hessian with a vector, including its low-rank off-diagonal part if used
+  CoeffsVector HessianTimes(const CoeffsVector&, const unsigned int coeffs_id = 0) const;
   CoeffsVector& CoeffsMask(const unsigned int coeffs_id = 0) const;
   CoeffsVector& TargetDistAverages(const unsigned int coeffs_id = 0) const;
   double StepSize(const unsigned int coeffs_id = 0) const;
@@ -196,6 +200,7 @@ public:
   //
   bool useHessian() const {return use_hessian_;}
   bool diagonalHessian() const {return diagonal_hessian_;}
+  unsigned int getHessianRank() const {return hessian_rank_;}
   //
   bool useMultipleWalkers() const {return use_mwalkers_mpi_;}
   //
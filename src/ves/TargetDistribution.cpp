@@ -70,6 +70,12 @@ TargetDistribution::TargetDistribution(const ActionOptions&ao):
   allow_bias_cutoff_(true),
   bias_cutoff_active_(false)
 {
+  addMemoryUsage("target distribution grids",[this]() {
+    size_t m=0;
+    if(targetdist_grid_pntr_!=NULL) {m+=targetdist_grid_pntr_->getMemoryUsage();}
+    if(log_targetdist_grid_pntr_!=NULL) {m+=log_targetdist_grid_pntr_->getMemoryUsage();}
+    return m;
+  });
   //
   if(keywords.exists("WELLTEMPERED_FACTOR")) {
     double welltempered_factor=0.0;
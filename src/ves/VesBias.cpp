@@ -24,6 +24,7 @@
 #include "BasisFunctions.h"
 #include "CoeffsVector.h"
 #include "CoeffsMatrix.h"
+#include "CovarianceSketch.h"
 #include "Optimizer.h"
 #include "FermiSwitchingFunction.h"
 #include "VesTools.h"
@@ -56,6 +57,7 @@ VesBias::VesBias(const ActionOptions&ao):
   optimize_coeffs_(false),
   compute_hessian_(false),
   diagonal_hessian_(true),
+  hessian_rank_(0),
   aver_counters(0),
   kbt_(0.0),
   targetdist_pntrs_(0),
@@ -83,6 +85,16 @@ VesBias::VesBias(const ActionOptions&ao):
   bias_cutoff_swfunc_pntr_(NULL),
   calc_reweightfactor_(false)
 {
+  addMemoryUsage("coefficients",[this]() {
+    size_t m=0;
+    for(const auto & c : coeffs_pntrs_) m+=c->getMemoryUsage();
+    for(const auto & c : targetdist_averages_pntrs_) m+=c->getMemoryUsage();
+    for(const auto & c : gradient_pntrs_) m+=c->getMemoryUsage();
+    for(const auto & c : hessian_pntrs_) m+=c->getMemoryUsage();
+    for(const auto & c : hessian_sketch_pntrs_) m+=c->getMemoryUsage();
+    return m;
+  });
+  //
   log.printf("  VES bias, please read and cite ");
   log << plumed.cite("Valsson and Parrinello, Phys. Rev. Lett. 113, 090601 (2014)");
   log.printf("\n");
@@ -242,6 +254,9 @@ VesBias::~VesBias() {
   for(unsigned int i=0; i<hessian_pntrs_.size(); i++) {
     delete hessian_pntrs_[i];
   }
+  for(unsigned int i=0; i<hessian_sketch_pntrs_.size(); i++) {
+    delete hessian_sketch_pntrs_[i];
+  }
   if(bias_cutoff_swfunc_pntr_!=NULL) {
     delete bias_cutoff_swfunc_pntr_;
   }
@@ -423,10 +438,11 @@ bool VesBias::readCoeffsFromFiles() {
 void VesBias::updateGradientAndHessian(const bool use_mwalkers_mpi) {
   for(unsigned int k=0; k<ncoeffssets_; k++) {
     //
-    comm.Sum(sampled_averages[k]);
-    comm.Sum(sampled_cross_averages[k]);
+    comm.DeferSum(sampled_averages[k]);
+    comm.DeferSum(sampled_cross_averages[k]);
+    comm.SumDeferred();
+    double walker_weight=1.0;
     if(use_mwalkers_mpi) {
-      double walker_weight=1.0;
       if(aver_counters[k]==0) {walker_weight=0.0;}
       multiSimSumAverages(k,walker_weight);
     }
@@ -434,6 +450,9 @@ void VesBias::updateGradientAndHessian(const bool use_mwalkers_mpi) {
     Gradient(k).setValues( TargetDistAverages(k) - sampled_averages[k] );
     Hessian(k) = computeCovarianceFromAverages(k);
     Hessian(k) *= getBeta();
+    if(hessian_rank_>0) {
+      hessian_sketch_pntrs_[k]->finalize(sampled_averages[k],getBeta(),use_mwalkers_mpi ? &multi_sim_comm : NULL,walker_weight);
+    }
     //
     Gradient(k).activate();
     Hessian(k).activate();
@@ -450,6 +469,7 @@ void VesBias::updateGradientAndHessian(const bool use_mwalkers_mpi) {
       Gradient(k).clear();
       Hessian(k).deactivate();
       Hessian(k).clear();
+      if(hessian_rank_>0) {hessian_sketch_pntrs_[k]->clear();}
     }
     //
     std::fill(sampled_averages[k].begin(), sampled_averages[k].end(), 0.0);
@@ -471,10 +491,11 @@ void VesBias::multiSimSumAverages(const unsigned int c_id, const double walker_w
   }
   //
   if(comm.Get_rank()==0) {
-    multi_sim_comm.Sum(sampled_averages[c_id]);
-    multi_sim_comm.Sum(sampled_cross_averages[c_id]);
     double norm_weights = walker_weight;
-    multi_sim_comm.Sum(norm_weights);
+    multi_sim_comm.DeferSum(sampled_averages[c_id]);
+    multi_sim_comm.DeferSum(sampled_cross_averages[c_id]);
+    multi_sim_comm.DeferSum(norm_weights);
+    multi_sim_comm.SumDeferred();
     if(norm_weights>0.0) {norm_weights=1.0/norm_weights;}
     for(size_t i=0; i<sampled_averages[c_id].size(); i++) {
       sampled_averages[c_id][i] *= norm_weights;
@@ -516,6 +537,10 @@ void VesBias::addToSampledAverages(const std::vector<double>& values, const unsi
       }
     }
   }
+  // low-rank estimate of the off-diagonal part of the Hessian
+  if(hessian_rank_>0) {
+    hessian_sketch_pntrs_[c_id]->addSample(values);
+  }
   // NOTE: the MPI sum for sampled_averages and sampled_cross_averages is done later
   aver_counters[c_id] += 1;
 }
@@ -574,10 +599,21 @@ void VesBias::linkOptimizer(Optimizer* optimizer_pntr_in) {
 }
 
 
-void VesBias::enableHessian(const bool diagonal_hessian) {
+void VesBias::enableHessian(const bool diagonal_hessian, const unsigned int hessian_rank) {
+  plumed_massert(diagonal_hessian || hessian_rank==0,"a low-rank Hessian can only be used on top of the diagonal Hessian");
   compute_hessian_=true;
   diagonal_hessian_=diagonal_hessian;
+  hessian_rank_=hessian_rank;
   sampled_cross_averages.clear();
+  for(unsigned int i=0; i<hessian_sketch_pntrs_.size(); i++) {
+    delete hessian_sketch_pntrs_[i];
+  }
+  hessian_sketch_pntrs_.clear();
+  if(hessian_rank_>0) {
+    for(unsigned int i=0; i<ncoeffssets_; i++) {
+      hessian_sketch_pntrs_.push_back(new CovarianceSketch(numberOfCoeffs(i),hessian_rank_,comm));
+    }
+  }
   for (unsigned int i=0; i<ncoeffssets_; i++) {
     delete hessian_pntrs_[i];
     std::string label = getCoeffsSetLabelString("hessian",i);
@@ -593,7 +629,12 @@ void VesBias::enableHessian(const bool diagonal_hessian) {
 void VesBias::disableHessian() {
   compute_hessian_=false;
   diagonal_hessian_=true;
+  hessian_rank_=0;
   sampled_cross_averages.clear();
+  for(unsigned int i=0; i<hessian_sketch_pntrs_.size(); i++) {
+    delete hessian_sketch_pntrs_[i];
+  }
+  hessian_sketch_pntrs_.clear();
   for (unsigned int i=0; i<ncoeffssets_; i++) {
     delete hessian_pntrs_[i];
     std::string label = getCoeffsSetLabelString("hessian",i);
@@ -45,6 +45,7 @@ namespace ves {
 
 class CoeffsVector;
 class CoeffsMatrix;
+class CovarianceSketch;
 class BasisFunctions;
 class Optimizer;
 class TargetDistribution;
@@ -67,6 +68,7 @@ private:
   std::vector<CoeffsMatrix*> hessian_pntrs_;
   std::vector<std::vector<double> > sampled_averages;
   std::vector<std::vector<double> > sampled_cross_averages;
+  std::vector<CovarianceSketch*> hessian_sketch_pntrs_;
   bool use_multiple_coeffssets_;
   //
   std::vector<std::string> coeffs_fnames;
@@ -78,6 +80,7 @@ private:
   //
   bool compute_hessian_;
   bool diagonal_hessian_;
+  unsigned int hessian_rank_;
   //
   std::vector<unsigned int> aver_counters;
   //
@@ -170,6 +173,8 @@ public:
   CoeffsVector* getTargetDistAveragesPntr(const unsigned int coeffs_id = 0) const {return targetdist_averages_pntrs_[coeffs_id];}
   CoeffsVector* getGradientPntr(const unsigned int coeffs_id = 0)const {return gradient_pntrs_[coeffs_id];}
   CoeffsMatrix* getHessianPntr(const unsigned int coeffs_id = 0) const {return hessian_pntrs_[coeffs_id];}
+  // low-rank off-diagonal part of the Hessian, NULL if not used
+  CovarianceSketch* getHessianSketchPntr(const unsigned int coeffs_id = 0) const {return hessian_rank_>0 ? hessian_sketch_pntrs_[coeffs_id] : NULL;}
   //
   unsigned int getNumberOfTargetDistributionPntrs() const {return targetdist_pntrs_.size();}
   //
@@ -190,6 +195,7 @@ public:
   //
   bool computeHessian() const {return compute_hessian_;}
   bool diagonalHessian() const {return diagonal_hessian_;}
+  unsigned int getHessianRank() const {return hessian_rank_;}
   //
   bool optimizeCoeffs() const {return optimize_coeffs_;}
   Optimizer* getOptimizerPntr() const {return optimizer_pntr_;}
@@ -204,7 +210,7 @@ public:
   virtual void restartTargetDistributions() {};
   //
   void linkOptimizer(Optimizer*);
-  void enableHessian(const bool diagonal_hessian=true);
+  void enableHessian(const bool diagonal_hessian=true, const unsigned int hessian_rank=0);
   void disableHessian();
   //
   void enableMultipleCoeffsSets() {use_multiple_coeffssets_=true;}
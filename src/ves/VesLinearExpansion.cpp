@@ -365,6 +365,7 @@ VesLinearExpansion::VesLinearExpansion(const ActionOptions&ao):
   checkThatTemperatureIsGiven();
   bias_expansion_pntr_ = new LinearBasisSetExpansion(getLabel(),getBeta(),comm,args_pntrs,basisf_pntrs_,getCoeffsPntr());
   bias_expansion_pntr_->linkVesBias(this);
+  addMemoryUsage("expansion grids",[this]() {return bias_expansion_pntr_->getMemoryUsage();});
   bias_expansion_pntr_->setGridBins(this->getGridBins());
   //
 
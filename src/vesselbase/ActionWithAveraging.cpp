@@ -34,6 +34,8 @@ void ActionWithAveraging::registerKeywords( Keywords& keys ) {
            "of 0 implies that all the data will be used and that the grid will never be cleared");
   keys.add("optional","LOGWEIGHTS","list of actions that calculates log weights that should be used to weight configurations when calculating averages");
   keys.add("compulsory","NORMALIZATION","true","This controls how the data is normalized it can be set equal to true, false or ndata.  The differences between these options are explained in the manual page for \\ref HISTOGRAM");
+  keys.reserveFlag("WALKERS_MPI",false,"sum the data accumulated by all the replicas at the end of the calculation.  This can be used to combine the data "
+                   "from multiple walkers or from the processes of \\ref driver when it is run with --parallel-frames");
   keys.remove("NUMERICAL_DERIVATIVES");
 }
 
@@ -45,6 +47,7 @@ ActionWithAveraging::ActionWithAveraging( const ActionOptions& ao ):
   ActionWithValue(ao),
   ActionWithVessel(ao),
   myaverage(NULL),
+  walkers_mpi(false),
   useRunAllTasks(false),
   clearstride(0),
   lweight(0),cweight(0)
@@ -78,6 +81,13 @@ ActionWithAveraging::ActionWithAveraging( const ActionOptions& ao ):
     else if( normstr=="ndata" ) normalization=ndata;
     else error("invalid instruction for NORMALIZATION flag should be true, false, or ndata");
   }
+  if( keywords.exists("WALKERS_MPI") ) {
+    parseFlag("WALKERS_MPI",walkers_mpi);
+    if( walkers_mpi ) {
+      if( clearstride>0 ) error("cannot use WALKERS_MPI and CLEAR at the same time");
+      log.printf("  summing data from all replicas at the end of the calculation \n");
+    }
+  }
 }
 
 void ActionWithAveraging::setAveragingAction( AveragingVessel* av_vessel, const bool& usetasks ) {
@@ -129,6 +139,12 @@ void ActionWithAveraging::update() {
   }
 }
 
+void ActionWithAveraging::runFinalJobs() {
+  if( !walkers_mpi || !myaverage ) return;
+  myaverage->sumOverReplicas( comm, multi_sim_comm );
+  finishAveraging();
+}
+
 void ActionWithAveraging::clearAverage() { plumed_assert( myaverage->wasreset() ); myaverage->clear(); }
 
 void ActionWithAveraging::performOperations( const bool& from_update ) { plumed_error(); }
@@ -57,6 +57,8 @@ private:
   std::vector<Value*> weights;
 /// Are we accumulated the unormalized quantity
   enum {t,f,ndata} normalization;
+/// Is the data summed over all the replicas at the end of the calculation
+  bool walkers_mpi;
 protected:
 /// This ensures runAllTasks is used
   bool useRunAllTasks;
@@ -79,6 +81,10 @@ public:
 /// Overwrite ActionWithArguments getArguments() so that we don't return the bias
   std::vector<Value*> getArguments();
   void update();
+/// Sum the data over all the replicas if required
+  void runFinalJobs();
+/// Is the data summed over all the replicas at the end of the calculation
+  bool sumsOverReplicas() const { return walkers_mpi; }
 /// This does the clearing of the action
   virtual void clearAverage();
 /// This is done before the averaging comences
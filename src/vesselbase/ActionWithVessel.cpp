@@ -28,8 +28,10 @@
 #include "BridgeVessel.h"
 #include "FunctionVessel.h"
 #include "StoreDataVessel.h"
+#include "LoadBalancer.h"
 #include "tools/OpenMP.h"
 #include "tools/Stopwatch.h"
+#include <chrono>
 
 using namespace std;
 namespace PLMD {
@@ -45,6 +47,8 @@ void ActionWithVessel::registerKeywords(Keywords& keys) {
   keys.addFlag("SERIAL",false,"do the calculation in serial.  Do not parallelize");
   keys.addFlag("LOWMEM",false,"lower the memory requirements");
   keys.addFlag("TIMINGS",false,"output information on the timings of the various parts of the calculation");
+  keys.add("optional","BALANCE_STRIDE","divide the tasks between the processes and threads using the time taken to do each task.  The timings "
+           "are shared between the processes and the tasks redistributed every BALANCE_STRIDE steps");
   keys.reserveFlag("HIGHMEM",false,"use a more memory intensive version of this collective variable");
   keys.add( vesselRegister().getKeywords() );
 }
@@ -86,7 +90,28 @@ ActionWithVessel::ActionWithVessel(const ActionOptions&ao):
     log.printf(" Ignoring contributions less than %f \n",tolerance);
   }
   parseFlag("TIMINGS",timers);
+  if( keywords.exists("BALANCE_STRIDE") ) {
+    unsigned bstride=0; parse("BALANCE_STRIDE",bstride);
+    if( bstride>0 ) {
+      if( serial ) error("cannot use BALANCE_STRIDE with SERIAL");
+      balancer.reset( new LoadBalancer( bstride ) );
+      log.printf("  redistributing tasks between processes and threads using their cost every %u steps \n",bstride);
+    }
+  }
   stopwatch.start(); stopwatch.pause();
+  addMemoryUsage("task buffers",[this]() {
+    std::size_t m=(buffer.capacity()+tmpforces.capacity())*sizeof(double)
+                  +(fullTaskList.capacity()+indexOfTaskInFullList.capacity()+partialTaskList.capacity()
+                    +der_list.capacity()+taskFlags.capacity())*sizeof(unsigned);
+    for(const auto & v : thread_vals) m+=v.getMemoryUsage();
+    for(const auto & b : thread_buffers) m+=b.capacity()*sizeof(double);
+    return m;
+  });
+  addMemoryUsage("vessels",[this]() {
+    std::size_t m=0;
+    for(const auto & f : functions) m+=f->getMemoryUsage();
+    return m;
+  });
 }
 
 ActionWithVessel::~ActionWithVessel() {
@@ -96,6 +121,7 @@ ActionWithVessel::~ActionWithVessel() {
     log.printf("timings for action %s with label %s \n", getName().c_str(), getLabel().c_str() );
     log<<stopwatch;
   }
+  if( balancer ) balancer->printStatistics( log );
 }
 
 void ActionWithVessel::addVessel( const std::string& name, const std::string& input, const int numlab ) {
@@ -250,6 +276,53 @@ unsigned ActionWithVessel::getSizeOfBuffer( unsigned& bufsize ) {
   return bufsize;
 }
 
+void ActionWithVessel::runTask( const unsigned& i, MultiValue& myvals, MultiValue& bvals, std::vector<double>& mybuffer ) {
+  // Calculate the stuff in the loop for this action
+  performTask( indexOfTaskInFullList[i], partialTaskList[i], myvals );
+
+  // Check for conditions that allow us to just to skip the calculation
+  // the condition is that the weight of the contribution is low
+  // N.B. Here weights are assumed to be between zero and one
+  if( myvals.get(0)<tolerance ) {
+    // Clear the derivatives
+    myvals.clearAll();
+    return;
+  }
+
+  // Now calculate all the functions
+  // If the contribution of this quantity is very small at neighbour list time ignore it
+  // untill next neighbour list time
+  calculateAllVessels( indexOfTaskInFullList[i], myvals, bvals, mybuffer, der_list );
+
+  // Clear the value
+  myvals.clearAll();
+}
+
+unsigned ActionWithVessel::getNumberOfThreadsForTasks( const unsigned& stride ) const {
+  unsigned nt=OpenMP::getNumThreads();
+  if( nt*stride*10>nactive_tasks ) nt=nactive_tasks/stride/10;
+  if( nt==0 || !threadSafe() ) nt=1;
+  return nt;
+}
+
+void ActionWithVessel::getTasksDoneByThisProcess( std::vector<unsigned>& mycodes ) {
+  unsigned stride=comm.Get_size();
+  unsigned rank=comm.Get_rank();
+  if(serial) { stride=1; rank=0; }
+  unsigned nt=getNumberOfThreadsForTasks( stride );
+
+  mycodes.resize(0);
+  if( balancer && stride*nt>1 ) {
+    // The partition only changes when the costs are updated at the end of runAllTasks
+    // so this gives the same blocks that are used in the loop over tasks
+    balancer->setNumberOfTasks( fullTaskList.size() );
+    balancer->partition( indexOfTaskInFullList, nactive_tasks, stride*nt, part_bounds );
+    for(unsigned i=part_bounds[rank*nt]; i<part_bounds[(rank+1)*nt]; ++i) mycodes.push_back( partialTaskList[i] );
+  } else {
+    for(unsigned i=rank; i<nactive_tasks; i+=stride) mycodes.push_back( partialTaskList[i] );
+  }
+}
+
 void ActionWithVessel::runAllTasks() {
   plumed_massert( !contributorsAreUnlocked && functions.size()>0, "you must have a call to readVesselKeywords somewhere" );
   unsigned stride=comm.Get_size();
@@ -262,9 +335,7 @@ void ActionWithVessel::runAllTasks() {
   if(timers) stopwatch.stop("1 Prepare Tasks");
 
   // Get number of threads for OpenMP
-  unsigned nt=OpenMP::getNumThreads();
-  if( nt*stride*10>nactive_tasks ) nt=nactive_tasks/stride/10;
-  if( nt==0 || !threadSafe() ) nt=1;
+  unsigned nt=getNumberOfThreadsForTasks( stride );
 
   // Get size for buffer
   unsigned bsize=0, bufsize=getSizeOfBuffer( bsize );
@@ -278,45 +349,57 @@ void ActionWithVessel::runAllTasks() {
   // Build storage stuff for loop
   // std::vector<double> buffer( bufsize, 0.0 );
 
+  // Divide the tasks into blocks of similar cost if we are balancing the load
+  bool usebalancer=( balancer && stride*nt>1 );
+  if( usebalancer ) {
+    balancer->setNumberOfTasks( fullTaskList.size() );
+    balancer->partition( indexOfTaskInFullList, nactive_tasks, stride*nt, part_bounds );
+  }
+
+  // Storage for the threads is only created again if its size has changed
+  unsigned nq=getNumberOfQuantities(), nder=getNumberOfDerivatives();
+  if( thread_vals.size()<2*nt || thread_vals[0].getNumberOfValues()!=nq || thread_vals[0].getNumberOfDerivatives()!=nder ) {
+    thread_vals.assign( 2*nt, MultiValue( nq, nder ) );
+  }
+  if( thread_buffers.size()<nt ) thread_buffers.resize( nt );
+  // All the buffers are cleared here since the runtime might start fewer than nt threads,
+  // and the buffers of the threads that do not run are summed anyway below
+  if( nt>1 ) for(unsigned j=0; j<nt; ++j) thread_buffers[j].assign( bufsize, 0.0 );
+
   if(timers) stopwatch.start("2 Loop over tasks");
   #pragma omp parallel num_threads(nt)
   {
-    std::vector<double> omp_buffer;
-    if( nt>1 ) omp_buffer.resize( bufsize, 0.0 );
-    MultiValue myvals( getNumberOfQuantities(), getNumberOfDerivatives() );
-    MultiValue bvals( getNumberOfQuantities(), getNumberOfDerivatives() );
+    unsigned t=OpenMP::getThreadNum();
+    std::vector<double>& omp_buffer( thread_buffers[t] );
+    MultiValue& myvals( thread_vals[2*t] );
+    MultiValue& bvals( thread_vals[2*t+1] );
     myvals.clearAll(); bvals.clearAll();
 
-    #pragma omp for nowait
-    for(unsigned i=rank; i<nactive_tasks; i+=stride) {
-      // Calculate the stuff in the loop for this action
-      performTask( indexOfTaskInFullList[i], partialTaskList[i], myvals );
-
-      // Check for conditions that allow us to just to skip the calculation
-      // the condition is that the weight of the contribution is low
-      // N.B. Here weights are assumed to be between zero and one
-      if( myvals.get(0)<tolerance ) {
-        // Clear the derivatives
-        myvals.clearAll();
-        continue;
-      }
-
-      // Now calculate all the functions
-      // If the contribution of this quantity is very small at neighbour list time ignore it
-      // untill next neighbour list time
-      if( nt>1 ) {
-        calculateAllVessels( indexOfTaskInFullList[i], myvals, bvals, omp_buffer, der_list );
-      } else {
-        calculateAllVessels( indexOfTaskInFullList[i], myvals, bvals, buffer, der_list );
+    std::vector<double>& mybuffer=( nt>1 ? omp_buffer : buffer );
+    if( usebalancer ) {
+      #pragma omp for schedule(static,1) nowait
+      for(unsigned p=0; p<nt; ++p) {
+        unsigned part=rank*nt + p;
+        for(unsigned i=part_bounds[part]; i<part_bounds[part+1]; ++i) {
+          auto t0=std::chrono::steady_clock::now();
+          runTask( i, myvals, bvals, mybuffer );
+          std::chrono::duration<double> dt=std::chrono::steady_clock::now() - t0;
+          balancer->addTime( indexOfTaskInFullList[i], part, dt.count() );
+        }
       }
-
-      // Clear the value
-      myvals.clearAll();
+    } else {
+      #pragma omp for nowait
+      for(unsigned i=rank; i<nactive_tasks; i+=stride) runTask( i, myvals, bvals, mybuffer );
+    }
+    // The buffers of the threads are merged by all the threads, each of them summing a block of elements
+    if(nt>1) {
+      #pragma omp barrier
+      #pragma omp for
+      for(unsigned i=0; i<bufsize; ++i) for(unsigned j=0; j<nt; ++j) buffer[i]+=thread_buffers[j][i];
     }
-    #pragma omp critical
-    if(nt>1) for(unsigned i=0; i<bufsize; ++i) buffer[i]+=omp_buffer[i];
   }
   if(timers) stopwatch.stop("2 Loop over tasks");
+  if( usebalancer ) balancer->update( comm, serial, indexOfTaskInFullList, nactive_tasks );
   // Turn back on derivative calculation
   dertime=true;
 
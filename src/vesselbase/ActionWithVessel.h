@@ -28,6 +28,7 @@
 #include "tools/DynamicList.h"
 #include "tools/MultiValue.h"
 #include <vector>
+#include <memory>
 #include "tools/ForwardDecl.h"
 
 namespace PLMD {
@@ -39,6 +40,7 @@ namespace vesselbase {
 class Vessel;
 class BridgeVessel;
 class StoreDataVessel;
+class LoadBalancer;
 
 /**
 \ingroup MULTIINHERIT
@@ -85,6 +87,10 @@ private:
   std::vector<unsigned> der_list;
 /// The buffer that we use (we keep a copy here to avoid resizing)
   std::vector<double> buffer;
+/// The MultiValues and the buffers used by each thread in the loop over tasks
+/// (we keep them from one step to the next to avoid allocating them at every step)
+  std::vector<MultiValue> thread_vals;
+  std::vector<std::vector<double> > thread_buffers;
 /// Do we want to output information on the timings of different parts of the calculation
   bool timers;
   ForwardDecl<Stopwatch> stopwatch_fwd;
@@ -92,6 +98,14 @@ private:
   Stopwatch& stopwatch=*stopwatch_fwd;
 /// These are used to minmise computational expense in complex functions
   bool dertime_can_be_off;
+/// This divides the tasks between processes and threads using their measured cost
+  std::unique_ptr<LoadBalancer> balancer;
+/// The first task done by each process and thread when the load balancer is used
+  std::vector<unsigned> part_bounds;
+/// Get the number of OpenMP threads that are used to do the tasks
+  unsigned getNumberOfThreadsForTasks( const unsigned& stride ) const ;
+/// Do one task and add its contribution to the vessels
+  void runTask( const unsigned& i, MultiValue& myvals, MultiValue& bvals, std::vector<double>& mybuffer );
 protected:
 /// This is also used to minimise computational expense in complex functions
   bool dertime;
@@ -105,6 +119,8 @@ protected:
   StoreDataVessel* mydata;
 /// This list is used to update the neighbor list
   std::vector<unsigned> taskFlags;
+/// Get the codes of the active tasks that this process will do when runAllTasks is called
+  void getTasksDoneByThisProcess( std::vector<unsigned>& mycodes );
 /// Add a vessel to the list of vessels
   void addVessel( const std::string& name, const std::string& input, const int numlab=0 );
   void addVessel( Vessel* vv );
@@ -21,6 +21,7 @@
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 #include "AveragingVessel.h"
 #include "ActionWithAveraging.h"
+#include "tools/Communicator.h"
 
 namespace PLMD {
 namespace vesselbase {
@@ -35,6 +36,7 @@ AveragingVessel::AveragingVessel( const vesselbase::VesselOptions& vo ):
 {
   ActionWithAveraging* myav = dynamic_cast<ActionWithAveraging*>( getAction() );
   plumed_assert( myav ); unormalised = myav->noNormalization();
+  bycount = ( myav->normalization==ActionWithAveraging::ndata );
 }
 
 void AveragingVessel::finish( const std::vector<double>& buffer ) {
@@ -53,6 +55,12 @@ void AveragingVessel::reset() {
   wascleared=true;
 }
 
+void AveragingVessel::sumOverReplicas( Communicator& comm, Communicator& multi_sim_comm ) {
+  // Only the root of each replica communicates with the other replicas
+  if( comm.Get_rank()==0 ) multi_sim_comm.Sum( data );
+  comm.Bcast( data, 0 );
+}
+
 void AveragingVessel::setDataSize( const unsigned& size ) {
   if( data.size()!=(1+size) ) data.resize( 1+size, 0 );
 }
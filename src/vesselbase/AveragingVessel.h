@@ -33,6 +33,8 @@ private:
   bool wascleared;
 /// Are we outputting unormalised data
   bool unormalised;
+/// Is the data normalised by the number of samples (NORMALIZATION=ndata)
+  bool bycount;
 /// The data that is being averaged
   std::vector<double> data;
 protected:
@@ -46,6 +48,10 @@ protected:
   double getDataElement( const unsigned& myelem ) const ;
 /// Are we averaging the data
   bool noAverage() const { return unormalised; }
+/// Are we dividing by the number of samples rather than by the sum of the weights
+  bool countNormalization() const { return bycount; }
+/// Record that data has been added by a derived class that does not use the data array
+  void dataWasAdded() { wascleared=false; }
 public:
 /// keywords
   static void registerKeywords( Keywords& keys );
@@ -62,7 +68,11 @@ public:
 /// Functions for dealing with normalisation constant
   void setNorm( const double& snorm );
   double getNorm() const ;
+/// Sum the accumulated data over all the replicas
+  virtual void sumOverReplicas( Communicator& comm, Communicator& multi_sim_comm );
   virtual bool applyForce(  std::vector<double>& forces ) { return false; }
+/// Get the memory allocated for the averaged data (bytes)
+  virtual std::size_t getMemoryUsage() const { return data.capacity()*sizeof(double); }
 };
 
 inline
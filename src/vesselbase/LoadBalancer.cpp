@@ -0,0 +1,114 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2018 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "LoadBalancer.h"
+#include "tools/Communicator.h"
+#include "tools/Exception.h"
+#include "tools/Log.h"
+#include <algorithm>
+
+namespace PLMD {
+namespace vesselbase {
+
+LoadBalancer::LoadBalancer( const unsigned& s ):
+  stride(s),
+  nsteps(0),
+  nsync(0),
+  imbalance_sum(0),
+  imbalance_max(0),
+  block_sum(0),
+  cyclic_sum(0)
+{
+  plumed_assert( stride>0 );
+}
+
+void LoadBalancer::setNumberOfTasks( const unsigned& ntasks ) {
+  if( cost.size()==ntasks ) return;
+  cost.assign( ntasks, 0.0 ); time.assign( ntasks, 0.0 ); count.assign( ntasks, 0.0 );
+}
+
+double LoadBalancer::getImbalance( const std::vector<double>& load ) {
+  double tot=0, maxload=0;
+  for(unsigned i=0; i<load.size(); ++i) { tot+=load[i]; maxload=std::max( maxload, load[i] ); }
+  if( tot==0 ) return 1.0;
+  return maxload*load.size() / tot;
+}
+
+void LoadBalancer::partition( const std::vector<unsigned>& indices, const unsigned& nactive, const unsigned& nparts, std::vector<unsigned>& bounds ) {
+  plumed_dbg_assert( nparts>0 && nactive<=indices.size() );
+  if( parttime.size()!=nparts ) parttime.assign( nparts, 0.0 );
+  // Tasks that have never been timed are assumed to take the average time
+  double known=0, nknown=0;
+  for(unsigned i=0; i<nactive; ++i) {
+    if( cost[indices[i]]>0 ) { known+=cost[indices[i]]; nknown++; }
+  }
+  double unknown=( nknown>0 ? known / nknown : 1.0 );
+  double total=known + (nactive-nknown)*unknown;
+
+  // Divide the tasks into contiguous blocks with the same cost
+  bounds.resize( nparts+1 ); bounds[0]=0;
+  double sum=0; unsigned p=1;
+  for(unsigned i=0; i<nactive && p<nparts; ++i) {
+    double c=cost[indices[i]]; if( c==0 ) c=unknown;
+    // Task i goes in the block where the midpoint of its cost lies
+    while( p<nparts && sum+0.5*c>=p*total/nparts ) { bounds[p]=i; p++; }
+    sum+=c;
+  }
+  for(; p<=nparts; ++p) bounds[p]=nactive;
+}
+
+void LoadBalancer::addTime( const unsigned& index, const unsigned& part, const double& t ) {
+  plumed_dbg_assert( index<time.size() && part<parttime.size() );
+  time[index]+=t; count[index]+=1.0; parttime[part]+=t;
+}
+
+void LoadBalancer::update( Communicator& comm, const bool& serial, const std::vector<unsigned>& indices, const unsigned& nactive ) {
+  nsteps++; if( nsteps<stride ) return;
+  nsteps=0;
+  if( !serial ) { comm.Sum( time ); comm.Sum( count ); comm.Sum( parttime ); }
+  for(unsigned i=0; i<cost.size(); ++i) {
+    if( count[i]>0 ) cost[i]=time[i]/count[i];
+  }
+  time.assign( time.size(), 0.0 ); count.assign( count.size(), 0.0 );
+
+  // Measured imbalance and the imbalance that the costs predict for the blocks and for a cyclic distribution of tasks
+  double imb=getImbalance( parttime ); unsigned nparts=parttime.size();
+  std::vector<unsigned> bounds; partition( indices, nactive, nparts, bounds );
+  std::vector<double> blocks( nparts, 0.0 ), cyclic( nparts, 0.0 );
+  for(unsigned p=0; p<nparts; ++p) {
+    for(unsigned i=bounds[p]; i<bounds[p+1]; ++i) blocks[p]+=cost[indices[i]];
+  }
+  for(unsigned i=0; i<nactive; ++i) cyclic[i%nparts]+=cost[indices[i]];
+  nsync++; imbalance_sum+=imb; imbalance_max=std::max( imbalance_max, imb );
+  block_sum+=getImbalance( blocks ); cyclic_sum+=getImbalance( cyclic );
+  parttime.assign( nparts, 0.0 );
+}
+
+void LoadBalancer::printStatistics( Log& log ) const {
+  if( nsync==0 ) return;
+  log.printf("  load imbalance (largest/average time per process and thread) over %u measurements : average %f maximum %f \n",
+             nsync, imbalance_sum/nsync, imbalance_max );
+  log.printf("  average imbalance estimated from the cost of each task : %f with balanced blocks and %f with cyclic distribution of tasks \n",
+             block_sum/nsync, cyclic_sum/nsync );
+}
+
+}
+}
@@ -0,0 +1,81 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2018 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_vesselbase_LoadBalancer_h
+#define __PLUMED_vesselbase_LoadBalancer_h
+
+#include <vector>
+
+namespace PLMD {
+
+class Communicator;
+class Log;
+
+namespace vesselbase {
+
+/// \ingroup TOOLBOX
+/// This class is used by ActionWithVessel to divide the list of active tasks between
+/// the MPI processes and the OpenMP threads in a way that takes into account how long
+/// each task takes.  The time taken to do each task is measured locally and the measurements
+/// are shared between the processes every few steps.  The active tasks are then divided
+/// into contiguous blocks that should all take the same amount of time.
+class LoadBalancer {
+private:
+/// Number of calls to update between the times when timings are shared
+  unsigned stride;
+/// Number of calls to update since the timings were last shared
+  unsigned nsteps;
+/// The estimate of the cost of each task.  This is zero for tasks that have never been timed
+  std::vector<double> cost;
+/// Time spent doing each task since the timings were last shared
+  std::vector<double> time;
+/// Number of times each task was done since the timings were last shared
+  std::vector<double> count;
+/// Time spent on each part since the timings were last shared
+  std::vector<double> parttime;
+/// The number of times the timings have been shared
+  unsigned nsync;
+/// Sum and maximum of the ratio between the largest and the average time spent on each part
+  double imbalance_sum, imbalance_max;
+/// Sums of the same ratio as estimated from the costs of the tasks for the blocks
+/// and for the case where the tasks are distributed cyclically
+  double block_sum, cyclic_sum;
+/// Get the ratio between the largest and the average load of a set of parts
+  static double getImbalance( const std::vector<double>& load );
+public:
+  explicit LoadBalancer( const unsigned& stride );
+/// Set the total number of tasks.  The stored costs are discarded if this number changes
+  void setNumberOfTasks( const unsigned& ntasks );
+/// Divide the active tasks into nparts blocks.  indices gives the indices of the active
+/// tasks in the full list of tasks.  Part p does the tasks from bounds[p] to bounds[p+1]-1
+  void partition( const std::vector<unsigned>& indices, const unsigned& nactive, const unsigned& nparts, std::vector<unsigned>& bounds );
+/// Record the time taken to do a task.  Each task should only be done by one thread.
+  void addTime( const unsigned& index, const unsigned& part, const double& t );
+/// This is called after all the tasks have been done.  The timings are shared between the
+/// processes every stride calls and the estimates of the costs of the tasks are updated
+  void update( Communicator& comm, const bool& serial, const std::vector<unsigned>& indices, const unsigned& nactive );
+/// Write the statistics on the imbalance between the parts to the log
+  void printStatistics( Log& log ) const ;
+};
+
+}
+}
+#endif
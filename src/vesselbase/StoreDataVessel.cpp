@@ -43,6 +43,12 @@ void StoreDataVessel::addActionThatUses( ActionWithVessel* actionThatUses ) {
   userActions.push_back( actionThatUses );
 }
 
+std::size_t StoreDataVessel::getMemoryUsage() const {
+  std::size_t m=local_buffer.capacity()*sizeof(double)+active_der.capacity()*sizeof(unsigned);
+  for(const auto & v : my_tmp_vals) m+=v.getMemoryUsage();
+  return m;
+}
+
 void StoreDataVessel::resize() {
   if( getAction()->lowmem || !getAction()->derivativesAreRequired() ) {
     nspace = 1;
@@ -123,6 +123,8 @@ public:
   virtual void activateIndices( ActionWithVessel* ) {}
 /// Forces on vectors should always be applied elsewhere
   virtual bool applyForce(std::vector<double>&) { return false; }
+/// Get the memory allocated for the stored data (bytes)
+  std::size_t getMemoryUsage() const ;
 ///  Get the number of data users
   unsigned getNumberOfDataUsers() const ;
 /// Get one of the ith data user
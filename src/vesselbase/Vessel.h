@@ -155,6 +155,8 @@ public:
   virtual void resize()=0;
 /// Retrieve the forces on the quantities in the vessel
   virtual bool applyForce( std::vector<double>& forces )=0;
+/// Get the memory allocated for the data stored in the vessel (bytes)
+  virtual std::size_t getMemoryUsage() const { return 0; }
 };
 
 template<class T>
@@ -0,0 +1,19 @@
+# Writes the COLVAR, HILLS and PDB files that are read by plumed.dat, 20000 lines each
+awk 'BEGIN{
+  print "#! FIELDS time d1 d2 bias";
+  for(i=0;i<20000;i++) printf(" %f %f %f %f\n",0.002*i,1.0+0.001*i,-0.5e-3*i,0.1234567*i);
+}' > COLVAR
+awk 'BEGIN{
+  pi=atan2(0,-1);
+  print "#! FIELDS time t1 t2 sigma_t1 sigma_t2 height biasf";
+  print "#! SET multivariate false";
+  print "#! SET min_t1 -pi";
+  print "#! SET max_t1 pi";
+  print "#! SET min_t2 -pi";
+  print "#! SET max_t2 pi";
+  for(i=0;i<20000;i++) printf(" %20.16f %20.16f %20.16f %20.16f %20.16f %20.16f %20.16f\n",0.002*i,-pi+0.0001*i,pi-0.0002*i,0.35,0.35,1.2,10);
+}' > HILLS
+awk 'BEGIN{
+  for(i=0;i<20000;i++) printf("ATOM  %5d  OW  SOL  %4d    %8.3f%8.3f%8.3f  1.00  0.00\n",i%100000+1,i%10000+1,0.01*(i%1000),0.02*(i%500),0.03*(i%300));
+  print "END";
+}' > conf.pdb